@@ -22,6 +22,32 @@
 #define SHOW_METHOD_RETURN_TYPES        YES
 #define SHOW_VARIABLE_TYPES             YES
 #define SHOW_RETURN_STATEMENTS          YES
+#define DONT_STREAM_OUTPUT              NO
+#define DONT_PARALLELIZE                NO
+#define DONT_PRINT_GRAPHS               NoGraph
+#define DONT_COMPRESS_OUTPUT            NO
+
+// -cache. Bump RESULT_CACHE_VERSION along with CFBundleVersion, or whenever
+// the output changes.
+#define RESULT_CACHE_VERSION            "otx 0.17 (566)"
+#define RESULT_CACHE_DEFAULT_SIZE       1024    // megabytes
+#define RESULT_CACHE_KEY_LENGTH         64      // hex SHA-256
+#define RESULT_CACHE_SUFFIX             ".out"
+#define RESULT_CACHE_TEMP_PREFIX        "tmp."
+#define RESULT_CACHE_LOCK_FILE          "lock"
+#define RESULT_CACHE_STALE_TEMP         (24 * 60 * 60)  // seconds
+
+/*  CacheEntryInfo
+
+    One file in the -cache directory, see trimResultCache.
+*/
+typedef struct
+{
+    time_t      lastUsed;
+    off_t       size;
+    char        name[RESULT_CACHE_KEY_LENGTH + 8];
+}
+CacheEntryInfo;
 
 // ============================================================================
 
@@ -35,6 +61,10 @@
     BOOL                iVerify;
     BOOL                iShowProgress;
     ProcOptions         iOpts;
+    char*               iQueryIndexPath;        // -query
+    char*               iQueryName;
+    char*               iCachePath;             // -cache
+    UInt64              iCacheMaxSize;          // -cache-size, in bytes
 }
 
 - (id)initWithArgs: (char**)argv
@@ -42,8 +72,29 @@
 - (void)usage;
 - (void)processFile;
 - (void)verifyNops;
+- (void)queryXrefs;
+- (BOOL)resultCacheKey: (char*)outKey;
+- (BOOL)copyToStdout: (int)inFD;
+- (BOOL)printCachedResult: (const char*)inKey;
+- (void)saveCachedResult: (const char*)inTempPath
+                     key: (const char*)inKey;
+- (void)trimResultCache;
 - (void)newPackageFile: (NSURL*)inPackageFile;
 - (void)newOFile: (NSURL*)inOFile
        needsPath: (BOOL)inNeedsPath;
 
 @end
+
+// ----------------------------------------------------------------------------
+// Comparison functions for qsort(3)
+
+static int
+CacheEntry_Compare_LastUsed(
+    CacheEntryInfo* e1,
+    CacheEntryInfo* e2)
+{
+    if (e1->lastUsed < e2->lastUsed)
+        return -1;
+
+    return (e1->lastUsed > e2->lastUsed);
+}
@@ -73,9 +73,14 @@
         SHOW_METHOD_RETURN_TYPES,
         SHOW_VARIABLE_TYPES,
         SHOW_RETURN_STATEMENTS,
+        DONT_STREAM_OUTPUT,
+        DONT_PARALLELIZE,
+        DONT_PRINT_GRAPHS,
         0
     };
 
+    iCacheMaxSize   = (UInt64)RESULT_CACHE_DEFAULT_SIZE * 1024 * 1024;
+
     // Parse options.
     NSString*   origFilePath    = nil;
     uint32_t      i, j;
@@ -117,6 +122,155 @@
             {
                 iOpts.debugMode = YES;
             }
+            else if (!strncmp(&argv[i][1], "xref", 5))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iOpts.xrefIndexPath = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "demangle-cache", 15))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iOpts.demangleCachePath = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "cache", 6))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iCachePath  = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "cache-size", 11))
+            {
+                char*   sizeString  = (i + 1 < argc) ? argv[++i] : "";
+                char*   endPtr      = NULL;
+                UInt64  megabytes   = strtoull(sizeString, &endPtr, 10);
+
+                if (!*sizeString || *endPtr != '\0')
+                {
+                    fprintf(stderr, "otx: bad cache size: \"%s\"\n", sizeString);
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iCacheMaxSize   = megabytes * 1024 * 1024;
+            }
+            else if (!strncmp(&argv[i][1], "sha256", 7))
+            {
+                iOpts.sha256Checksum    = YES;
+            }
+            else if (!strncmp(&argv[i][1], "toc", 4))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iOpts.tocPath   = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "incremental", 12))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iOpts.incrementalPath   = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "split", 6))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iOpts.splitPath = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "records", 8))
+            {
+                char*   formatString    = (i + 1 < argc) ? argv[++i] : "";
+
+                if (!strncmp(formatString, "jsonl", 6))
+                    iOpts.recordFormat  = JSONLRecords;
+                else if (!strncmp(formatString, "columnar", 9))
+                    iOpts.recordFormat  = ColumnarRecords;
+                else
+                {
+                    fprintf(stderr, "otx: unknown record format: \"%s\"\n",
+                        formatString);
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+            }
+            else if (!strncmp(&argv[i][1], "query", 6))
+            {
+                if (i + 2 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iQueryIndexPath = argv[++i];
+                iQueryName      = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "f", 2))
+            {
+                if (i + 1 >= argc)
+                {
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+
+                iOpts.functionName  = argv[++i];
+            }
+            else if (!strncmp(&argv[i][1], "a", 2))
+            {
+                char*   rangeString = (i + 1 < argc) ? argv[++i] : NULL;
+                char*   endPtr      = NULL;
+
+                if (rangeString)
+                {
+                    iOpts.rangeStart    = strtoull(rangeString, &endPtr, 16);
+
+                    if (*endPtr == '-')
+                        iOpts.rangeEnd  = strtoull(endPtr + 1, &endPtr, 16);
+                }
+
+                if (!rangeString || *endPtr != '\0' ||
+                    iOpts.rangeEnd <= iOpts.rangeStart)
+                {
+                    fprintf(stderr, "otx: bad address range: \"%s\"\n",
+                        (rangeString) ? rangeString : "");
+                    [self usage];
+                    [self release];
+                    return nil;
+                }
+            }
             else
             {
                 for (j = 1; argv[i][j] != '\0'; j++)
@@ -156,6 +310,21 @@
                         case 'v':
                             iOpts.variableTypes = !SHOW_VARIABLE_TYPES;
                             break;
+                        case 's':
+                            iOpts.streamOutput = !DONT_STREAM_OUTPUT;
+                            break;
+                        case 'j':
+                            iOpts.parallelize = !DONT_PARALLELIZE;
+                            break;
+                        case 'z':
+                            iOpts.compressOutput = !DONT_COMPRESS_OUTPUT;
+                            break;
+                        case 'g':
+                            iOpts.graphFormat = DOTGraph;
+                            break;
+                        case 'G':
+                            iOpts.graphFormat = JSONGraph;
+                            break;
                         case 'p':
                             iShowProgress = YES;
                             break;
@@ -180,6 +349,44 @@
         }
     }
 
+    // Queries don't need an executable.
+    if (iQueryIndexPath)
+        return self;
+
+    // Only whole listings are split, the others go to stdout.
+    if (iOpts.splitPath && (iOpts.functionName || iOpts.rangeEnd ||
+        iOpts.graphFormat || iOpts.streamOutput))
+    {
+        fprintf(stderr, "otx: -split is ignored with -f, -a, -g, -G and -s\n");
+        iOpts.splitPath = NULL;
+    }
+
+    // Only whole, serial runs save and reuse -incremental state.
+    if (iOpts.incrementalPath && (iOpts.functionName || iOpts.rangeEnd ||
+        iOpts.graphFormat || iOpts.streamOutput || iOpts.parallelize ||
+        iOpts.recordFormat || iOpts.xrefIndexPath || iOpts.splitPath))
+    {
+        fprintf(stderr, "otx: -incremental is ignored with -f, -a, -g, -G, -s, "
+            "-j, -records, -xref and -split\n");
+        iOpts.incrementalPath   = NULL;
+    }
+
+    // Only listings get a table of contents.
+    if (iOpts.tocPath && (iOpts.graphFormat || iOpts.splitPath ||
+        iOpts.recordFormat))
+    {
+        fprintf(stderr, "otx: -toc is ignored with -g, -G, -split and "
+            "-records\n");
+        iOpts.tocPath   = NULL;
+    }
+
+    // With -n, there's nothing to save in or load from a demangle cache.
+    if (iOpts.demangleCachePath && !iOpts.demangleCppNames)
+    {
+        fprintf(stderr, "otx: -demangle-cache is ignored with -n\n");
+        iOpts.demangleCachePath = NULL;
+    }
+
     if (!origFilePath)
     {
         fprintf(stderr, "You must specify an executable file to process.\n");
@@ -300,22 +507,58 @@
 - (void)usage
 {
     fprintf(stderr,
-        "Usage: otx [-bcdelmnoprv] [-arch <arch type>] <object file>\n"
+        "Usage: otx [-bcdegGjlmnoprsvz] [-arch <arch type>] [-xref <index file>]\n"
+        "           [-demangle-cache <cache file>] [-f <function> | -a <start>-<end>]\n"
+        "           [-records jsonl | columnar] [-toc <toc file>] [-split <dir>]\n"
+        "           [-sha256] [-cache <dir> [-cache-size <megabytes>]]\n"
+        "           [-incremental <state file>]\n"
+        "           <object file>\n"
+        "       otx -query <index file> <name>\n"
         "\t-b             separate logical blocks\n"
-        "\t-c             don't show md5 checksum\n"
+        "\t-c             don't show md5 checksums\n"
         "\t-C             don't show binary code\n"
         "\t-d             show data sections\n"
         "\t-e             don't entab output\n"
+        "\t-g             print control flow graphs in DOT format\n"
+        "\t-G             print control flow graphs as JSON, one function per line\n"
+        "\t-j             process functions in parallel on all cores\n"
         "\t-l             don't show local offsets\n"
         "\t-m             don't show verbose objc_msgSend\n"
         "\t-n             don't demangle C++ symbol names\n"
         "\t-o             only check the executable for obfuscation\n"
         "\t-p             display progress\n"
         "\t-r             don't show Obj-C method return types\n"
+        "\t-s             stream output one function at a time to save memory\n"
         "\t-v             don't show Obj-C member variable types\n"
+        "\t-z             gzip the output, except graphs\n"
         "\t-arch archVal  specify a single architecture in a universal binary\n"
         "\t               if not specified, the host architecture is used\n"
         "\t               allowed values: ppc, ppc64, i386, x86_64\n"
+        "\t-sha256        also show sha256 checksums\n"
+        "\t-xref file     also write an index of call sites and message sends\n"
+        "\t-demangle-cache file\n"
+        "\t               reuse and add to C++ names demangled by earlier runs\n"
+        "\t-records jsonl print one JSON record per function and instruction\n"
+        "\t-records columnar\n"
+        "\t               print the same records as binary columns\n"
+        "\t-toc file      also write each function's address range and offset\n"
+        "\t               in the output\n"
+        "\t-split dir     write each Obj-C class and each other function to its\n"
+        "\t               own file under dir, listed in dir/manifest.txt\n"
+        "\t-cache dir     reuse output saved in dir by earlier runs with the same\n"
+        "\t               executable and options, and save this run's output\n"
+        "\t-cache-size mb delete the least recently used output from the -cache\n"
+        "\t               dir when it grows past mb megabytes, default %d\n"
+        "\t-incremental file\n"
+        "\t               reuse the analysis of functions unchanged since the\n"
+        "\t               run that saved file, then save this run's to it\n"
+        "\t-f name        only analyze and print the function 'name'\n"
+        "\t-a start-end   only analyze and print the functions overlapping the\n"
+        "\t               hex address range [start, end)\n"
+        "\t-query file name\n"
+        "\t               list the call sites of the function or selector 'name'\n"
+        "\t               from an index written by -xref\n",
+        RESULT_CACHE_DEFAULT_SIZE
     );
 }
 
@@ -389,6 +632,12 @@
 
 - (void)processFile
 {
+    if (iQueryIndexPath)
+    {
+        [self queryXrefs];
+        return;
+    }
+
     if (!iOFile)
     {
         fprintf(stderr, "otx: [CLIController processFile]: "
@@ -402,6 +651,25 @@
         return;
     }
 
+    // Side files can't be replayed from the cache, only stdout.
+    char    cacheKey[RESULT_CACHE_KEY_LENGTH + 1];
+    BOOL    useCache    = NO;
+
+    if (iCachePath)
+    {
+        if (iOpts.xrefIndexPath || iOpts.tocPath || iOpts.splitPath ||
+            iOpts.incrementalPath)
+            fprintf(stderr, "otx: -cache is ignored with -xref, -toc, -split "
+                "and -incremental\n");
+        else if (mkdir(iCachePath, 0755) != 0 && errno != EEXIST)
+            perror("otx: unable to create cache directory");
+        else
+            useCache    = [self resultCacheKey: cacheKey];
+    }
+
+    if (useCache && [self printCachedResult: cacheKey])
+        return;
+
     if ([self checkOtool: [iOFile path]] == NO)
     {
         fprintf(stderr,
@@ -457,7 +725,59 @@
     [self reportProgress: progDict];
     [progDict release];
 
-    if (![theProcessor processExe: nil])
+    // On a cache miss, send stdout to a temp file in the cache dir, then
+    // print it and move it into place.
+    char    tempPath[MAXPATHLEN];
+    int     tempFD      = -1;
+    int     savedStdout = -1;
+
+    if (useCache)
+    {
+        snprintf(tempPath, MAXPATHLEN, "%s/%sXXXXXX",
+            iCachePath, RESULT_CACHE_TEMP_PREFIX);
+        fflush(stdout);
+        tempFD  = mkstemp(tempPath);
+
+        if (tempFD < 0)
+            perror("otx: unable to create cache file");
+        else if ((savedStdout = dup(STDOUT_FILENO)) < 0 ||
+            dup2(tempFD, STDOUT_FILENO) < 0)
+        {
+            perror("otx: unable to redirect output to cache file");
+
+            if (savedStdout >= 0)
+                close(savedStdout);
+
+            savedStdout = -1;
+            close(tempFD);
+            unlink(tempPath);
+            tempFD  = -1;
+        }
+    }
+
+    BOOL    result  = [theProcessor processExe: nil];
+
+    if (tempFD >= 0)
+    {
+        fflush(stdout);
+        dup2(savedStdout, STDOUT_FILENO);
+        close(savedStdout);
+
+        if (result && lseek(tempFD, 0, SEEK_SET) == 0 &&
+            [self copyToStdout: tempFD])
+            [self saveCachedResult: tempPath key: cacheKey];
+        else
+        {
+            if (result)
+                perror("otx: unable to print output from cache file");
+
+            unlink(tempPath);
+        }
+
+        close(tempFD);
+    }
+
+    if (!result)
     {
         fprintf(stderr, "otx: -[CLIController processFile]: "
             "possible permission error\n");
@@ -550,6 +870,452 @@
     }
 }
 
+//  queryXrefs
+// ----------------------------------------------------------------------------
+//  Print every call site of the function, and every send of the selector,
+//  named iQueryName, from the index file written by -xref. The file is
+//  mapped rather than read, and all lookups are binary searches, so this
+//  doesn't slow down with the size of the index.
+
+- (void)queryXrefs
+{
+    int fd  = open(iQueryIndexPath, O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("otx: unable to open xref index file");
+        return;
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 ||
+        fileStat.st_size < (off_t)sizeof(XrefIndexHeader))
+    {
+        fprintf(stderr, "otx: %s is not an xref index.\n", iQueryIndexPath);
+        close(fd);
+        return;
+    }
+
+    size_t  fileSize    = fileStat.st_size;
+    char*   fileBase    = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (fileBase == MAP_FAILED)
+    {
+        perror("otx: unable to map xref index file");
+        return;
+    }
+
+    // Make sure the tables and names fit the file before touching them. The
+    // names must end with a NUL, so that any name within them is terminated.
+    XrefIndexHeader*    header      = (XrefIndexHeader*)fileBase;
+    UInt64              tablesSize  = sizeof(XrefIndexHeader) +
+        (UInt64)header->numKeys * sizeof(XrefIndexKey) +
+        (UInt64)header->numSites * sizeof(XrefIndexSite) +
+        (UInt64)header->numFuncs * sizeof(XrefIndexFunc);
+
+    if (header->magic != XREF_INDEX_MAGIC ||
+        header->version != XREF_INDEX_VERSION ||
+        tablesSize + header->stringsSize != fileSize ||
+        (header->stringsSize && fileBase[fileSize - 1] != 0))
+    {
+        fprintf(stderr, "otx: %s is not an xref index.\n", iQueryIndexPath);
+        munmap(fileBase, fileSize);
+        return;
+    }
+
+    XrefIndexKey*       keys    = (XrefIndexKey*)(header + 1);
+    XrefIndexSite*      sites   = (XrefIndexSite*)(keys + header->numKeys);
+    XrefIndexFunc*      funcs   = (XrefIndexFunc*)(sites + header->numSites);
+    char*               names   = (char*)(funcs + header->numFuncs);
+    uint32_t            numFound    = 0;
+    BOOL                malformed   = NO;
+    UInt8               kind;
+
+    // Each record's offsets are checked as it's used, so lookups stay
+    // binary searches.
+    for (kind = XrefCall; kind <= XrefSelector && !malformed; kind++)
+    {
+        // Find the key.
+        uint32_t    low     = 0;
+        uint32_t    high    = header->numKeys;
+
+        while (low < high)
+        {
+            uint32_t    mid     = low + (high - low) / 2;
+
+            if (keys[mid].name >= header->stringsSize)
+            {
+                malformed   = YES;
+                break;
+            }
+
+            int         result  = (keys[mid].kind != kind) ?
+                ((keys[mid].kind < kind) ? -1 : 1) :
+                strcmp(&names[keys[mid].name], iQueryName);
+
+            if (result < 0)
+                low     = mid + 1;
+            else
+                high    = mid;
+        }
+
+        if (malformed || low == header->numKeys || keys[low].kind != kind ||
+            keys[low].name >= header->stringsSize ||
+            strcmp(&names[keys[low].name], iQueryName))
+            continue;
+
+        if ((UInt64)keys[low].firstSite + keys[low].numSites > header->numSites)
+        {
+            malformed   = YES;
+            break;
+        }
+
+        uint32_t    i;
+
+        for (i = 0; i < keys[low].numSites; i++)
+        {
+            XrefIndexSite*  theSite = &sites[keys[low].firstSite + i];
+
+            // Find the name of the function the site is in.
+            uint32_t    funcLow     = 0;
+            uint32_t    funcHigh    = header->numFuncs;
+
+            while (funcLow < funcHigh)
+            {
+                uint32_t    mid = funcLow + (funcHigh - funcLow) / 2;
+
+                if (funcs[mid].address < theSite->function)
+                    funcLow     = mid + 1;
+                else
+                    funcHigh    = mid;
+            }
+
+            char*   funcName    = "";
+
+            if (funcLow < header->numFuncs &&
+                funcs[funcLow].address == theSite->function)
+            {
+                if (funcs[funcLow].name >= header->stringsSize)
+                {
+                    malformed   = YES;
+                    break;
+                }
+
+                funcName    = &names[funcs[funcLow].name];
+            }
+
+            printf("%s\t0x%08llx\t%s\n", (kind == XrefCall) ? "call" : "send",
+                theSite->site, funcName);
+            numFound++;
+        }
+    }
+
+    if (malformed)
+        fprintf(stderr, "otx: %s is damaged.\n", iQueryIndexPath);
+    else if (!numFound)
+        fprintf(stderr, "otx: no references to %s\n", iQueryName);
+
+    munmap(fileBase, fileSize);
+}
+
+#pragma mark -
+#pragma mark Result cache
+//  resultCacheKey:
+// ----------------------------------------------------------------------------
+//  Hash everything that can change the output into a file name for -cache:
+//  the executable's contents and path (otool prints it), the arch, every
+//  ProcOptions field that affects stdout and our version. outKey must hold
+//  RESULT_CACHE_KEY_LENGTH + 1 chars. Add new ProcOptions fields here.
+
+- (BOOL)resultCacheKey: (char*)outKey
+{
+    const char* exePath = UTF8STRING([iOFile path]);
+    int         fd      = open(exePath, O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("otx: unable to open executable for -cache");
+        return NO;
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return NO;
+    }
+
+    size_t  fileSize    = fileStat.st_size;
+    void*   fileBase    = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (fileBase == MAP_FAILED)
+    {
+        perror("otx: unable to map executable for -cache");
+        return NO;
+    }
+
+    UInt8   fileDigest[CC_SHA256_DIGEST_LENGTH];
+
+    CC_SHA256(fileBase, fileSize, fileDigest);
+    munmap(fileBase, fileSize);
+
+    // demangleCachePath only makes us faster, and the other paths disable
+    // the cache, see processFile.
+    UInt64  fields[]    = {
+        iArchSelector,
+        iOpts.localOffsets,
+        iOpts.showCode,
+        iOpts.entabOutput,
+        iOpts.dataSections,
+        iOpts.checksum,
+        iOpts.verboseMsgSends,
+        iOpts.separateLogicalBlocks,
+        iOpts.demangleCppNames,
+        iOpts.returnTypes,
+        iOpts.variableTypes,
+        iOpts.returnStatements,
+        iOpts.streamOutput,
+        iOpts.parallelize,
+        iOpts.graphFormat,
+        iOpts.debugMode,
+        iOpts.rangeStart,
+        iOpts.rangeEnd,
+        iOpts.recordFormat,
+        iOpts.compressOutput,
+        iOpts.sha256Checksum
+    };
+    const char* functionName    = (iOpts.functionName) ? iOpts.functionName : "";
+    UInt8       keyDigest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_CTX   context;
+
+    CC_SHA256_Init(&context);
+    CC_SHA256_Update(&context, RESULT_CACHE_VERSION,
+        sizeof(RESULT_CACHE_VERSION));
+    CC_SHA256_Update(&context, fileDigest, sizeof(fileDigest));
+    CC_SHA256_Update(&context, exePath, strlen(exePath) + 1);
+    CC_SHA256_Update(&context, fields, sizeof(fields));
+    CC_SHA256_Update(&context, functionName, strlen(functionName) + 1);
+    CC_SHA256_Final(keyDigest, &context);
+
+    static const char   hexDigits[] = "0123456789abcdef";
+    uint32_t            i;
+
+    for (i = 0; i < CC_SHA256_DIGEST_LENGTH; i++)
+    {
+        outKey[i * 2]       = hexDigits[keyDigest[i] >> 4];
+        outKey[i * 2 + 1]   = hexDigits[keyDigest[i] & 0xf];
+    }
+
+    outKey[RESULT_CACHE_KEY_LENGTH] = 0;
+
+    return YES;
+}
+
+//  copyToStdout:
+// ----------------------------------------------------------------------------
+
+- (BOOL)copyToStdout: (int)inFD
+{
+    char    buffer[64 * 1024];
+    ssize_t count;
+
+    fflush(stdout);
+
+    while ((count = read(inFD, buffer, sizeof(buffer))) > 0)
+    {
+        ssize_t written = 0;
+
+        while (written < count)
+        {
+            ssize_t result  = write(STDOUT_FILENO, buffer + written,
+                count - written);
+
+            if (result <= 0)
+                return NO;
+
+            written += result;
+        }
+    }
+
+    return (count == 0);
+}
+
+//  printCachedResult:
+// ----------------------------------------------------------------------------
+//  Copy a previous run's output to stdout if the cache has it, and mark it
+//  as recently used. Entries are only ever created by rename(2) and removed
+//  by unlink(2), so once we have one open it can't change or vanish under us.
+
+- (BOOL)printCachedResult: (const char*)inKey
+{
+    char    entryPath[MAXPATHLEN];
+
+    snprintf(entryPath, MAXPATHLEN, "%s/%s%s",
+        iCachePath, inKey, RESULT_CACHE_SUFFIX);
+
+    int fd  = open(entryPath, O_RDONLY);
+
+    if (fd < 0)
+        return NO;
+
+    // The modification date is the LRU clock, see trimResultCache. Once
+    // we've started printing, there's no falling back to a fresh run.
+    futimes(fd, NULL);
+
+    if (![self copyToStdout: fd])
+        perror("otx: unable to print cached output");
+
+    close(fd);
+
+    return YES;
+}
+
+//  saveCachedResult:key:
+// ----------------------------------------------------------------------------
+//  Move a finished run's output from inTempPath into the cache. Racing
+//  processes with the same key each rename a complete file into place, and
+//  the last one wins.
+
+- (void)saveCachedResult: (const char*)inTempPath
+                     key: (const char*)inKey
+{
+    char    entryPath[MAXPATHLEN];
+
+    snprintf(entryPath, MAXPATHLEN, "%s/%s%s",
+        iCachePath, inKey, RESULT_CACHE_SUFFIX);
+
+    if (rename(inTempPath, entryPath) != 0)
+    {
+        perror("otx: unable to save output to the cache");
+        unlink(inTempPath);
+        return;
+    }
+
+    [self trimResultCache];
+}
+
+//  trimResultCache
+// ----------------------------------------------------------------------------
+//  Delete the least recently used entries until the cache fits in
+//  iCacheMaxSize, along with temp files left behind by crashed runs. Only one
+//  process trims at a time, the others skip it.
+
+- (void)trimResultCache
+{
+    char    lockPath[MAXPATHLEN];
+
+    snprintf(lockPath, MAXPATHLEN, "%s/%s", iCachePath, RESULT_CACHE_LOCK_FILE);
+
+    int lockFD  = open(lockPath, O_RDONLY | O_CREAT, 0644);
+
+    if (lockFD < 0)
+    {
+        perror("otx: unable to open cache lock file");
+        return;
+    }
+
+    if (flock(lockFD, LOCK_EX | LOCK_NB) != 0)
+    {
+        close(lockFD);
+        return;
+    }
+
+    DIR*    cacheDir    = opendir(iCachePath);
+
+    if (!cacheDir)
+    {
+        perror("otx: unable to read cache directory");
+        close(lockFD);
+        return;
+    }
+
+    CacheEntryInfo* entries     = NULL;
+    uint32_t        numEntries  = 0;
+    uint32_t        maxEntries  = 0;
+    UInt64          totalSize   = 0;
+    time_t          now         = time(NULL);
+    size_t          suffixLen   = strlen(RESULT_CACHE_SUFFIX);
+    struct dirent*  dirEntry;
+    struct stat     entryStat;
+    char            entryPath[MAXPATHLEN];
+
+    while ((dirEntry = readdir(cacheDir)))
+    {
+        size_t  nameLen = strlen(dirEntry->d_name);
+
+        snprintf(entryPath, MAXPATHLEN, "%s/%s", iCachePath, dirEntry->d_name);
+
+        if (!strncmp(dirEntry->d_name, RESULT_CACHE_TEMP_PREFIX,
+            strlen(RESULT_CACHE_TEMP_PREFIX)))
+        {
+            if (stat(entryPath, &entryStat) == 0 &&
+                now - entryStat.st_mtime > RESULT_CACHE_STALE_TEMP)
+                unlink(entryPath);
+
+            continue;
+        }
+
+        if (nameLen != RESULT_CACHE_KEY_LENGTH + suffixLen ||
+            strcmp(dirEntry->d_name + RESULT_CACHE_KEY_LENGTH,
+            RESULT_CACHE_SUFFIX) ||
+            stat(entryPath, &entryStat) != 0 || !S_ISREG(entryStat.st_mode))
+            continue;
+
+        if (numEntries >= maxEntries)
+        {
+            maxEntries  = MAX(64, maxEntries * 2);
+
+            CacheEntryInfo* newEntries  =
+                realloc(entries, maxEntries * sizeof(CacheEntryInfo));
+
+            if (!newEntries)
+            {
+                fprintf(stderr, "otx: not enough memory to trim the cache\n");
+                break;
+            }
+
+            entries = newEntries;
+        }
+
+        entries[numEntries].lastUsed    = entryStat.st_mtime;
+        entries[numEntries].size        = entryStat.st_size;
+        strncpy(entries[numEntries].name, dirEntry->d_name,
+            sizeof(entries[numEntries].name) - 1);
+        entries[numEntries].name[sizeof(entries[numEntries].name) - 1] = 0;
+        totalSize   += entryStat.st_size;
+        numEntries++;
+    }
+
+    closedir(cacheDir);
+
+    if (totalSize > iCacheMaxSize)
+    {
+        qsort(entries, numEntries, sizeof(CacheEntryInfo),
+            (COMPARISON_FUNC_TYPE)CacheEntry_Compare_LastUsed);
+
+        uint32_t    i;
+
+        for (i = 0; i < numEntries && totalSize > iCacheMaxSize; i++)
+        {
+            snprintf(entryPath, MAXPATHLEN, "%s/%s", iCachePath, entries[i].name);
+
+            if (unlink(entryPath) == 0)
+                totalSize   -= entries[i].size;
+        }
+    }
+
+    if (entries)
+        free(entries);
+
+    close(lockFD);
+}
+
 #pragma mark -
 #pragma mark ErrorReporter protocol
 //  reportError:suggestion:
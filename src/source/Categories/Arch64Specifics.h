@@ -13,10 +13,16 @@
 
 @interface Exe64Processor(Arch64Specifics)
 
-- (void)gatherFuncInfos;
+- (void)gatherFuncInfosFrom: (Line64*)inStartLine
+                         to: (Line64*)inEndLine;
 - (void)postProcessCodeLine: (Line64**)ioLine;
 - (BOOL)lineIsFunction: (Line64*)inLine;
 - (BOOL)codeIsBlockJump: (UInt8*)inCode;
+- (BOOL)codeIsCall: (UInt8*)inCode;
+- (BOOL)getBranchInfo: (Branch64Info*)outInfo
+              forLine: (Line64*)inLine;
+- (BOOL)getCallTarget: (UInt64*)outTarget
+              forLine: (Line64*)inLine;
 - (void)codeFromLine: (Line64*)inLine;
 - (void)checkThunk: (Line64*)inLine;
 - (BOOL)getThunkInfo: (ThunkInfo*)outInfo
@@ -13,10 +13,11 @@
 
 @implementation Exe64Processor(Arch64Specifics)
 
-//  gatherFuncInfos
+//  gatherFuncInfosFrom:to:
 // ----------------------------------------------------------------------------
 
-- (void)gatherFuncInfos
+- (void)gatherFuncInfosFrom: (Line64*)inStartLine
+                         to: (Line64*)inEndLine
 {}
 
 //  postProcessCodeLine:
@@ -41,6 +42,32 @@
     return NO;
 }
 
+//  codeIsCall:
+// ----------------------------------------------------------------------------
+
+- (BOOL)codeIsCall: (UInt8*)inCode
+{
+    return NO;
+}
+
+//  getBranchInfo:forLine:
+// ----------------------------------------------------------------------------
+
+- (BOOL)getBranchInfo: (Branch64Info*)outInfo
+              forLine: (Line64*)inLine
+{
+    return NO;
+}
+
+//  getCallTarget:forLine:
+// ----------------------------------------------------------------------------
+
+- (BOOL)getCallTarget: (UInt64*)outTarget
+              forLine: (Line64*)inLine
+{
+    return NO;
+}
+
 //  codeFromLine:
 // ----------------------------------------------------------------------------
 
@@ -13,10 +13,16 @@
 
 @interface Exe32Processor(ArchSpecifics)
 
-- (void)gatherFuncInfos;
+- (void)gatherFuncInfosFrom: (Line*)inStartLine
+                         to: (Line*)inEndLine;
 - (void)postProcessCodeLine: (Line**)ioLine;
 - (BOOL)lineIsFunction: (Line*)inLine;
 - (BOOL)codeIsBlockJump: (UInt8*)inCode;
+- (BOOL)codeIsCall: (UInt8*)inCode;
+- (BOOL)getBranchInfo: (BranchInfo*)outInfo
+              forLine: (Line*)inLine;
+- (BOOL)getCallTarget: (uint32_t*)outTarget
+              forLine: (Line*)inLine;
 - (void)codeFromLine: (Line*)inLine;
 - (void)checkThunk: (Line*)inLine;
 - (BOOL)getThunkInfo: (ThunkInfo*)outInfo
@@ -13,10 +13,11 @@
 
 @implementation Exe32Processor(ArchSpecifics)
 
-//  gatherFuncInfos
+//  gatherFuncInfosFrom:to:
 // ----------------------------------------------------------------------------
 
-- (void)gatherFuncInfos
+- (void)gatherFuncInfosFrom: (Line*)inStartLine
+                         to: (Line*)inEndLine
 {}
 
 //  postProcessCodeLine:
@@ -41,6 +42,32 @@
     return NO;
 }
 
+//  codeIsCall:
+// ----------------------------------------------------------------------------
+
+- (BOOL)codeIsCall: (UInt8*)inCode
+{
+    return NO;
+}
+
+//  getBranchInfo:forLine:
+// ----------------------------------------------------------------------------
+
+- (BOOL)getBranchInfo: (BranchInfo*)outInfo
+              forLine: (Line*)inLine
+{
+    return NO;
+}
+
+//  getCallTarget:forLine:
+// ----------------------------------------------------------------------------
+
+- (BOOL)getCallTarget: (uint32_t*)outTarget
+              forLine: (Line*)inLine
+{
+    return NO;
+}
+
 //  codeFromLine:
 // ----------------------------------------------------------------------------
 
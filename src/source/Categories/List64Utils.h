@@ -23,6 +23,13 @@
            withLine: (Line64*)newLine
              inList: (Line64**)listHead;
 - (BOOL)printLinesFromList: (Line64*)listHead;
+- (BOOL)printLinesFrom: (Line64*)inLine
+                before: (Line64*)inStopLine
+              toWriter: (OutputWriter*)ioWriter;
+- (BOOL)printLinesBefore: (Line64*)inLine
+                fromList: (Line64**)listHead
+                toWriter: (OutputWriter*)ioWriter;
+- (BOOL)printLinesToDirectory: (Line64**)listHead;
 - (void)deleteLinesFromList: (Line64*)listHead;
 - (void)deleteLinesBefore: (Line64*)inLine
                  fromList: (Line64**)listHead;
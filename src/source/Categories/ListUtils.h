@@ -23,6 +23,13 @@
            withLine: (Line*)newLine
              inList: (Line**)listHead;
 - (BOOL)printLinesFromList: (Line*)listHead;
+- (BOOL)printLinesFrom: (Line*)inLine
+                before: (Line*)inStopLine
+              toWriter: (OutputWriter*)ioWriter;
+- (BOOL)printLinesBefore: (Line*)inLine
+                fromList: (Line**)listHead
+                toWriter: (OutputWriter*)ioWriter;
+- (BOOL)printLinesToDirectory: (Line**)listHead;
 - (void)deleteLinesFromList: (Line*)listHead;
 - (void)deleteLinesBefore: (Line*)inLine
                  fromList: (Line**)listHead;
@@ -110,39 +110,221 @@
         return NO;
     }
 
-    Line*   theLine = listHead;
+    OutputWriter    writer;
+    BOOL            result  = NO;
 
-    // Cache the fileno and use SYS_write for maximum speed.
-    SInt32  fileNum = fileno(outFile);
+    if ([self openOutputWriter: &writer toFile: outFile withToc: YES])
+    {
+        result  = [self printLinesFrom: listHead before: NULL
+            toWriter: &writer];
+        result  = [self closeOutputWriter: &writer] && result;
+    }
 
-    while (theLine)
+    if (iOutputFilePath)
     {
-        if (syscall(SYS_write, fileNum, theLine->chars, theLine->length) == -1)
+        if (fclose(outFile) != 0)
         {
-            perror("otx: unable to write to output file");
+            perror("otx: unable to close output file");
+            return NO;
+        }
+    }
+
+    return result;
+}
+
+//  printLinesFrom:before:toWriter:
+// ----------------------------------------------------------------------------
+//  Print inLine and the lines after it up to, but not including, inStopLine.
+//  A NULL inStopLine prints to the end of the list.
+
+- (BOOL)printLinesFrom: (Line*)inLine
+                before: (Line*)inStopLine
+              toWriter: (OutputWriter*)ioWriter
+{
+    Line*   theLine;
+
+    for (theLine = inLine; theLine && theLine != inStopLine;
+        theLine = theLine->next)
+    {
+        // A function's name line starts a new block, see endOutputBlock:,
+        // and a new -toc entry.
+        if (!theLine->info.isCode && theLine->next &&
+            theLine->next->info.isCode && theLine->next->info.isFunction)
+        {
+            if (![self endOutputBlock: ioWriter])
+                return NO;
+
+            if (ioWriter->writeToc)
+                [self addTocEntry: theLine->chars
+                    address: theLine->next->info.address
+                    offset: ioWriter->offset];
+        }
+        else if (ioWriter->writeToc && theLine->info.isCode && iNumTocEntries)
+            iTocEntries[iNumTocEntries - 1].endAddress  =
+                theLine->info.address + theLine->info.codeLength;
 
-            if (iOutputFilePath)
+        if (![self writeOutput: ioWriter bytes: theLine->chars
+            length: theLine->length])
+            return NO;
+    }
+
+    return YES;
+}
+
+//  printLinesBefore:fromList:toWriter:
+// ----------------------------------------------------------------------------
+//  Print the lines that precede inLine and delete them. A NULL inLine prints
+//  and deletes the entire list. Used when streaming output one function at a
+//  time.
+
+- (BOOL)printLinesBefore: (Line*)inLine
+                fromList: (Line**)listHead
+                toWriter: (OutputWriter*)ioWriter
+{
+    Line*   theLine = *listHead;
+    Line*   nextLine;
+    BOOL    result  = YES;
+
+    while (theLine && theLine != inLine)
+    {
+        // See printLinesFrom:before:toWriter:.
+        if (!theLine->info.isCode && theLine->next &&
+            theLine->next->info.isCode && theLine->next->info.isFunction)
+        {
+            if (![self endOutputBlock: ioWriter])
             {
-                if (fclose(outFile) != 0)
-                    perror("otx: unable to close output file");
+                result  = NO;
+                break;
             }
 
-            return NO;
+            if (ioWriter->writeToc)
+                [self addTocEntry: theLine->chars
+                    address: theLine->next->info.address
+                    offset: ioWriter->offset];
+        }
+        else if (ioWriter->writeToc && theLine->info.isCode && iNumTocEntries)
+            iTocEntries[iNumTocEntries - 1].endAddress  =
+                theLine->info.address + theLine->info.codeLength;
+
+        if (![self writeOutput: ioWriter bytes: theLine->chars
+            length: theLine->length])
+        {
+            result  = NO;
+            break;
         }
 
-        theLine = theLine->next;
+        nextLine    = theLine->next;
+        free(theLine->chars);
+        free(theLine);
+        theLine     = nextLine;
     }
 
-    if (iOutputFilePath)
+    // Update the head.
+    *listHead   = theLine;
+
+    if (theLine)
+        theLine->prev   = NULL;
+
+    return result;
+}
+
+//  printLinesToDirectory:
+// ----------------------------------------------------------------------------
+//  Print the list for -split and delete it. Each function becomes a piece,
+//  from its name line up to the next function's name line, filed by
+//  SplitNameForFunction. Lines before the first function go in
+//  SPLIT_HEADER_NAME.
+
+- (BOOL)printLinesToDirectory: (Line**)listHead
+{
+    SplitPiece* pieces      = NULL;
+    uint32_t    numPieces   = 0;
+    uint32_t    maxPieces   = 0;
+    uint32_t    i;
+    Line*       theLine     = *listHead;
+    Line*       nextLine;
+
+    while (theLine)
     {
-        if (fclose(outFile) != 0)
+        SplitPiece  thePiece    = {NULL, NULL, theLine->length, numPieces};
+        Line*       stopLine;
+
+        if (theLine->next && theLine->next->info.isCode &&
+            theLine->next->info.isFunction && !theLine->info.isCode)
+            thePiece.name   = SplitNameForFunction(theLine->chars);
+        else
+            thePiece.name   = strdup(SPLIT_HEADER_NAME);
+
+        // The piece ends at the next function's name line.
+        for (stopLine = theLine->next; stopLine; stopLine = stopLine->next)
         {
-            perror("otx: unable to close output file");
+            if (!stopLine->info.isCode && stopLine->next &&
+                stopLine->next->info.isCode && stopLine->next->info.isFunction)
+                break;
+
+            thePiece.length += stopLine->length;
+        }
+
+        thePiece.text   = malloc(MAX(thePiece.length, 1));
+
+        if (numPieces == maxPieces && thePiece.name && thePiece.text)
+        {
+            uint32_t    newMax      = MAX(256, maxPieces * 2);
+            SplitPiece* newPieces   =
+                realloc(pieces, sizeof(SplitPiece) * newMax);
+
+            if (newPieces)
+            {
+                pieces      = newPieces;
+                maxPieces   = newMax;
+            }
+        }
+
+        if (!thePiece.name || !thePiece.text || numPieces == maxPieces)
+        {
+            fprintf(stderr, "otx: not enough memory for split output\n");
+            free(thePiece.name);
+            free(thePiece.text);
+
+            for (i = 0; i < numPieces; i++)
+            {
+                free(pieces[i].name);
+                free(pieces[i].text);
+            }
+
+            free(pieces);
+
+            // Leave the rest for deleteLinesFromList:.
+            *listHead       = theLine;
+            theLine->prev   = NULL;
+
             return NO;
         }
+
+        // Move the lines into the piece.
+        size_t  theLength   = 0;
+
+        while (theLine != stopLine)
+        {
+            memcpy(&thePiece.text[theLength], theLine->chars, theLine->length);
+            theLength  += theLine->length;
+
+            nextLine    = theLine->next;
+            free(theLine->chars);
+            free(theLine);
+            theLine     = nextLine;
+        }
+
+        pieces[numPieces++] = thePiece;
     }
 
-    return YES;
+    *listHead   = NULL;
+
+    BOOL    result  = [self writeSplitPieces: pieces count: numPieces];
+
+    free(pieces);
+
+    return result;
 }
 
 //  deleteLinesFromList:
@@ -17,6 +17,7 @@
 - (void)loadObjcClassList;
 - (void)loadSegment: (segment_command_64*)inSegPtr;
 - (void)loadSymbols: (symtab_command*)inSymPtr;
+- (void)loadFunctionStarts: (linkedit_data_command*)inCmdPtr;
 - (void)loadCStringSection: (section_64*)inSect;
 - (void)loadNSStringSection: (section_64*)inSect;
 - (void)loadLit4Section: (section_64*)inSect;
@@ -127,6 +127,10 @@
                 [self loadSymbols: (symtab_command*)ptr];
                 break;
 
+            case LC_FUNCTION_STARTS:
+                [self loadFunctionStarts: (linkedit_data_command*)ptr];
+                break;
+
             default:
                 break;
         }
@@ -304,6 +308,9 @@
     if (iSwapped)
         swap_segment_command_64(&swappedSeg, OSHostByteOrder());
 
+    if (strcmp_sectname(swappedSeg.segname, SEG_TEXT) == 0)
+        iTextSegAddress = swappedSeg.vmaddr;
+
     // Set a pointer to the first section_64.
     section_64*    sectionPtr  =
         (section_64*)((char*)inSegPtr + sizeof(segment_command_64));
@@ -440,6 +447,22 @@
         (COMPARISON_FUNC_TYPE)Sym_Compare_64);
 }
 
+//  loadFunctionStarts:
+// ----------------------------------------------------------------------------
+//  Remember where the LC_FUNCTION_STARTS data lives. It's decoded in
+//  buildFunctionStarts, once the __TEXT segment address is known.
+
+- (void)loadFunctionStarts: (linkedit_data_command*)inCmdPtr
+{
+    linkedit_data_command   swappedCmd  = *inCmdPtr;
+
+    if (iSwapped)
+        swap_linkedit_data_command(&swappedCmd, OSHostByteOrder());
+
+    iFuncStartsOffset   = swappedCmd.dataoff;
+    iFuncStartsSize     = swappedCmd.datasize;
+}
+
 //  loadCStringSection:
 // ----------------------------------------------------------------------------
 
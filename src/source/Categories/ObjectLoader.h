@@ -16,6 +16,7 @@
 - (void)loadLCommands;
 - (void)loadSegment: (segment_command*)inSegPtr;
 - (void)loadSymbols: (symtab_command*)inSymPtr;
+- (void)loadFunctionStarts: (linkedit_data_command*)inCmdPtr;
 - (void)loadObjcSection: (section*)inSect;
 - (void)loadObjcModules;
 - (void)loadObjcClassList;
@@ -127,6 +127,10 @@
                 [self loadSymbols: (symtab_command*)ptr];
                 break;
 
+            case LC_FUNCTION_STARTS:
+                [self loadFunctionStarts: (linkedit_data_command*)ptr];
+                break;
+
             default:
                 break;
         }
@@ -158,6 +162,9 @@
     if (iSwapped)
         swap_segment_command(&swappedSeg, OSHostByteOrder());
 
+    if (!strcmp(swappedSeg.segname, SEG_TEXT))
+        iTextSegAddress = swappedSeg.vmaddr;
+
     // Set a pointer to the first section.
     section*    sectionPtr  =
         (section*)((char*)inSegPtr + sizeof(segment_command));
@@ -299,6 +306,22 @@
         (COMPARISON_FUNC_TYPE)Sym_Compare);
 }
 
+//  loadFunctionStarts:
+// ----------------------------------------------------------------------------
+//  Remember where the LC_FUNCTION_STARTS data lives. It's decoded in
+//  buildFunctionStarts, once the __TEXT segment address is known.
+
+- (void)loadFunctionStarts: (linkedit_data_command*)inCmdPtr
+{
+    linkedit_data_command   swappedCmd  = *inCmdPtr;
+
+    if (iSwapped)
+        swap_linkedit_data_command(&swappedCmd, OSHostByteOrder());
+
+    iFuncStartsOffset   = swappedCmd.dataoff;
+    iFuncStartsSize     = swappedCmd.datasize;
+}
+
 //  loadObjcSection:
 // ----------------------------------------------------------------------------
 
@@ -79,6 +79,7 @@ typedef struct
     UInt8   codeLength;
     BOOL    isCode;         // NO for function and section names etc.
     BOOL    isFunction;     // YES if this is the first instruction in a function.
+    BOOL    startsBlock;    // YES if a saved block begins here.
 }
 LineInfo;
 
@@ -116,7 +117,8 @@ struct Line
 
     Saved state of the CPU registers and local copies of self. 'localSelves'
     is an array with 'numLocalSelves' items. 'regInfos' is an array whose
-    count is defined by the processor-specific subclasses.
+    count is defined by the processor-specific subclasses. 'validRegs'
+    mirrors the isValid flags of 'regInfos' for quick comparison.
 */
 typedef struct
 {
@@ -125,6 +127,7 @@ typedef struct
     uint32_t          numLocalSelves;
     VarInfo*        localVars;
     uint32_t          numLocalVars;
+    uint64_t          validRegs;      // bit n set if regInfos[n].isValid
 }
 MachineState;
 
@@ -142,20 +145,96 @@ typedef struct
 }
 BlockInfo;
 
-/*  FunctionInfo
+/*  BranchInfo
 
-    Used for tracking the changing machine states between code blocks in a
-    function. 'blocks' is an array with 'numBlocks' items.
+    Describes a line of code that ends a basic block. 'target' is only
+    meaningful if 'hasTarget' is YES, which it isn't for returns and
+    indirect jumps. 'fallsThrough' is YES if the next line may execute
+    after this one, as with conditional branches.
+*/
+typedef struct
+{
+    uint32_t    target;
+    BOOL        hasTarget;
+    BOOL        fallsThrough;
+}
+BranchInfo;
+
+/*  FlowBlock
+
+    A basic block in a FlowGraph, running from 'beginAddress' up to, but
+    not including, 'endAddress'. 'succs' are indices into the graph's
+    'blocks' array, or -1: succs[0] is the branch target and succs[1] the
+    fallthrough. The block's predecessors are the 'numPreds' indices in the
+    graph's 'preds' array starting at 'firstPred'.
+*/
+typedef struct
+{
+    uint32_t    beginAddress;
+    uint32_t    endAddress;
+    SInt32      succs[2];
+    uint32_t    firstPred;
+    uint32_t    numPreds;
+}
+FlowBlock;
+
+/*  FlowGraph
+
+    The control flow graph of the function at 'address'. 'blocks' is an
+    array with 'numBlocks' items, sorted by address, the entry block first.
+    See buildGraph:forFunction:to:. Only -g and -G use it for now, block
+    info for register tracking still comes from gatherFuncInfos.
 */
 typedef struct
 {
     uint32_t    address;
-    BlockInfo*  blocks;
+    FlowBlock*  blocks;
     uint32_t    numBlocks;
-    uint32_t    genericFuncNum; // 'AnonX' if > 0
+    uint32_t*   preds;
+    uint32_t    numPreds;
+}
+FlowGraph;
+
+/*  FunctionInfo
+
+    Used for tracking the changing machine states between code blocks in a
+    function. 'blocks' is an array with 'numBlocks' items. The blocks' saved
+    states live in 'stateArena', and 'lastState' is the most recently saved
+    one, which the next block can share if nothing changed.
+*/
+typedef struct
+{
+    uint32_t        address;
+    BlockInfo*      blocks;
+    uint32_t        numBlocks;
+    uint32_t        genericFuncNum; // 'AnonX' if > 0
+    StateArena      stateArena;
+    MachineState    lastState;
+    UInt8           incHash[INCREMENTAL_HASH_LENGTH];  // see hashFunction:to:
 }
 FunctionInfo;
 
+/*  FunctionChunk
+
+    A run of lines handed to one worker thread by processLinesInParallel.
+    'head' is the first line, usually the function's name line, and the run
+    ends just before 'end'. 'funcLine' is the function's first instruction,
+    or NULL for the lines before the first function. 'tail' is the last line
+    of the previous chunk, used to stitch the list back together.
+    'firstCodeLine' and 'numCodeLines' are the chunk's slice of iLineArray.
+*/
+typedef struct
+{
+    Line*    head;
+    Line*    funcLine;
+    Line*    end;
+    Line*    tail;
+    SInt64  funcIndex;
+    uint32_t  firstCodeLine;
+    uint32_t  numCodeLines;
+}
+FunctionChunk;
+
 // ============================================================================
 
 @interface Exe32Processor : ExeProcessor
@@ -179,10 +258,21 @@ FunctionInfo;
     nlist*              iFuncSyms;
     uint32_t              iNumFuncSyms;
 
+    // known function starts, see buildFunctionStarts
+    uint32_t*           iFuncStarts;
+    uint32_t            iNumFuncStarts;
+    uint32_t            iFuncStartsOffset;      // LC_FUNCTION_STARTS data
+    uint32_t            iFuncStartsSize;
+    uint32_t            iTextSegAddress;
+
     // FunctionInfo array
     FunctionInfo*       iFuncInfos;
     uint32_t              iNumFuncInfos;
 
+    // blocks to revisit, see gatherFuncInfosForFunction:to:
+    BOOL                iBlockStateChanged;
+    uint32_t            iChangedBlockAddress;   // earliest changed block
+
     // Obj-C stuff
     section_info*       iObjcSects;
     uint32_t              iNumObjcSects;
@@ -247,9 +337,54 @@ FunctionInfo;
        controller: (id)inController
           options: (ProcOptions*)inOptions;
 - (void)deleteFuncInfos;
+- (void)deleteBlocksFromFuncInfo: (FunctionInfo*)ioFuncInfo;
+- (void)buildFunctionStarts;
+- (BOOL)isFunctionStart: (uint32_t)inAddress;
 
 // processors
 - (BOOL)processExe: (NSString*)inOutputFilePath;
+- (BOOL)processLines;
+- (BOOL)streamLines;
+- (BOOL)processLinesInParallel;
+- (BOOL)printGraphs;
+- (BOOL)processRange;
+- (Line*)findFunctionNamed: (const char*)inName;
+- (BOOL)buildGraph: (FlowGraph*)outGraph
+       forFunction: (Line*)inFuncLine
+                to: (Line*)inEndLine;
+- (void)deleteGraph: (FlowGraph*)ioGraph;
+- (void)printGraph: (FlowGraph*)inGraph
+             named: (const char*)inName
+            toFile: (FILE*)outFile;
+- (void)gatherFuncInfos;
+- (void)gatherFuncInfosForFunction: (Line*)inFuncLine
+                                to: (Line*)inEndLine;
+- (BOOL)hashFunction: (Line*)inFuncLine
+                  to: (Line*)inEndLine;
+- (void)hashDataAt: (uint32_t)inAddress
+              into: (CC_SHA256_CTX*)ioContext;
+- (void)updateBlock: (BlockInfo*)ioBlock
+           withInfo: (BlockInfo*)inInfo
+           fromLine: (Line*)inLine
+            numRegs: (uint32_t)inNumRegs;
+- (BlockInfo*)findBlockAtAddress: (uint32_t)inAddress
+                      inFunction: (FunctionInfo*)inFuncInfo;
+- (BlockInfo*)addBlockAtAddress: (uint32_t)inAddress
+                     toFunction: (FunctionInfo*)ioFuncInfo;
+- (BOOL)machineState: (MachineState*)inState1
+           isEqualTo: (MachineState*)inState2
+             numRegs: (uint32_t)inNumRegs;
+- (MachineState)meetState: (MachineState*)inState1
+                withState: (MachineState*)inState2
+                  numRegs: (uint32_t)inNumRegs
+                 intoRegs: (GPRegisterInfo*)outRegs;
+- (VarInfo*)meetVars: (VarInfo*)inVars1
+               count: (uint32_t)inCount1
+            withVars: (VarInfo*)inVars2
+               count: (uint32_t)inCount2;
+- (void)processChunk: (FunctionChunk*)ioChunk;
+- (id)newWorker;
+- (void)disposeWorker;
 - (BOOL)populateLineLists;
 - (BOOL)populateLineList: (Line**)inList
                verbosely: (BOOL)inVerbose
@@ -257,8 +392,8 @@ FunctionInfo;
                afterLine: (Line**)inLine
            includingPath: (BOOL)inIncludePath;
 - (BOOL)printDataSections;
-- (void)printDataSection: (section_info*)inSect
-                  toFile: (FILE*)outFile;
+- (BOOL)printDataSection: (section_info*)inSect
+                toWriter: (OutputWriter*)ioWriter;
 - (BOOL)lineIsCode: (const char*)inLine;
 
 // customizers
@@ -268,7 +403,6 @@ FunctionInfo;
 - (void)processLine: (Line*)ioLine;
 - (void)processCodeLine: (Line**)ioLine;
 - (void)chooseLine: (Line**)ioLine;
-- (void)entabLine: (Line*)ioLine;
 - (BOOL)getIvarName:(char **)outName type:(char **)outType withOffset:(uint32_t)offset inClass:(objc_32_class_ptr)classPtr;
 - (char*)getPointer: (uint32_t)inAddr
                type: (UInt8*)outType;
@@ -310,6 +444,28 @@ Line_Address_Compare(
     return ((*l1)->info.address > (*l2)->info.address);
 }
 
+static int
+UInt32_Compare(
+    uint32_t*   a1,
+    uint32_t*   a2)
+{
+    if (*a1 < *a2)
+        return -1;
+
+    return (*a1 > *a2);
+}
+
+static int
+BlockInfo_Address_Compare(
+    BlockInfo*  b1,
+    BlockInfo*  b2)
+{
+    if (b1->beginAddress < b2->beginAddress)
+        return -1;
+
+    return (b1->beginAddress > b2->beginAddress);
+}
+
 static int
 MethodInfo_Compare(
     MethodInfo* mi1,
@@ -337,3 +493,61 @@ MethodInfo_Compare_Swapped(
 
     return (imp1 > imp2);
 }
+
+// ----------------------------------------------------------------------------
+// Equality test for saved machine states. Registers that aren't valid are
+// equal regardless of their values.
+
+static BOOL
+GPRegisterInfos_Equal(
+    GPRegisterInfo* r1,
+    GPRegisterInfo* r2)
+{
+    if (!r1->isValid != !r2->isValid)
+        return NO;
+
+    if (r1->isValid && r1->value != r2->value)
+        return NO;
+
+    return (r1->classPtr == r2->classPtr && r1->catPtr == r2->catPtr);
+}
+
+// ----------------------------------------------------------------------------
+// The meet of one local variable with an array of them. The variable keeps
+// its value only if the array holds the same value at the same offset.
+
+static GPRegisterInfo
+VarInfo_Meet(
+    VarInfo*    var,
+    VarInfo*    vars,
+    uint32_t    numVars)
+{
+    uint32_t    i;
+
+    for (i = 0; vars && i < numVars; i++)
+    {
+        if (vars[i].offset == var->offset)
+            return (GPRegisterInfos_Equal(&vars[i].regInfo, &var->regInfo)) ?
+                var->regInfo : (GPRegisterInfo){0};
+    }
+
+    return (GPRegisterInfo){0};
+}
+
+// ----------------------------------------------------------------------------
+// Bitmask of the valid registers in a saved machine state.
+
+static uint64_t
+GPRegisterInfos_ValidMask(
+    GPRegisterInfo* regs,
+    uint32_t        numRegs)
+{
+    uint64_t    mask    = 0;
+    uint32_t    i;
+
+    for (i = 0; i < numRegs; i++)
+        if (regs[i].isValid)
+            mask    |= 1ULL << i;
+
+    return mask;
+}
@@ -72,6 +72,7 @@ typedef struct
     BOOL    isCode;         // NO for function names, section names etc.
     BOOL    isFunction;     // YES if this is the first instruction in a function.
     BOOL    isFunctionEnd;  // YES if this is the last instruction in a function.
+    BOOL    startsBlock;    // YES if a saved block begins here.
 }
 Line64Info;
 
@@ -109,15 +110,17 @@ struct Line64
 
     Saved state of the CPU registers and local copies of self. 'localSelves'
     is an array with 'numLocalSelves' items. 'regInfos' is an array whose
-    count is defined by the processor-specific subclasses.
+    count is defined by the processor-specific subclasses. 'validRegs'
+    mirrors the isValid flags of 'regInfos' for quick comparison.
 */
 typedef struct
 {
     GP64RegisterInfo*   regInfos;
-    Var64Info*          localSelves;
+    Var64Info*  localSelves;
     uint32_t              numLocalSelves;
-    Var64Info*          localVars;
+    Var64Info*  localVars;
     uint32_t              numLocalVars;
+    uint64_t              validRegs;      // bit n set if regInfos[n].isValid
 }
 Machine64State;
 
@@ -135,10 +138,62 @@ typedef struct
 }
 Block64Info;
 
+/*  Branch64Info
+
+    Describes a line of code that ends a basic block. 'target' is only
+    meaningful if 'hasTarget' is YES, which it isn't for returns and
+    indirect jumps. 'fallsThrough' is YES if the next line may execute
+    after this one, as with conditional branches.
+*/
+typedef struct
+{
+    UInt64      target;
+    BOOL        hasTarget;
+    BOOL        fallsThrough;
+}
+Branch64Info;
+
+/*  Flow64Block
+
+    A basic block in a Flow64Graph, running from 'beginAddress' up to, but
+    not including, 'endAddress'. 'succs' are indices into the graph's
+    'blocks' array, or -1: succs[0] is the branch target and succs[1] the
+    fallthrough. The block's predecessors are the 'numPreds' indices in the
+    graph's 'preds' array starting at 'firstPred'.
+*/
+typedef struct
+{
+    UInt64      beginAddress;
+    UInt64      endAddress;
+    SInt32      succs[2];
+    uint32_t    firstPred;
+    uint32_t    numPreds;
+}
+Flow64Block;
+
+/*  Flow64Graph
+
+    The control flow graph of the function at 'address'. 'blocks' is an
+    array with 'numBlocks' items, sorted by address, the entry block first.
+    See buildGraph:forFunction:to:. Only -g and -G use it for now, block
+    info for register tracking still comes from gatherFuncInfos.
+*/
+typedef struct
+{
+    UInt64          address;
+    Flow64Block*    blocks;
+    uint32_t        numBlocks;
+    uint32_t*       preds;
+    uint32_t        numPreds;
+}
+Flow64Graph;
+
 /*  Function64Info
 
     Used for tracking the changing machine states between code blocks in a
-    function. 'blocks' is an array with 'numBlocks' items.
+    function. 'blocks' is an array with 'numBlocks' items. The blocks' saved
+    states live in 'stateArena', and 'lastState' is the most recently saved
+    one, which the next block can share if nothing changed.
 */
 typedef struct
 {
@@ -146,9 +201,33 @@ typedef struct
     Block64Info*    blocks;
     uint32_t          numBlocks;
     uint32_t          genericFuncNum; // 'AnonX' if > 0
+    StateArena      stateArena;
+    Machine64State  lastState;
+    UInt8           incHash[INCREMENTAL_HASH_LENGTH];  // see hashFunction:to:
 }
 Function64Info;
 
+/*  Function64Chunk
+
+    A run of lines handed to one worker thread by processLinesInParallel.
+    'head' is the first line, usually the function's name line, and the run
+    ends just before 'end'. 'funcLine' is the function's first instruction,
+    or NULL for the lines before the first function. 'tail' is the last line
+    of the previous chunk, used to stitch the list back together.
+    'firstCodeLine' and 'numCodeLines' are the chunk's slice of iLineArray.
+*/
+typedef struct
+{
+    Line64*  head;
+    Line64*  funcLine;
+    Line64*  end;
+    Line64*  tail;
+    SInt64   funcIndex;
+    uint32_t firstCodeLine;
+    uint32_t numCodeLines;
+}
+Function64Chunk;
+
 // ============================================================================
 
 @interface Exe64Processor : ExeProcessor
@@ -173,10 +252,21 @@ Function64Info;
     nlist_64*           iFuncSyms;
     uint32_t            iNumFuncSyms;
 
+    // known function starts, see buildFunctionStarts
+    UInt64*             iFuncStarts;
+    uint32_t            iNumFuncStarts;
+    uint32_t            iFuncStartsOffset;      // LC_FUNCTION_STARTS data
+    uint32_t            iFuncStartsSize;
+    UInt64              iTextSegAddress;
+
     // FunctionInfo array
     Function64Info*     iFuncInfos;
     uint32_t              iNumFuncInfos;
 
+    // blocks to revisit, see gatherFuncInfosForFunction:to:
+    BOOL                iBlockStateChanged;
+    UInt64              iChangedBlockAddress;   // earliest changed block
+
     // Obj-C stuff
     Method64Info*       iClassMethodInfos;
     uint32_t              iNumClassMethodInfos;
@@ -223,9 +313,54 @@ Function64Info;
        controller: (id)inController
           options: (ProcOptions*)inOptions;
 - (void)deleteFuncInfos;
+- (void)deleteBlocksFromFuncInfo: (Function64Info*)ioFuncInfo;
+- (void)buildFunctionStarts;
+- (BOOL)isFunctionStart: (UInt64)inAddress;
 
 // processors
 - (BOOL)processExe: (NSString*)inOutputFilePath;
+- (BOOL)processLines;
+- (BOOL)streamLines;
+- (BOOL)processLinesInParallel;
+- (BOOL)printGraphs;
+- (BOOL)processRange;
+- (Line64*)findFunctionNamed: (const char*)inName;
+- (BOOL)buildGraph: (Flow64Graph*)outGraph
+       forFunction: (Line64*)inFuncLine
+                to: (Line64*)inEndLine;
+- (void)deleteGraph: (Flow64Graph*)ioGraph;
+- (void)printGraph: (Flow64Graph*)inGraph
+             named: (const char*)inName
+            toFile: (FILE*)outFile;
+- (void)gatherFuncInfos;
+- (void)gatherFuncInfosForFunction: (Line64*)inFuncLine
+                                to: (Line64*)inEndLine;
+- (BOOL)hashFunction: (Line64*)inFuncLine
+                  to: (Line64*)inEndLine;
+- (void)hashDataAt: (UInt64)inAddress
+              into: (CC_SHA256_CTX*)ioContext;
+- (void)updateBlock: (Block64Info*)ioBlock
+           withInfo: (Block64Info*)inInfo
+           fromLine: (Line64*)inLine
+            numRegs: (uint32_t)inNumRegs;
+- (Block64Info*)findBlockAtAddress: (UInt64)inAddress
+                        inFunction: (Function64Info*)inFuncInfo;
+- (Block64Info*)addBlockAtAddress: (UInt64)inAddress
+                       toFunction: (Function64Info*)ioFuncInfo;
+- (BOOL)machineState: (Machine64State*)inState1
+           isEqualTo: (Machine64State*)inState2
+             numRegs: (uint32_t)inNumRegs;
+- (Machine64State)meetState: (Machine64State*)inState1
+                  withState: (Machine64State*)inState2
+                    numRegs: (uint32_t)inNumRegs
+                   intoRegs: (GP64RegisterInfo*)outRegs;
+- (Var64Info*)meetVars: (Var64Info*)inVars1
+                 count: (uint32_t)inCount1
+              withVars: (Var64Info*)inVars2
+                 count: (uint32_t)inCount2;
+- (void)processChunk: (Function64Chunk*)ioChunk;
+- (id)newWorker;
+- (void)disposeWorker;
 - (BOOL)populateLineLists;
 - (BOOL)populateLineList: (Line64**)inList
                verbosely: (BOOL)inVerbose
@@ -233,8 +368,8 @@ Function64Info;
                afterLine: (Line64**)inLine
            includingPath: (BOOL)inIncludePath;
 - (BOOL)printDataSections;
-- (void)printDataSection: (section_info_64*)inSect
-                  toFile: (FILE*)outFile;
+- (BOOL)printDataSection: (section_info_64*)inSect
+                toWriter: (OutputWriter*)ioWriter;
 - (BOOL)lineIsCode: (const char*)inLine;
 
 // customizers
@@ -244,7 +379,6 @@ Function64Info;
 - (void)processLine: (Line64*)ioLine;
 - (void)processCodeLine: (Line64**)ioLine;
 - (void)chooseLine: (Line64**)ioLine;
-- (void)entabLine: (Line64*)ioLine;
 - (char*)getPointer: (UInt64)inAddr
                type: (UInt8*)outType;
 
@@ -274,6 +408,39 @@ Function64_Info_Compare(
     return (f1->address > f2->address);
 }
 
+static int
+Line64_Address_Compare(
+    Line64**    l1,
+    Line64**    l2)
+{
+    if ((*l1)->info.address < (*l2)->info.address)
+        return -1;
+
+    return ((*l1)->info.address > (*l2)->info.address);
+}
+
+static int
+UInt64_Compare(
+    UInt64* a1,
+    UInt64* a2)
+{
+    if (*a1 < *a2)
+        return -1;
+
+    return (*a1 > *a2);
+}
+
+static int
+Block64Info_Address_Compare(
+    Block64Info*    b1,
+    Block64Info*    b2)
+{
+    if (b1->beginAddress < b2->beginAddress)
+        return -1;
+
+    return (b1->beginAddress > b2->beginAddress);
+}
+
 static int
 Method64Info_Compare(
     Method64Info* mi1,
@@ -310,6 +477,66 @@ objc2_64_ivar_t_Compare(
     return (i1->offset > i2->offset);
 }
 
+// ----------------------------------------------------------------------------
+// Equality test for saved machine states. Registers that aren't valid are
+// equal regardless of their values.
+
+static BOOL
+GP64RegisterInfos_Equal(
+    GP64RegisterInfo*   r1,
+    GP64RegisterInfo*   r2)
+{
+    if (!r1->isValid != !r2->isValid)
+        return NO;
+
+    if (r1->isValid && r1->value != r2->value)
+        return NO;
+
+    return (r1->classPtr == r2->classPtr &&
+        r1->className == r2->className &&
+        r1->messageRefSel == r2->messageRefSel);
+}
+
+// ----------------------------------------------------------------------------
+// The meet of one local variable with an array of them. The variable keeps
+// its value only if the array holds the same value at the same offset.
+
+static GP64RegisterInfo
+Var64Info_Meet(
+    Var64Info*  var,
+    Var64Info*  vars,
+    uint32_t    numVars)
+{
+    uint32_t    i;
+
+    for (i = 0; vars && i < numVars; i++)
+    {
+        if (vars[i].offset == var->offset)
+            return (GP64RegisterInfos_Equal(&vars[i].regInfo, &var->regInfo)) ?
+                var->regInfo : (GP64RegisterInfo){0};
+    }
+
+    return (GP64RegisterInfo){0};
+}
+
+// ----------------------------------------------------------------------------
+// Bitmask of the valid registers in a saved machine state.
+
+static uint64_t
+GP64RegisterInfos_ValidMask(
+    GP64RegisterInfo*   regs,
+    uint32_t            numRegs)
+{
+    uint64_t    mask    = 0;
+    uint32_t    i;
+
+    for (i = 0; i < numRegs; i++)
+        if (regs[i].isValid)
+            mask    |= 1ULL << i;
+
+    return mask;
+}
+
 // ----------------------------------------------------------------------------
 // Utils
 
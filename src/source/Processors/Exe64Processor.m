@@ -9,11 +9,14 @@
 
 #import <Cocoa/Cocoa.h>
 
+#import <mach/mach_time.h>
+
 #import "Exe64Processor.h"
 #import "Arch64Specifics.h"
 #import "List64Utils.h"
 #import "Objc64Accessors.h"
 #import "Object64Loader.h"
+#import "Searchers64.h"
 #import "SysUtils.h"
 #import "UserDefaultKeys.h"
 
@@ -55,256 +58,1989 @@
         iFuncSyms   = NULL;
     }
 
-    if (iClassMethodInfos)
-    {
-        free(iClassMethodInfos);
-        iClassMethodInfos   = NULL;
-    }
+    if (iFuncStarts)
+    {
+        free(iFuncStarts);
+        iFuncStarts = NULL;
+    }
+
+    if (iClassMethodInfos)
+    {
+        free(iClassMethodInfos);
+        iClassMethodInfos   = NULL;
+    }
+
+    if (iLineArray)
+    {
+        free(iLineArray);
+        iLineArray = NULL;
+    }
+
+    [self deleteFuncInfos];
+    [self deleteLinesFromList: iPlainLineListHead];
+    [self deleteLinesFromList: iVerboseLineListHead];
+
+    [super dealloc];
+}
+
+//  deleteFuncInfos
+// ----------------------------------------------------------------------------
+
+- (void)deleteFuncInfos
+{
+    if (!iFuncInfos)
+        return;
+
+    uint32_t  i;
+
+    for (i = 0; i < iNumFuncInfos; i++)
+        [self deleteBlocksFromFuncInfo: &iFuncInfos[i]];
+
+    free(iFuncInfos);
+    iFuncInfos  = NULL;
+}
+
+//  deleteBlocksFromFuncInfo:
+// ----------------------------------------------------------------------------
+
+- (void)deleteBlocksFromFuncInfo: (Function64Info*)ioFuncInfo
+{
+    // The blocks' saved states all live in the arena.
+    [self resetArena: &ioFuncInfo->stateArena];
+    ioFuncInfo->lastState   = (Machine64State){0};
+
+    if (!ioFuncInfo->blocks)
+        return;
+
+    free(ioFuncInfo->blocks);
+    ioFuncInfo->blocks      = NULL;
+    ioFuncInfo->numBlocks   = 0;
+}
+
+#pragma mark -
+//  processExe:
+// ----------------------------------------------------------------------------
+//  The master processing method, designed to be executed in a separate thread.
+
+- (BOOL)processExe: (NSString*)inOutputFilePath
+{
+    if (!iFileArchMagic)
+    {
+        fprintf(stderr, "otx: tried to process non-machO file\n");
+        return NO;
+    }
+
+    iOutputFilePath = inOutputFilePath;
+
+    // The GUI target picks compression by the file's extension.
+    if ([[iOutputFilePath pathExtension] isEqualToString: @"gz"])
+        iOpts.compressOutput    = YES;
+    iMachHeaderPtr  = NULL;
+
+    if (![self loadMachHeader])
+    {
+        fprintf(stderr, "otx: failed to load mach header\n");
+        return NO;
+    }
+
+    [self loadLCommands];
+
+    // Hash the file while otool runs.
+    if (iOpts.checksum)
+        [self startChecksums];
+
+    NSMutableDictionary*    progDict    =
+        [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Calling otool", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    [self populateLineLists];
+
+    if (gCancel == YES)
+    {
+        [self waitForChecksums];
+        return NO;
+    }
+
+    progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Gathering info", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    // Gather info about lines while they're virgin.
+    [self gatherLineInfos];
+
+    if (gCancel == YES)
+    {
+        [self waitForChecksums];
+        return NO;
+    }
+
+    // Find functions and allocate funcInfo's.
+    [self findFunctions];
+
+    if (gCancel == YES)
+    {
+        [self waitForChecksums];
+        return NO;
+    }
+
+    if (iOpts.incrementalPath)
+        [self loadIncrementalState];
+
+    if (iOpts.functionName || iOpts.rangeEnd)
+    {
+        if (![self processRange])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+    else if (iOpts.graphFormat)
+    {
+        if (![self printGraphs])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+    else if (iOpts.streamOutput)
+    {
+        if (![self streamLines])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+    else if (iOpts.parallelize || iOpts.splitPath)
+    {
+        if (![self processLinesInParallel])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+    else
+    {
+        if (![self processLines])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+
+    if (iOpts.recordFormat == ColumnarRecords && !iOpts.graphFormat &&
+        !iOpts.splitPath)
+    {
+        if (![self writeColumnarRecords])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+
+    if (iOpts.demangleCachePath)
+        [self saveDemangleCacheFile];
+
+    if (iOpts.xrefIndexPath && !iOpts.graphFormat)
+    {
+        if (![self writeXrefIndex])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+
+    if (iOpts.incrementalPath)
+    {
+        if (![self writeIncrementalState])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+
+    if (iOpts.dataSections && !iOpts.graphFormat && !iOpts.recordFormat &&
+        !iOpts.splitPath)
+    {
+        if (![self printDataSections])
+        {
+            [self waitForChecksums];
+            return NO;
+        }
+    }
+
+    [self waitForChecksums];
+
+    progDict = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: YES], PRCompleteKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    return YES;
+}
+
+//  processLines
+// ----------------------------------------------------------------------------
+//  Gather block info for the whole __text section, then process every line.
+//  Each function's preceding lines are written as soon as they're final.
+
+- (BOOL)processLines
+{
+    NSMutableDictionary*    progDict;
+
+    // Gather info about logical blocks.
+    [self gatherFuncInfos];
+
+    if (gCancel == YES)
+        return NO;
+
+    uint32_t  progCounter = 0;
+    double  progValue   = 0.0;
+
+    progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: NO], PRIndeterminateKey,
+        [NSNumber numberWithDouble: progValue], PRValueKey,
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Generating file", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    FILE*   outFile = NULL;
+
+    // In the CLI target, iOutputFilePath is nil.
+    if (iOutputFilePath)
+        outFile = fopen(UTF8STRING(iOutputFilePath), "w");
+    else
+        outFile = stdout;
+
+    if (!outFile)
+    {
+        perror("otx: unable to open output file");
+        return NO;
+    }
+
+    OutputWriter    writer;
+
+    if (![self openOutputWriter: &writer toFile: outFile withToc: YES])
+    {
+        if (iOutputFilePath)
+            fclose(outFile);
+
+        return NO;
+    }
+
+    Line64* theLine         = iPlainLineListHead;
+    Line64* lastPrinted     = NULL;
+    BOOL    result          = YES;
+
+    // Loop thru lines.
+    while (theLine)
+    {
+        if (!(progCounter % PROGRESS_FREQ))
+        {
+            if (gCancel == YES)
+            {
+                result  = NO;
+                break;
+            }
+
+            progValue   = (double)progCounter / iNumLines * 100;
+            progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+                [NSNumber numberWithDouble: progValue], PRValueKey,
+                nil];
+
+#ifdef OTX_CLI
+            [iController reportProgress: progDict];
+#else
+            [iController performSelectorOnMainThread: @selector(reportProgress:)
+                withObject: progDict waitUntilDone: NO];
+#endif
+
+            [progDict release];
+        }
+
+        // Everything before this function's name line is final, see
+        // streamLines. Hand it to the writer now, so writing overlaps with
+        // processing.
+        if (theLine->info.isCode && theLine->info.isFunction &&
+            theLine->prev && theLine->prev->prev)
+        {
+            if (![self printLinesFrom: (lastPrinted) ? lastPrinted->next : iPlainLineListHead
+                before: theLine->prev toWriter: &writer])
+            {
+                result  = NO;
+                break;
+            }
+
+            lastPrinted = theLine->prev->prev;
+        }
+
+        if (theLine->info.isCode)
+            [self processCodeLine:&theLine];
+        else
+            [self processLine:theLine];
+
+        theLine = theLine->next;
+        progCounter++;
+    }
+
+    // The verbose lines have all been consumed by chooseLine:.
+    [self deleteLinesFromList: iVerboseLineListHead];
+    iVerboseLineListHead    = NULL;
+
+    // Write whatever's left.
+    if (result)
+        result  = [self printLinesFrom: (lastPrinted) ? lastPrinted->next : iPlainLineListHead
+            before: NULL toWriter: &writer];
+
+    result  = [self closeOutputWriter: &writer] && result;
+
+    if (iOutputFilePath)
+    {
+        if (fclose(outFile) != 0)
+        {
+            perror("otx: unable to close output file");
+            return NO;
+        }
+    }
+
+    return result;
+}
+
+//  streamLines
+// ----------------------------------------------------------------------------
+//  Like processLines, but gathers block info, processes and writes one
+//  function at a time. Each function's lines and saved machine states are
+//  freed as soon as they're written, so the output stage only ever holds
+//  one function in memory.
+
+- (BOOL)streamLines
+{
+    FILE*   outFile = NULL;
+
+    // In the CLI target, iOutputFilePath is nil.
+    if (iOutputFilePath)
+        outFile = fopen(UTF8STRING(iOutputFilePath), "w");
+    else
+        outFile = stdout;
+
+    if (!outFile)
+    {
+        perror("otx: unable to open output file");
+        return NO;
+    }
+
+    OutputWriter    writer;
+
+    if (![self openOutputWriter: &writer toFile: outFile withToc: YES])
+    {
+        if (iOutputFilePath)
+            fclose(outFile);
+
+        return NO;
+    }
+
+    uint32_t  progCounter = 0;
+    double  progValue   = 0.0;
+
+    NSMutableDictionary*    progDict    =
+        [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: NO], PRIndeterminateKey,
+        [NSNumber numberWithDouble: progValue], PRValueKey,
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Generating file", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    Line64**    allCodeLines    = iLineArray;
+    uint32_t    numAllCodeLines = iNumCodeLines;
+    uint32_t    codeLineIndex   = 0;
+    SInt64      funcIndex       = -1;
+    BOOL        result          = YES;
+    Line64*     theLine         = iPlainLineListHead;
+
+    // Loop thru lines.
+    while (theLine)
+    {
+        if (!(progCounter % PROGRESS_FREQ))
+        {
+            if (gCancel == YES)
+            {
+                result  = NO;
+                break;
+            }
+
+            progValue   = (double)progCounter / iNumLines * 100;
+            progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+                [NSNumber numberWithDouble: progValue], PRValueKey,
+                nil];
+
+#ifdef OTX_CLI
+            [iController reportProgress: progDict];
+#else
+            [iController performSelectorOnMainThread: @selector(reportProgress:)
+                withObject: progDict waitUntilDone: NO];
+#endif
+
+            [progDict release];
+        }
+
+        if (theLine->info.isCode && theLine->info.isFunction)
+        {
+            // Everything before this function's name line is final. The
+            // name line itself may still be replaced by processCodeLine:.
+            Line64* firstKeptLine   = (theLine->prev) ? theLine->prev : theLine;
+
+            if (theLine->alt && theLine->alt != iVerboseLineListHead)
+                [self deleteLinesBefore: theLine->alt
+                    fromList: &iVerboseLineListHead];
+
+            if (![self printLinesBefore: firstKeptLine
+                fromList: &iPlainLineListHead toWriter: &writer])
+            {
+                result  = NO;
+                break;
+            }
+
+            // The previous function's blocks are no longer needed.
+            if (funcIndex >= 0)
+                [self deleteBlocksFromFuncInfo: &iFuncInfos[funcIndex]];
+
+            funcIndex++;
+
+            // Find the end of this function.
+            Line64*     endLine         = theLine->next;
+            uint32_t    numFuncCodeLines = 1;
+
+            while (endLine && !(endLine->info.isCode && endLine->info.isFunction))
+            {
+                if (endLine->info.isCode)
+                    numFuncCodeLines++;
+
+                endLine = endLine->next;
+            }
+
+            // Limit the epilog search to this function's code lines, since
+            // the ones before it may have been freed already.
+            iLineArray      = &allCodeLines[codeLineIndex];
+            iNumCodeLines   = numFuncCodeLines;
+
+            // Gather info about logical blocks.
+            iCurrentFuncInfoIndex   = funcIndex - 1;
+            [self gatherFuncInfosForFunction: theLine to: endLine];
+
+            iLineArray      = allCodeLines;
+            iNumCodeLines   = numAllCodeLines;
+
+            if (gCancel == YES)
+            {
+                result  = NO;
+                break;
+            }
+        }
+
+        if (theLine->info.isCode)
+        {
+            [self processCodeLine:&theLine];
+
+            codeLineIndex++;
+        }
+        else
+            [self processLine:theLine];
+
+        theLine = theLine->next;
+        progCounter++;
+    }
+
+    // Write whatever's left.
+    if (result)
+        result  = [self printLinesBefore: NULL
+            fromList: &iPlainLineListHead toWriter: &writer];
+
+    result  = [self closeOutputWriter: &writer] && result;
+    iCurrentFuncInfoIndex   = -1;
+
+    if (iOutputFilePath)
+    {
+        if (fclose(outFile) != 0)
+        {
+            perror("otx: unable to close output file");
+            return NO;
+        }
+    }
+
+    return result;
+}
+
+//  findFunctionNamed:
+// ----------------------------------------------------------------------------
+//  Return the first code line of the function whose otool name line reads
+//  inName, like "_main" or "-[Foo bar]", or NULL.
+
+- (Line64*)findFunctionNamed: (const char*)inName
+{
+    size_t  nameLength  = strlen(inName);
+    Line64*     theLine     = iPlainLineListHead;
+
+    for (; theLine; theLine = theLine->next)
+    {
+        if (!theLine->info.isCode || !theLine->info.isFunction ||
+            !theLine->prev || theLine->prev->info.isCode)
+            continue;
+
+        char*   name    = theLine->prev->chars;
+        size_t  length;
+
+        while (*name == '\n')
+            name++;
+
+        length  = strlen(name);
+
+        while (length && (name[length - 1] == '\n' || name[length - 1] == ' '))
+            length--;
+
+        if (length && name[length - 1] == ':')
+            length--;
+
+        if (length == nameLength && !strncmp(name, inName, length))
+            return theLine;
+    }
+
+    return NULL;
+}
+
+//  processRange
+// ----------------------------------------------------------------------------
+//  Like streamLines, but only the functions that overlap the -a address
+//  range, or the one named by -f, get block info, processing and output.
+//  Everything else is skipped.
+
+- (BOOL)processRange
+{
+    UInt64      rangeStart  = iOpts.rangeStart;
+    UInt64      rangeEnd    = iOpts.rangeEnd;
+
+    if (iOpts.functionName)
+    {
+        Line64*     funcLine    = [self findFunctionNamed: iOpts.functionName];
+
+        if (!funcLine)
+        {
+            fprintf(stderr, "otx: no function named %s\n",
+                iOpts.functionName);
+            return NO;
+        }
+
+        rangeStart  = funcLine->info.address;
+        rangeEnd    = rangeStart + 1;
+    }
+
+    FILE*   outFile = NULL;
+
+    // In the CLI target, iOutputFilePath is nil.
+    if (iOutputFilePath)
+        outFile = fopen(UTF8STRING(iOutputFilePath), "w");
+    else
+        outFile = stdout;
+
+    if (!outFile)
+    {
+        perror("otx: unable to open output file");
+        return NO;
+    }
+
+    OutputWriter    writer;
+
+    if (![self openOutputWriter: &writer toFile: outFile withToc: YES])
+    {
+        if (iOutputFilePath)
+            fclose(outFile);
+
+        return NO;
+    }
+
+    Line64**    allCodeLines    = iLineArray;
+    uint32_t    numAllCodeLines = iNumCodeLines;
+    uint32_t    codeLineIndex   = 0;
+    SInt64      funcIndex       = -1;
+    BOOL        result          = YES;
+    BOOL        foundFunction   = NO;
+    Line64*     theLine         = iPlainLineListHead;
+
+    while (theLine)
+    {
+        if (!(theLine->info.isCode && theLine->info.isFunction))
+        {
+            if (theLine->info.isCode)
+                codeLineIndex++;
+
+            theLine = theLine->next;
+            continue;
+        }
+
+        // Addresses only go up from here.
+        if (theLine->info.address >= rangeEnd)
+            break;
+
+        funcIndex++;
+
+        // Find the end of this function.
+        Line64*     endLine         = theLine->next;
+        uint32_t    numFuncCodeLines = 1;
+
+        while (endLine && !(endLine->info.isCode && endLine->info.isFunction))
+        {
+            if (endLine->info.isCode)
+                numFuncCodeLines++;
+
+            endLine = endLine->next;
+        }
+
+        if (endLine && endLine->info.address <= rangeStart)
+        {
+            codeLineIndex  += numFuncCodeLines;
+            theLine         = endLine;
+            continue;
+        }
+
+        foundFunction   = YES;
+
+        // The name lines right before each function belong to it.
+        Line64*     firstLine       = theLine;
+        Line64*     stopLine        = endLine;
+
+        while (firstLine->prev && !firstLine->prev->info.isCode)
+            firstLine   = firstLine->prev;
+
+        while (stopLine && stopLine->prev != theLine &&
+            !stopLine->prev->info.isCode)
+            stopLine    = stopLine->prev;
+
+        // processCodeLine: may replace the name line, so find it again
+        // through the line before it.
+        Line64*     beforeLine      = firstLine->prev;
+
+        iLineArray      = &allCodeLines[codeLineIndex];
+        iNumCodeLines   = numFuncCodeLines;
+
+        // Gather info about logical blocks.
+        iCurrentFuncInfoIndex   = funcIndex - 1;
+        [self gatherFuncInfosForFunction: theLine to: endLine];
+
+        iLineArray      = allCodeLines;
+        iNumCodeLines   = numAllCodeLines;
+
+        if (gCancel == YES)
+        {
+            result  = NO;
+            break;
+        }
+
+        Line64*     procLine        = firstLine;
+
+        while (procLine != stopLine)
+        {
+            if (procLine->info.isCode)
+                [self processCodeLine:&procLine];
+            else
+                [self processLine:procLine];
+
+            procLine    = procLine->next;
+        }
+
+        if (![self printLinesFrom: (beforeLine) ? beforeLine->next : iPlainLineListHead
+            before: stopLine toWriter: &writer])
+            result  = NO;
+
+        // This function's blocks are no longer needed.
+        [self deleteBlocksFromFuncInfo: &iFuncInfos[funcIndex]];
+
+        if (!result)
+            break;
+
+        codeLineIndex  += numFuncCodeLines;
+        theLine         = endLine;
+    }
+
+    result  = [self closeOutputWriter: &writer] && result;
+    iCurrentFuncInfoIndex   = -1;
+
+    if (result && !foundFunction)
+        fprintf(stderr, "otx: no functions in the requested range\n");
+
+    if (iOutputFilePath)
+    {
+        if (fclose(outFile) != 0)
+        {
+            perror("otx: unable to close output file");
+            return NO;
+        }
+    }
+
+    return result;
+}
+
+//  printGraphs
+// ----------------------------------------------------------------------------
+//  Instead of the disassembly, write each function's control flow graph in
+//  the format chosen by the -g or -G option.
+
+- (BOOL)printGraphs
+{
+    FILE*   outFile = NULL;
+
+    // In the CLI target, iOutputFilePath is nil.
+    if (iOutputFilePath)
+        outFile = fopen(UTF8STRING(iOutputFilePath), "w");
+    else
+        outFile = stdout;
+
+    if (!outFile)
+    {
+        perror("otx: unable to open output file");
+        return NO;
+    }
+
+    NSMutableDictionary*    progDict    =
+        [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: YES], PRIndeterminateKey,
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Writing graphs", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    uint32_t    funcIndex   = 0;
+    BOOL        result      = YES;
+    Line64*     theLine     = iPlainLineListHead;
+
+    while (theLine && funcIndex < iNumFuncInfos)
+    {
+        if (!(theLine->info.isCode && theLine->info.isFunction))
+        {
+            theLine = theLine->next;
+            continue;
+        }
+
+        if (gCancel == YES)
+        {
+            result  = NO;
+            break;
+        }
+
+        Line64* endLine = theLine->next;
+
+        while (endLine && !(endLine->info.isCode && endLine->info.isFunction))
+            endLine = endLine->next;
+
+        // The name line is still otool's, e.g. "_main:\n".
+        char    funcName[MAX_LINE_LENGTH];
+
+        if (theLine->prev && !theLine->prev->info.isCode &&
+            theLine->prev->length > 2)
+        {
+            size_t  nameLength  = theLine->prev->length - 1;
+
+            if (theLine->prev->chars[nameLength - 1] == ':')
+                nameLength--;
+
+            nameLength  = MIN(nameLength, MAX_LINE_LENGTH - 1);
+            strncpy(funcName, theLine->prev->chars, nameLength);
+            funcName[nameLength]    = 0;
+        }
+        else if (iFuncInfos[funcIndex].genericFuncNum)
+            snprintf(funcName, MAX_LINE_LENGTH, "%s%d",
+                ANON_FUNC_BASE, iFuncInfos[funcIndex].genericFuncNum);
+        else
+            snprintf(funcName, MAX_LINE_LENGTH, "0x%016llx",
+                theLine->info.address);
+
+        Flow64Graph theGraph;
+
+        if (![self buildGraph: &theGraph forFunction: theLine to: endLine])
+        {
+            result  = NO;
+            break;
+        }
+
+        [self printGraph: &theGraph named: funcName toFile: outFile];
+        [self deleteGraph: &theGraph];
+
+        theLine = endLine;
+        funcIndex++;
+    }
+
+    if (iOutputFilePath)
+    {
+        if (fclose(outFile) != 0)
+        {
+            perror("otx: unable to close output file");
+            return NO;
+        }
+    }
+
+    return result;
+}
+
+//  buildGraph:forFunction:to:
+// ----------------------------------------------------------------------------
+//  Build the control flow graph of the function whose first instruction is
+//  inFuncLine, ending just before inEndLine. One pass over the lines finds
+//  the block leaders- the function's entry, every branch target inside the
+//  function and every line after a branch- and the branches that end
+//  blocks. The leaders are then sorted, and the edges and predecessor lists
+//  follow from them without touching the lines again.
+
+- (BOOL)buildGraph: (Flow64Graph*)outGraph
+       forFunction: (Line64*)inFuncLine
+                to: (Line64*)inEndLine
+{
+    *outGraph   = (Flow64Graph){inFuncLine->info.address, NULL, 0, NULL, 0};
+
+    UInt64*         leaders         = NULL;
+    uint32_t        numLeaders      = 0;
+    UInt64*         branchAddrs     = NULL;
+    Branch64Info*   branches        = NULL;
+    uint32_t        numBranches     = 0;
+    uint32_t        maxItems        = 0;
+    UInt64          funcStart       = inFuncLine->info.address;
+    UInt64          funcEnd         = funcStart;
+    BOOL            startsBlock     = YES;
+    Line64*         theLine;
+    uint32_t        i, j, k;
+
+    for (theLine = inFuncLine; theLine && theLine != inEndLine;
+        theLine = theLine->next)
+    {
+        if (!theLine->info.isCode)
+            continue;
+
+        // Each line adds at most 2 leaders and 1 branch.
+        if (numLeaders + 2 > maxItems || numBranches + 1 > maxItems)
+        {
+            maxItems    = MAX(64, maxItems * 2);
+            leaders     = realloc(leaders, sizeof(UInt64) * maxItems);
+            branchAddrs = realloc(branchAddrs, sizeof(UInt64) * maxItems);
+            branches    = realloc(branches, sizeof(Branch64Info) * maxItems);
+
+            if (!leaders || !branchAddrs || !branches)
+            {
+                fprintf(stderr, "otx: not enough memory for graph\n");
+                free(leaders);
+                free(branchAddrs);
+                free(branches);
+                return NO;
+            }
+        }
+
+        if (startsBlock)
+        {
+            leaders[numLeaders++]   = theLine->info.address;
+            startsBlock             = NO;
+        }
+
+        Branch64Info    theBranch;
+
+        if ([self getBranchInfo: &theBranch forLine: theLine])
+        {
+            branchAddrs[numBranches]    = theLine->info.address;
+            branches[numBranches++]     = theBranch;
+            startsBlock                 = YES;
+
+            if (theBranch.hasTarget && theBranch.target >= funcStart)
+                leaders[numLeaders++]   = theBranch.target;
+        }
+
+        funcEnd = theLine->info.address + theLine->info.codeLength;
+    }
+
+    // Sort the leaders, dropping duplicates and targets outside the
+    // function or in the middle of an instruction.
+    qsort(leaders, numLeaders, sizeof(UInt64),
+        (COMPARISON_FUNC_TYPE)UInt64_Compare);
+
+    uint32_t    numBlocks   = 0;
+
+    for (i = 0; i < numLeaders; i++)
+    {
+        if (leaders[i] >= funcEnd)
+            break;
+
+        if (numBlocks && leaders[i] == leaders[numBlocks - 1])
+            continue;
+
+        Line64  searchKey   = {NULL, 0, NULL, NULL, NULL, {leaders[i], {0}, YES, NO}};
+        Line64* searchKeyPtr = &searchKey;
+
+        if (i && !bsearch(&searchKeyPtr, iLineArray, iNumCodeLines,
+            sizeof(Line64*), (COMPARISON_FUNC_TYPE)Line64_Address_Compare))
+            continue;
+
+        leaders[numBlocks++]    = leaders[i];
+    }
+
+    Flow64Block*    blocks  = calloc(MAX(numBlocks, 1), sizeof(Flow64Block));
+
+    if (!blocks)
+    {
+        fprintf(stderr, "otx: not enough memory for graph\n");
+        free(leaders);
+        free(branchAddrs);
+        free(branches);
+        return NO;
+    }
+
+    for (i = 0; i < numBlocks; i++)
+        blocks[i]   = (Flow64Block){leaders[i],
+            (i + 1 < numBlocks) ? leaders[i + 1] : funcEnd, {-1, -1}, 0, 0};
+
+    // Connect the blocks. Every branch is the last line of its block, and
+    // blocks that don't end in a branch fall through.
+    uint32_t    numPreds    = 0;
+
+    for (i = 0, j = 0; i < numBlocks; i++)
+    {
+        Flow64Block*    theBlock    = &blocks[i];
+
+        while (j < numBranches && branchAddrs[j] < theBlock->beginAddress)
+            j++;
+
+        if (j < numBranches && branchAddrs[j] < theBlock->endAddress)
+        {
+            Branch64Info*   theBranch   = &branches[j];
+
+            if (theBranch->hasTarget)
+            {
+                UInt64*     target  = bsearch(&theBranch->target, leaders,
+                    numBlocks, sizeof(UInt64),
+                    (COMPARISON_FUNC_TYPE)UInt64_Compare);
+
+                if (target)
+                    theBlock->succs[0]  = target - leaders;
+            }
+
+            if (theBranch->fallsThrough && i + 1 < numBlocks)
+                theBlock->succs[1]  = i + 1;
+        }
+        else if (i + 1 < numBlocks)
+            theBlock->succs[1]  = i + 1;
+
+        for (k = 0; k < 2; k++)
+            if (theBlock->succs[k] >= 0)
+            {
+                blocks[theBlock->succs[k]].numPreds++;
+                numPreds++;
+            }
+    }
+
+    // Lay out the predecessor lists back to back.
+    uint32_t*   preds   = malloc(sizeof(uint32_t) * MAX(numPreds, 1));
+
+    if (!preds)
+    {
+        fprintf(stderr, "otx: not enough memory for graph\n");
+        free(blocks);
+        free(leaders);
+        free(branchAddrs);
+        free(branches);
+        return NO;
+    }
+
+    for (i = 0, j = 0; i < numBlocks; i++)
+    {
+        blocks[i].firstPred = j;
+        j                   += blocks[i].numPreds;
+        blocks[i].numPreds  = 0;
+    }
+
+    for (i = 0; i < numBlocks; i++)
+        for (k = 0; k < 2; k++)
+            if (blocks[i].succs[k] >= 0)
+            {
+                Flow64Block*    succ    = &blocks[blocks[i].succs[k]];
+
+                preds[succ->firstPred + succ->numPreds++]   = i;
+            }
+
+    free(leaders);
+    free(branchAddrs);
+    free(branches);
+
+    outGraph->blocks    = blocks;
+    outGraph->numBlocks = numBlocks;
+    outGraph->preds     = preds;
+    outGraph->numPreds  = numPreds;
+
+    return YES;
+}
+
+//  deleteGraph:
+// ----------------------------------------------------------------------------
+
+- (void)deleteGraph: (Flow64Graph*)ioGraph
+{
+    if (ioGraph->blocks)
+        free(ioGraph->blocks);
+
+    if (ioGraph->preds)
+        free(ioGraph->preds);
+
+    *ioGraph    = (Flow64Graph){0};
+}
+
+//  printGraph:named:toFile:
+// ----------------------------------------------------------------------------
+//  Write inGraph as a DOT digraph, or as one line of JSON. Jumps are solid
+//  edges in DOT, fallthroughs are dashed.
+
+- (void)printGraph: (Flow64Graph*)inGraph
+             named: (const char*)inName
+            toFile: (FILE*)outFile
+{
+    uint32_t    i, j;
+
+    if (iOpts.graphFormat == DOTGraph)
+    {
+        fprintf(outFile, "digraph \"");
+        [self printEscapedString: inName toFile: outFile];
+        fprintf(outFile, "\" {\n    node [shape=box];\n");
+
+        for (i = 0; i < inGraph->numBlocks; i++)
+        {
+            Flow64Block*    theBlock    = &inGraph->blocks[i];
+
+            fprintf(outFile, "    b%llx [label=\"0x%016llx - 0x%016llx\"];\n",
+                theBlock->beginAddress, theBlock->beginAddress,
+                theBlock->endAddress);
+
+            if (theBlock->succs[0] >= 0)
+                fprintf(outFile, "    b%llx -> b%llx;\n", theBlock->beginAddress,
+                    inGraph->blocks[theBlock->succs[0]].beginAddress);
+
+            if (theBlock->succs[1] >= 0)
+                fprintf(outFile, "    b%llx -> b%llx [style=dashed];\n",
+                    theBlock->beginAddress,
+                    inGraph->blocks[theBlock->succs[1]].beginAddress);
+        }
+
+        fprintf(outFile, "}\n\n");
+    }
+    else
+    {
+        fprintf(outFile, "{\"function\":\"");
+        [self printEscapedString: inName toFile: outFile];
+        fprintf(outFile, "\",\"address\":%llu,\"blocks\":[",
+            inGraph->address);
+
+        for (i = 0; i < inGraph->numBlocks; i++)
+        {
+            Flow64Block*    theBlock    = &inGraph->blocks[i];
+
+            fprintf(outFile, "%s{\"start\":%llu,\"end\":%llu",
+                (i) ? "," : "", theBlock->beginAddress, theBlock->endAddress);
+
+            if (theBlock->succs[0] >= 0)
+                fprintf(outFile, ",\"jump\":%d", theBlock->succs[0]);
+
+            if (theBlock->succs[1] >= 0)
+                fprintf(outFile, ",\"fallthrough\":%d", theBlock->succs[1]);
+
+            fprintf(outFile, ",\"preds\":[");
+
+            for (j = 0; j < theBlock->numPreds; j++)
+                fprintf(outFile, "%s%u", (j) ? "," : "",
+                    inGraph->preds[theBlock->firstPred + j]);
+
+            fprintf(outFile, "]}");
+        }
+
+        fprintf(outFile, "]}\n");
+    }
+}
+
+//  processLinesInParallel
+// ----------------------------------------------------------------------------
+//  Like processLines, but spreads the functions across all available cores.
+//  The list is cut into one chunk per function, each worker thread claims
+//  the next unclaimed chunk until none are left, and the chunks are stitched
+//  back together in address order before writing. -split always comes
+//  here, since every function must be final before the files are written.
+
+- (BOOL)processLinesInParallel
+{
+    Function64Chunk*    chunks      =
+        calloc(iNumFuncInfos + 1, sizeof(Function64Chunk));
+    uint32_t            numChunks   = 1;
+    SInt64              funcIndex   = -1;
+    Line64*             theLine     = iPlainLineListHead;
+    uint32_t            codeIndex   = 0;
+
+    if (!chunks)
+    {
+        fprintf(stderr, "otx: not enough memory to allocate chunks\n");
+        return NO;
+    }
+
+    // Chunk 0 holds everything before the first function.
+    chunks[0]   = (Function64Chunk){iPlainLineListHead, NULL, NULL, NULL, -1, 0, 0};
+
+    while (theLine)
+    {
+        if (theLine->info.isCode && theLine->info.isFunction &&
+            funcIndex + 1 < iNumFuncInfos)
+        {
+            funcIndex++;
+
+            // Keep the function's name line with it, since processCodeLine:
+            // may replace it.
+            Line64* head    = (theLine->prev && !theLine->prev->info.isCode) ?
+                theLine->prev : theLine;
+
+            if (head == chunks[numChunks - 1].head)
+            {
+                chunks[numChunks - 1].funcLine  = theLine;
+                chunks[numChunks - 1].funcIndex = funcIndex;
+            }
+            else
+            {
+                chunks[numChunks - 1].end           = head;
+                chunks[numChunks - 1].numCodeLines  =
+                    codeIndex - chunks[numChunks - 1].firstCodeLine;
+                chunks[numChunks++]                 = (Function64Chunk)
+                    {head, theLine, NULL, head->prev, funcIndex, codeIndex, 0};
+            }
+        }
+
+        if (theLine->info.isCode)
+            codeIndex++;
+
+        theLine = theLine->next;
+    }
+
+    chunks[numChunks - 1].numCodeLines  =
+        codeIndex - chunks[numChunks - 1].firstCodeLine;
+
+    // Cut the list into chunks. A worker can only reach its own chunk's
+    // lines, so epilog searches and the like stop at the function's end.
+    uint32_t    i;
+
+    for (i = 1; i < numChunks; i++)
+    {
+        chunks[i].tail->next    = NULL;
+        chunks[i].head->prev    = NULL;
+    }
+
+    NSMutableDictionary*    progDict    =
+        [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: NO], PRIndeterminateKey,
+        [NSNumber numberWithDouble: 0.0], PRValueKey,
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Generating file", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    // Each worker gets its own copy of this processor for register state
+    // and scratch buffers.
+    NSUInteger          numWorkers  =
+        [[NSProcessInfo processInfo] activeProcessorCount];
+    dispatch_queue_t    queue       =
+        dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_t    group       = dispatch_group_create();
+    int32_t             nextChunk   = -1;
+    int32_t             chunksDone  = 0;
+    int32_t*            nextChunkP  = &nextChunk;
+    int32_t*            chunksDoneP = &chunksDone;
+    uint32_t            baseMatched = iMatchedSelectorCount;
+    uint32_t            baseMissed  = iMissedSelectorCount;
+    uint32_t            basePasses  = iGatherPasses;
+    uint32_t            baseVisits  = iBlockVisits;
+    UInt64              baseComment = iCommentTicks;
+    UInt64              baseRegs    = iRegistersTicks;
+    uint32_t            baseTimed   = iTimedLines;
+
+    if (numWorkers > numChunks)
+        numWorkers  = numChunks;
+
+    for (i = 0; i < numWorkers; i++)
+    {
+        // Blocks don't retain __block objects, so disposeWorker is safe.
+        __block Exe64Processor* worker  = [self newWorker];
+
+        dispatch_group_async(group, queue,
+        ^{
+            int32_t chunkIndex;
+
+            while (gCancel == NO &&
+                (chunkIndex = OSAtomicIncrement32(nextChunkP)) < (int32_t)numChunks)
+            {
+                [worker processChunk: &chunks[chunkIndex]];
+                OSAtomicIncrement32(chunksDoneP);
+            }
+
+            OSAtomicAdd32Barrier(worker->iMatchedSelectorCount - baseMatched,
+                (int32_t*)&iMatchedSelectorCount);
+            OSAtomicAdd32Barrier(worker->iMissedSelectorCount - baseMissed,
+                (int32_t*)&iMissedSelectorCount);
+            OSAtomicAdd32Barrier(worker->iGatherPasses - basePasses,
+                (int32_t*)&iGatherPasses);
+            OSAtomicAdd32Barrier(worker->iBlockVisits - baseVisits,
+                (int32_t*)&iBlockVisits);
+            OSAtomicAdd64Barrier(worker->iCommentTicks - baseComment,
+                (int64_t*)&iCommentTicks);
+            OSAtomicAdd64Barrier(worker->iRegistersTicks - baseRegs,
+                (int64_t*)&iRegistersTicks);
+            OSAtomicAdd32Barrier(worker->iTimedLines - baseTimed,
+                (int32_t*)&iTimedLines);
+
+            @synchronized (self)
+            {
+                [self mergeXrefsFrom: worker];
+                [self mergeRecordsFrom: worker];
+            }
+
+            [worker disposeWorker];
+        });
+    }
+
+    // Report progress until the workers are done.
+    while (dispatch_group_wait(group,
+        dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC / 10)))
+    {
+        progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+            [NSNumber numberWithDouble: (double)chunksDone / numChunks * 100],
+            PRValueKey,
+            nil];
+
+#ifdef OTX_CLI
+        [iController reportProgress: progDict];
+#else
+        [iController performSelectorOnMainThread: @selector(reportProgress:)
+            withObject: progDict waitUntilDone: NO];
+#endif
+
+        [progDict release];
+    }
+
+    dispatch_release(group);
+
+    // Stitch the chunks back together, including any name lines that were
+    // inserted before their heads.
+    for (i = 1; i < numChunks; i++)
+    {
+        chunks[i].tail->next    = chunks[i].head;
+        chunks[i].head->prev    = chunks[i].tail;
+    }
+
+    iPlainLineListHead      = chunks[0].head;
+    iCurrentFuncInfoIndex   = -1;
+    free(chunks);
+
+    if (gCancel == YES)
+        return NO;
+
+    // The verbose lines have all been consumed by chooseLine:.
+    [self deleteLinesFromList: iVerboseLineListHead];
+    iVerboseLineListHead    = NULL;
+
+    progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+        [NSNumber numberWithBool: YES], PRIndeterminateKey,
+        [NSNumber numberWithBool: YES], PRNewLineKey,
+        @"Writing file", PRDescriptionKey,
+        nil];
+
+#ifdef OTX_CLI
+    [iController reportProgress: progDict];
+#else
+    [iController performSelectorOnMainThread: @selector(reportProgress:)
+        withObject: progDict waitUntilDone: NO];
+#endif
+
+    [progDict release];
+
+    // Create output file, or a directory of them for -split.
+    if (iOpts.splitPath)
+        return [self printLinesToDirectory: &iPlainLineListHead];
+
+    if (![self printLinesFromList: iPlainLineListHead])
+    {
+        return NO;
+    }
+
+    return YES;
+}
+
+//  processChunk:
+// ----------------------------------------------------------------------------
+//  Gather block info for one chunk's function, then process its lines. Runs
+//  on a worker thread, see processLinesInParallel. Only the chunk's own
+//  code lines are searched, so a branch out of the function adds its block
+//  without flagging another chunk's line. That flag would never be used,
+//  since lines only look for blocks in their own function.
+
+- (void)processChunk: (Function64Chunk*)ioChunk
+{
+    Line64**    allCodeLines    = iLineArray;
+    uint32_t    numAllCodeLines = iNumCodeLines;
+
+    iLineArray              = &allCodeLines[ioChunk->firstCodeLine];
+    iNumCodeLines           = ioChunk->numCodeLines;
+    iPlainLineListHead      = ioChunk->head;
+    iCurrentFuncInfoIndex   = ioChunk->funcIndex - 1;
+
+    if (ioChunk->funcLine)
+    {
+        // Gather info about logical blocks.
+        [self gatherFuncInfosForFunction: ioChunk->funcLine to: ioChunk->end];
+    }
+
+    Line64* theLine = ioChunk->head;
+
+    while (theLine && theLine != ioChunk->end)
+    {
+        if (theLine->info.isCode)
+            [self processCodeLine:&theLine];
+        else
+            [self processLine:theLine];
+
+        theLine = theLine->next;
+    }
+
+    // processCodeLine: may have inserted a name line before the head.
+    ioChunk->head   = iPlainLineListHead;
+    iLineArray      = allCodeLines;
+    iNumCodeLines   = numAllCodeLines;
+}
+
+//  newWorker
+// ----------------------------------------------------------------------------
+//  Return a copy of this processor for use on a worker thread. The copy
+//  shares everything loaded from the executable, but has its own register
+//  state and scratch buffers. Create it before any registers are tracked,
+//  and destroy it with disposeWorker, never release.
+
+- (id)newWorker
+{
+    Exe64Processor* worker  = object_copy(self, 0);
+
+    // The verbose lines are freed by this thread, see chooseLine:.
+    worker->iVerboseLineListHead    = NULL;
+
+    // Don't share our xref buffers.
+    worker->iXrefs              = NULL;
+    worker->iNumXrefs           = 0;
+    worker->iMaxXrefs           = 0;
+    worker->iXrefFuncs          = NULL;
+    worker->iNumXrefFuncs       = 0;
+    worker->iMaxXrefFuncs       = 0;
+    worker->iXrefStrings.chunks = NULL;
+
+    // Nor our columnar records.
+    worker->iInsnRecords            = NULL;
+    worker->iNumInsnRecords         = 0;
+    worker->iMaxInsnRecords         = 0;
+    worker->iFuncRecords            = NULL;
+    worker->iNumFuncRecords         = 0;
+    worker->iMaxFuncRecords         = 0;
+    worker->iRecordStrings.chunks   = NULL;
+
+    return worker;
+}
+
+//  disposeWorker
+// ----------------------------------------------------------------------------
+//  Subclasses free their own per-worker allocations, then call super.
+
+- (void)disposeWorker
+{
+    object_dispose(self);
+}
+
+//  gatherFuncInfos
+// ----------------------------------------------------------------------------
+//  Gather block info for every function in the list.
+
+- (void)gatherFuncInfos
+{
+    Line64*   theLine = iPlainLineListHead;
+
+    iCurrentFuncInfoIndex   = -1;
+
+    while (theLine)
+    {
+        if (!(theLine->info.isCode && theLine->info.isFunction))
+        {
+            theLine = theLine->next;
+            continue;
+        }
+
+        // Find the end of this function.
+        Line64* endLine = theLine->next;
+
+        while (endLine && !(endLine->info.isCode && endLine->info.isFunction))
+            endLine = endLine->next;
+
+        // With -incremental, functions that haven't changed since the last
+        // run reuse its results instead, see processCodeLine:.
+        if (iOpts.incrementalPath && [self hashFunction: theLine to: endLine])
+            iNumReusedFuncs++;
+        else
+            [self gatherFuncInfosForFunction: theLine to: endLine];
+
+        if (gCancel == YES)
+            break;
+
+        iCurrentFuncInfoIndex++;
+        theLine = endLine;
+    }
+
+    iCurrentFuncInfoIndex   = -1;
+}
+
+//  gatherFuncInfosForFunction:to:
+// ----------------------------------------------------------------------------
+//  Gather block info for the function whose first line is inFuncLine, up to
+//  but not including inEndLine. iCurrentFuncInfoIndex must be the index of
+//  the previous function, and is left that way.
+//
+//  The first pass runs through the whole function. If a backward branch
+//  changed the saved state of a block that was already visited, the next
+//  pass starts from the earliest such block, and so on until no block
+//  changes or MAX_GATHER_PASSES is reached. Functions with no backward
+//  branches are done after one pass.
+
+- (void)gatherFuncInfosForFunction: (Line64*)inFuncLine
+                                to: (Line64*)inEndLine
+{
+    SInt64      prevFuncIndex   = iCurrentFuncInfoIndex;
+    Line64*     startLine       = inFuncLine;
+    uint32_t    pass;
+
+    for (pass = 0; pass < MAX_GATHER_PASSES; pass++)
+    {
+        iBlockStateChanged      = NO;
+        iCurrentFuncInfoIndex   = prevFuncIndex;
+
+        // When starting mid-function, begin from the function's entry
+        // state. The block's saved state is restored when we reach it.
+        if (startLine != inFuncLine)
+        {
+            iCurrentFuncPtr = inFuncLine->info.address;
+            [self resetRegisters: inFuncLine];
+        }
+
+        [self gatherFuncInfosFrom: startLine to: inEndLine];
+
+        iGatherPasses++;
+
+        if (gCancel == YES || !iBlockStateChanged)
+            break;
+
+        // Find the first line of the earliest changed block.
+        Line64  searchKey = {NULL, 0, NULL, NULL, NULL,
+            {iChangedBlockAddress, {0}, YES, NO}};
+        Line64*     searchKeyPtr = &searchKey;
+        Line64**    changedLine = bsearch(&searchKeyPtr, iLineArray,
+            iNumCodeLines, sizeof(Line64*),
+            (COMPARISON_FUNC_TYPE)Line64_Address_Compare);
+
+        if (!changedLine)
+            break;
+
+        startLine   = *changedLine;
+    }
+
+    iCurrentFuncInfoIndex   = prevFuncIndex;
+}
+
+//  hashFunction:to:
+// ----------------------------------------------------------------------------
+//  Digest the function whose first line is inFuncLine, up to but not
+//  including inEndLine, into its FunctionInfo's incHash for -incremental.
+//  See FunctionHash_AddLine for what the hash does and doesn't cover. Return
+//  YES if the last run saw the same function.
+
+- (BOOL)hashFunction: (Line64*)inFuncLine
+                  to: (Line64*)inEndLine
+{
+    Function64Info  searchKey   = {inFuncLine->info.address, NULL, 0, 0};
+    Function64Info* funcInfo    = bsearch(&searchKey,
+        iFuncInfos, iNumFuncInfos, sizeof(Function64Info),
+        (COMPARISON_FUNC_TYPE)Function64_Info_Compare);
+
+    if (!funcInfo)
+        return NO;
+
+    Line64* theLine;
+
+    UInt64          funcStart   = inFuncLine->info.address;
+    UInt64          textStart   = iLineArray[0]->info.address;
+    UInt64          textEnd     = iLineArray[iNumCodeLines - 1]->info.address +
+        iLineArray[iNumCodeLines - 1]->info.codeLength;
+    uint32_t        numLines    = 0;
+    UInt8           digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_CTX   context;
+
+    CC_SHA256_Init(&context);
+
+    // otool's label, when there is one, says which class a method is in.
+    if (inFuncLine->prev && !inFuncLine->prev->info.isCode)
+        CC_SHA256_Update(&context, inFuncLine->prev->chars,
+            inFuncLine->prev->length);
+
+    for (theLine = inFuncLine; theLine != inEndLine; theLine = theLine->next)
+    {
+        if (!theLine->info.isCode)
+            continue;
+
+        // Prefer the verbose line, its comments name the callees.
+        const char* theText = (theLine->alt) ?
+            theLine->alt->chars : theLine->chars;
+        const char* theTab  = strchr(theText, '\t');
+
+        UInt64      dataAddys[FUNCTION_HASH_MAX_DATA];
+        uint32_t    numAddys    = FunctionHash_AddLine(&context,
+            (theTab) ? theTab + 1 : theText,
+            theLine->info.address - funcStart,
+            theLine->info.address + theLine->info.codeLength, funcStart,
+            textStart, textEnd, dataAddys);
+        uint32_t    i;
+
+        for (i = 0; i < numAddys; i++)
+            [self hashDataAt: dataAddys[i] into: &context];
+
+        numLines++;
+    }
+
+    CC_SHA256_Update(&context, &numLines, sizeof(numLines));
+    CC_SHA256_Final(digest, &context);
+
+    memcpy(funcInfo->incHash, digest, INCREMENTAL_HASH_LENGTH);
+
+    return ([self findIncrementalFunc: funcInfo->incHash] != NULL);
+}
+
+//  hashDataAt:into:
+// ----------------------------------------------------------------------------
+//  Add the data at inAddress to ioContext for hashFunction:to:, as the
+//  comments see it: its symbol's name, and the string, selector or constant
+//  getPointer:type: finds there. A %rip target hashes as its address only
+//  when it resolves to neither, so moved data still matches.
+
+- (void)hashDataAt: (UInt64)inAddress
+              into: (CC_SHA256_CTX*)ioContext
+{
+    UInt8   theType = PointerType;
+    char*   theName = [self findSymbolByAddress: inAddress];
+    char*   theData = [self getPointer: inAddress type: &theType];
+    size_t  length  = 0;
+
+    if (theName)
+        CC_SHA256_Update(ioContext, theName, strlen(theName) + 1);
+
+    if (theData)
+    {
+        switch (theType)
+        {
+            case FloatType:
+                length  = sizeof(float);
+                break;
+
+            case DoubleType:
+                length  = sizeof(double);
+                break;
+
+            case DataGenericType:
+            case DataConstType:
+            case DYLDType:
+            case NLSymType:
+            case ImpPtrType:
+                length  = sizeof(UInt64);
+                break;
+
+            case CFStringType:
+            case OCStrObjectType:
+            case OCGenericType:
+                if (![self getObjcDescription: &theData fromObject: theData
+                    type: theType])
+                    break;
+
+                length  = strlen(theData);
+                break;
 
-    if (iLineArray)
-    {
-        free(iLineArray);
-        iLineArray = NULL;
-    }
+            default:
+                length  = strlen(theData);
+                break;
+        }
 
-    [self deleteFuncInfos];
-    [self deleteLinesFromList: iPlainLineListHead];
-    [self deleteLinesFromList: iVerboseLineListHead];
+        CC_SHA256_Update(ioContext, &theType, sizeof(theType));
 
-    [super dealloc];
+        if (length)
+            CC_SHA256_Update(ioContext, theData, length);
+    }
+    else if (!theName)
+        CC_SHA256_Update(ioContext, &inAddress, sizeof(inAddress));
 }
 
-//  deleteFuncInfos
+//  updateBlock:withInfo:fromLine:numRegs:
 // ----------------------------------------------------------------------------
-
-- (void)deleteFuncInfos
+//  Store inInfo in ioBlock. If ioBlock already has a state, another path
+//  reaches it too, and the new state is the meet of both, see
+//  meetState:withState:numRegs:intoRegs:. The meet only ever loses
+//  information, so repeated passes settle. inInfo's state may point to
+//  live registers, so it's copied into the function's arena, unless it
+//  matches the block's old state or the last one saved in this function,
+//  in which case that copy is shared. If the state changed, and the block
+//  begins inside the current function at or before inLine, this pass has
+//  already been through the block without it, so flag it for
+//  gatherFuncInfosForFunction:to: to revisit.
+
+- (void)updateBlock: (Block64Info*)ioBlock
+           withInfo: (Block64Info*)inInfo
+           fromLine: (Line64*)inLine
+            numRegs: (uint32_t)inNumRegs
 {
-    if (!iFuncInfos)
-        return;
-
-    uint32_t          i;
-    uint32_t          j;
-    Function64Info* funcInfo;
-    Block64Info*    blockInfo;
+    Function64Info*     funcInfo    = &iFuncInfos[iCurrentFuncInfoIndex];
+    Machine64State      savedState  = ioBlock->state;
+    Machine64State      meetResult  = inInfo->state;
+    Machine64State*     newState    = &meetResult;
+    GP64RegisterInfo    meetRegs[MAX_SAVED_REGISTERS];
+
+    meetResult.validRegs    = GP64RegisterInfos_ValidMask(
+        meetResult.regInfos, inNumRegs);
+
+    // A block that already has a state is a join point. Keep only what
+    // every path into it agrees on.
+    if (savedState.regInfos)
+        meetResult  = [self meetState: &savedState withState: &meetResult
+            numRegs: inNumRegs intoRegs: meetRegs];
+
+    if (![self machineState: &savedState isEqualTo: newState
+        numRegs: inNumRegs])
+    {
+        if (inInfo->beginAddress > funcInfo->address &&
+            inInfo->beginAddress <= inLine->info.address)
+        {
+            if (!iBlockStateChanged ||
+                inInfo->beginAddress < iChangedBlockAddress)
+                iChangedBlockAddress    = inInfo->beginAddress;
 
-    for (i = 0; i < iNumFuncInfos; i++)
-    {
-        funcInfo    = &iFuncInfos[i];
+            iBlockStateChanged  = YES;
+        }
 
-        if (funcInfo->blocks)
+        if ([self machineState: &funcInfo->lastState isEqualTo: newState
+            numRegs: inNumRegs])
+            savedState  = funcInfo->lastState;
+        else
         {
-            for (j = 0; j < funcInfo->numBlocks; j++)
-            {
-                blockInfo   = &funcInfo->blocks[j];
+            savedState          = *newState;
+            savedState.regInfos = [self allocFromArena: &funcInfo->stateArena
+                size: sizeof(GP64RegisterInfo) * inNumRegs];
+            memcpy(savedState.regInfos, newState->regInfos,
+                sizeof(GP64RegisterInfo) * inNumRegs);
 
-                if (blockInfo->state.regInfos)
-                {
-                    free(blockInfo->state.regInfos);
-                    blockInfo->state.regInfos   = NULL;
-                }
+            if (newState->localSelves)
+            {
+                savedState.localSelves  = [self allocFromArena:
+                    &funcInfo->stateArena
+                    size: sizeof(Var64Info) * newState->numLocalSelves];
+                memcpy(savedState.localSelves, newState->localSelves,
+                    sizeof(Var64Info) * newState->numLocalSelves);
+            }
 
-                if (blockInfo->state.localSelves)
-                {
-                    free(blockInfo->state.localSelves);
-                    blockInfo->state.localSelves    = NULL;
-                }
+            if (newState->localVars)
+            {
+                savedState.localVars    = [self allocFromArena:
+                    &funcInfo->stateArena
+                    size: sizeof(Var64Info) * newState->numLocalVars];
+                memcpy(savedState.localVars, newState->localVars,
+                    sizeof(Var64Info) * newState->numLocalVars);
             }
 
-            free(funcInfo->blocks);
-            funcInfo->blocks    = NULL;
+            funcInfo->lastState = savedState;
         }
     }
 
-    free(iFuncInfos);
-    iFuncInfos  = NULL;
+    *ioBlock        = *inInfo;
+    ioBlock->state  = savedState;
 }
 
-#pragma mark -
-//  processExe:
+//  findBlockAtAddress:inFunction:
 // ----------------------------------------------------------------------------
-//  The master processing method, designed to be executed in a separate thread.
+//  Return the block that begins at inAddress, or NULL. Blocks are kept in
+//  address order by addBlockAtAddress:toFunction:.
 
-- (BOOL)processExe: (NSString*)inOutputFilePath
+- (Block64Info*)findBlockAtAddress: (UInt64)inAddress
+                        inFunction: (Function64Info*)inFuncInfo
 {
-    if (!iFileArchMagic)
-    {
-        fprintf(stderr, "otx: tried to process non-machO file\n");
-        return NO;
-    }
-
-    iOutputFilePath = inOutputFilePath;
-    iMachHeaderPtr  = NULL;
-
-    if (![self loadMachHeader])
-    {
-        fprintf(stderr, "otx: failed to load mach header\n");
-        return NO;
-    }
-
-    [self loadLCommands];
+    if (!inFuncInfo->blocks)
+        return NULL;
 
-    NSMutableDictionary*    progDict    =
-        [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-        [NSNumber numberWithBool: YES], PRNewLineKey,
-        @"Calling otool", PRDescriptionKey,
-        nil];
+    Block64Info searchKey   = {inAddress, NULL, NO, {0}};
 
-#ifdef OTX_CLI
-    [iController reportProgress: progDict];
-#else
-    [iController performSelectorOnMainThread: @selector(reportProgress:)
-        withObject: progDict waitUntilDone: NO];
-#endif
+    return bsearch(&searchKey, inFuncInfo->blocks, inFuncInfo->numBlocks,
+        sizeof(Block64Info),
+        (COMPARISON_FUNC_TYPE)Block64Info_Address_Compare);
+}
 
-    [progDict release];
+//  addBlockAtAddress:toFunction:
+// ----------------------------------------------------------------------------
+//  Insert an empty block that begins at inAddress, keeping the function's
+//  blocks in address order, and flag the line it begins at. Pointers into
+//  the function's blocks are invalid after this.
 
-    [self populateLineLists];
+- (Block64Info*)addBlockAtAddress: (UInt64)inAddress
+                       toFunction: (Function64Info*)ioFuncInfo
+{
+    uint32_t    low     = 0;
+    uint32_t    high    = ioFuncInfo->numBlocks;
 
-    if (gCancel == YES)
-        return NO;
+    // Find the insertion point.
+    while (low < high)
+    {
+        uint32_t    mid = (low + high) / 2;
 
-    progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-        [NSNumber numberWithBool: YES], PRNewLineKey,
-        @"Gathering info", PRDescriptionKey,
-        nil];
+        if (ioFuncInfo->blocks[mid].beginAddress < inAddress)
+            low     = mid + 1;
+        else
+            high    = mid;
+    }
 
-#ifdef OTX_CLI
-    [iController reportProgress: progDict];
-#else
-    [iController performSelectorOnMainThread: @selector(reportProgress:)
-        withObject: progDict waitUntilDone: NO];
-#endif
+    ioFuncInfo->numBlocks++;
+    ioFuncInfo->blocks  = realloc(ioFuncInfo->blocks,
+        sizeof(Block64Info) * ioFuncInfo->numBlocks);
+    memmove(&ioFuncInfo->blocks[low + 1], &ioFuncInfo->blocks[low],
+        sizeof(Block64Info) * (ioFuncInfo->numBlocks - low - 1));
 
-    [progDict release];
+    Block64Info*    newBlock    = &ioFuncInfo->blocks[low];
 
-    // Gather info about lines while they're virgin.
-    [self gatherLineInfos];
+    *newBlock   = (Block64Info){0};
+    newBlock->beginAddress  = inAddress;
 
-    if (gCancel == YES)
-        return NO;
+    // Flag the block's first line, so restoreRegisters: can skip the
+    // search for all the others.
+    Line64  searchKey = {NULL, 0, NULL, NULL, NULL, {inAddress, {0}, YES, NO}};
+    Line64*     searchKeyPtr = &searchKey;
+    Line64**    beginLine = bsearch(&searchKeyPtr, iLineArray,
+        iNumCodeLines, sizeof(Line64*),
+        (COMPARISON_FUNC_TYPE)Line64_Address_Compare);
 
-    // Find functions and allocate funcInfo's.
-    [self findFunctions];
+    if (beginLine)
+        (*beginLine)->info.startsBlock  = YES;
 
-    if (gCancel == YES)
-        return NO;
+    return newBlock;
+}
 
-    // Gather info about logical blocks. The second pass applies info
-    // for backward branches.
-    [self gatherFuncInfos];
+//  machineState:isEqualTo:numRegs:
+// ----------------------------------------------------------------------------
+//  Compare two saved states register by register, see GP64RegisterInfos_Equal.
 
-    if (gCancel == YES)
+- (BOOL)machineState: (Machine64State*)inState1
+           isEqualTo: (Machine64State*)inState2
+             numRegs: (uint32_t)inNumRegs
+{
+    if (!inState1->regInfos || !inState2->regInfos)
+        return inState1->regInfos == inState2->regInfos;
+
+    if (inState1->validRegs != inState2->validRegs ||
+        inState1->numLocalSelves != inState2->numLocalSelves ||
+        inState1->numLocalVars != inState2->numLocalVars ||
+        !inState1->localSelves != !inState2->localSelves ||
+        !inState1->localVars != !inState2->localVars)
         return NO;
 
-    [self gatherFuncInfos];
+    uint32_t    i;
 
-    if (gCancel == YES)
-        return NO;
+    for (i = 0; i < inNumRegs; i++)
+    {
+        if (!GP64RegisterInfos_Equal(&inState1->regInfos[i],
+            &inState2->regInfos[i]))
+            return NO;
+    }
 
-    uint32_t  progCounter = 0;
-    double  progValue   = 0.0;
+    for (i = 0; inState1->localSelves && i < inState1->numLocalSelves; i++)
+    {
+        if (inState1->localSelves[i].offset !=
+            inState2->localSelves[i].offset ||
+            !GP64RegisterInfos_Equal(&inState1->localSelves[i].regInfo,
+            &inState2->localSelves[i].regInfo))
+            return NO;
+    }
 
-    progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-        [NSNumber numberWithBool: NO], PRIndeterminateKey,
-        [NSNumber numberWithDouble: progValue], PRValueKey,
-        [NSNumber numberWithBool: YES], PRNewLineKey,
-        @"Generating file", PRDescriptionKey,
-        nil];
+    for (i = 0; inState1->localVars && i < inState1->numLocalVars; i++)
+    {
+        if (inState1->localVars[i].offset !=
+            inState2->localVars[i].offset ||
+            !GP64RegisterInfos_Equal(&inState1->localVars[i].regInfo,
+            &inState2->localVars[i].regInfo))
+            return NO;
+    }
 
-#ifdef OTX_CLI
-    [iController reportProgress: progDict];
-#else
-    [iController performSelectorOnMainThread: @selector(reportProgress:)
-        withObject: progDict waitUntilDone: NO];
-#endif
+    return YES;
+}
 
-    [progDict release];
+//  meetState:withState:numRegs:intoRegs:
+// ----------------------------------------------------------------------------
+//  Return the meet of two states. Registers and local variables that hold
+//  the same value in both stay valid, and all the others become invalid.
+//  The result's registers are written to outRegs. Its local variables may
+//  be either input's, see meetVars:count:withVars:count:, and
+//  updateBlock:withInfo:fromLine:numRegs: copies them if they're kept.
+
+- (Machine64State)meetState: (Machine64State*)inState1
+                  withState: (Machine64State*)inState2
+                    numRegs: (uint32_t)inNumRegs
+                   intoRegs: (GP64RegisterInfo*)outRegs
+{
+    Machine64State  result      = *inState1;
+    uint64_t        validRegs   = inState1->validRegs & inState2->validRegs;
+    uint32_t        i;
 
-    Line64* theLine = iPlainLineListHead;
+    memcpy(outRegs, inState1->regInfos, sizeof(GP64RegisterInfo) * inNumRegs);
 
-    // Loop thru lines.
-    while (theLine)
+    // Registers that disagree become unknown.
+    for (i = 0; i < inNumRegs; i++)
     {
-        if (!(progCounter % PROGRESS_FREQ))
+        if (!GP64RegisterInfos_Equal(&inState1->regInfos[i],
+            &inState2->regInfos[i]))
         {
-            if (gCancel == YES)
-                return NO;
-
-            progValue   = (double)progCounter / iNumLines * 100;
-            progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-                [NSNumber numberWithDouble: progValue], PRValueKey,
-                nil];
-
-#ifdef OTX_CLI
-            [iController reportProgress: progDict];
-#else
-            [iController performSelectorOnMainThread: @selector(reportProgress:)
-                withObject: progDict waitUntilDone: NO];
-#endif
-
-            [progDict release];
+            validRegs   &= ~(1ULL << i);
+            outRegs[i]  = (GP64RegisterInfo){0};
         }
+    }
 
-        if (theLine->info.isCode)
-        {
-            [self processCodeLine:&theLine];
+    result.regInfos     = outRegs;
+    result.validRegs    = validRegs;
 
-            if (iOpts.entabOutput)
-                [self entabLine:theLine];
-        }
-        else
-            [self processLine:theLine];
+    // A path that hasn't saved self anywhere yet doesn't contradict one that
+    // has, so carry the other side's local selves across.
+    if (!inState1->localSelves || !inState2->localSelves)
+    {
+        Machine64State* selvesState =
+            (inState1->localSelves) ? inState1 : inState2;
 
-        theLine = theLine->next;
-        progCounter++;
+        result.localSelves      = selvesState->localSelves;
+        result.numLocalSelves   = selvesState->numLocalSelves;
     }
+    else
+        result.localSelves  = [self meetVars: inState1->localSelves
+            count: inState1->numLocalSelves withVars: inState2->localSelves
+            count: inState2->numLocalSelves];
 
-    if (gCancel == YES)
-        return NO;
+    result.localVars    = [self meetVars: inState1->localVars
+        count: inState1->numLocalVars withVars: inState2->localVars
+        count: inState2->numLocalVars];
 
-    progDict    = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-        [NSNumber numberWithBool: YES], PRIndeterminateKey,
-        [NSNumber numberWithBool: YES], PRNewLineKey,
-        @"Writing file", PRDescriptionKey,
-        nil];
+    return result;
+}
 
-#ifdef OTX_CLI
-    [iController reportProgress: progDict];
-#else
-    [iController performSelectorOnMainThread: @selector(reportProgress:)
-        withObject: progDict waitUntilDone: NO];
-#endif
+//  meetVars:count:withVars:count:
+// ----------------------------------------------------------------------------
+//  Return inVars1 with each variable that inVars2 doesn't hold with the same
+//  value at the same offset invalidated. That's usually just one of the
+//  inputs, which is returned as is. Otherwise the result is allocated from
+//  the current function's arena.
+
+- (Var64Info*)meetVars: (Var64Info*)inVars1
+                 count: (uint32_t)inCount1
+              withVars: (Var64Info*)inVars2
+                 count: (uint32_t)inCount2
+{
+    if (!inVars1)
+        return NULL;
 
-    [progDict release];
+    BOOL        sameAsVars1 = YES;
+    BOOL        sameAsVars2 = (inVars2 && inCount1 == inCount2);
+    uint32_t    i;
 
-    // Create output file.
-    if (![self printLinesFromList: iPlainLineListHead])
+    for (i = 0; i < inCount1; i++)
     {
-        return NO;
-    }
+        GP64RegisterInfo    meetReg =
+            Var64Info_Meet(&inVars1[i], inVars2, inCount2);
 
-    if (iOpts.dataSections)
-    {
-        if (![self printDataSections])
-        {
-            return NO;
-        }
+        if (!GP64RegisterInfos_Equal(&meetReg, &inVars1[i].regInfo))
+            sameAsVars1 = NO;
+
+        if (sameAsVars2 && (inVars2[i].offset != inVars1[i].offset ||
+            !GP64RegisterInfos_Equal(&meetReg, &inVars2[i].regInfo)))
+            sameAsVars2 = NO;
     }
 
-    progDict = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-        [NSNumber numberWithBool: YES], PRCompleteKey,
-        nil];
+    if (sameAsVars1)
+        return inVars1;
 
-#ifdef OTX_CLI
-    [iController reportProgress: progDict];
-#else
-    [iController performSelectorOnMainThread: @selector(reportProgress:)
-        withObject: progDict waitUntilDone: NO];
-#endif
+    if (sameAsVars2)
+        return inVars2;
 
-    [progDict release];
+    Var64Info*  result  = [self allocFromArena:
+        &iFuncInfos[iCurrentFuncInfoIndex].stateArena
+        size: sizeof(Var64Info) * inCount1];
 
-    return YES;
+    for (i = 0; i < inCount1; i++)
+    {
+        result[i]           = inVars1[i];
+        result[i].regInfo   = Var64Info_Meet(&inVars1[i], inVars2, inCount2);
+    }
+
+    return result;
 }
 
 //  populateLineLists
@@ -496,7 +2232,126 @@
         iNumLines++;
     }
 
-    iEndOfText  = iTextSect.s.addr + iTextSect.s.size;
+    iEndOfText  = iTextSect.s.addr + iTextSect.s.size;
+}
+
+//  buildFunctionStarts
+// ----------------------------------------------------------------------------
+//  Collect every address known to start a function: dyld helpers, Obj-C
+//  method IMPs, nlist symbols, get_pc_thunk routines, direct call targets
+//  in __text and the LC_FUNCTION_STARTS table. The result is sorted and
+//  unique, so lineIsFunction: can check them all with one bsearch.
+
+- (void)buildFunctionStarts
+{
+    const UInt8*    startsData  = NULL;
+    const UInt8*    startsEnd   = NULL;
+    uint32_t        maxStarts   = 2 + iNumClassMethodInfos +
+        iNumFuncSyms + iNumThunks + iNumLines;
+    uint32_t        i;
+
+    if (iFuncStartsSize)
+    {
+        startsData  = (UInt8*)iMachHeaderPtr + iFuncStartsOffset;
+        startsEnd   = startsData + iFuncStartsSize;
+        maxStarts  += iFuncStartsSize;  // at least 1 byte per delta
+    }
+
+    if (iFuncStarts)
+        free(iFuncStarts);
+
+    iNumFuncStarts  = 0;
+    iFuncStarts     = malloc(sizeof(UInt64) * maxStarts);
+
+    if (!iFuncStarts)
+    {
+        fprintf(stderr, "otx: not enough memory for function starts\n");
+        return;
+    }
+
+    iFuncStarts[iNumFuncStarts++]   = iAddrDyldStubBindingHelper;
+    iFuncStarts[iNumFuncStarts++]   = iAddrDyldFuncLookupPointer;
+
+    for (i = 0; i < iNumClassMethodInfos; i++)
+        iFuncStarts[iNumFuncStarts++]   = (iSwapped) ?
+            OSSwapInt64(iClassMethodInfos[i].m.imp) :
+            iClassMethodInfos[i].m.imp;
+
+    for (i = 0; i < iNumFuncSyms; i++)
+        iFuncStarts[iNumFuncStarts++]   = iFuncSyms[i].n_value;
+
+    for (i = 0; i < iNumThunks; i++)
+        iFuncStarts[iNumFuncStarts++]   = iThunks[i].address;
+
+    // Stripped code has no symbols, but whatever gets called is a function.
+    Line64*     theLine = iPlainLineListHead;
+    UInt64      target;
+
+    for (; theLine; theLine = theLine->next)
+    {
+        if (!theLine->info.isCode ||
+            ![self getCallTarget:&target forLine:theLine])
+            continue;
+
+        if (target >= iTextSect.s.addr &&
+            target < iTextSect.s.addr + iTextSect.s.size)
+            iFuncStarts[iNumFuncStarts++]   = target;
+    }
+
+    // LC_FUNCTION_STARTS is a list of ULEB128 deltas, the first one from
+    // the start of the __TEXT segment, terminated by a 0 delta.
+    if (startsData)
+    {
+        UInt64      address = iTextSegAddress;
+
+        while (startsData < startsEnd)
+        {
+            UInt64      delta   = 0;
+            uint32_t    shift   = 0;
+            UInt8       byte;
+
+            do
+            {
+                byte    = *startsData++;
+
+                if (shift < 64)
+                    delta  |= (UInt64)(byte & 0x7f) << shift;
+
+                shift  += 7;
+            } while ((byte & 0x80) && startsData < startsEnd);
+
+            if (!delta)
+                break;
+
+            address += delta;
+            iFuncStarts[iNumFuncStarts++]   = address;
+        }
+    }
+
+    qsort(iFuncStarts, iNumFuncStarts, sizeof(UInt64),
+        (COMPARISON_FUNC_TYPE)UInt64_Compare);
+
+    uint32_t    numUnique   = 0;
+
+    for (i = 0; i < iNumFuncStarts; i++)
+    {
+        if (!numUnique || iFuncStarts[i] != iFuncStarts[numUnique - 1])
+            iFuncStarts[numUnique++]    = iFuncStarts[i];
+    }
+
+    iNumFuncStarts  = numUnique;
+}
+
+//  isFunctionStart:
+// ----------------------------------------------------------------------------
+
+- (BOOL)isFunctionStart: (UInt64)inAddress
+{
+    if (!iFuncStarts)
+        return NO;
+
+    return (bsearch(&inAddress, iFuncStarts, iNumFuncStarts, sizeof(UInt64),
+        (COMPARISON_FUNC_TYPE)UInt64_Compare) != NULL);
 }
 
 //  findFunctions
@@ -504,6 +2359,8 @@
 
 - (void)findFunctions
 {
+    [self buildFunctionStarts];
+
     // Loop once to flag all funcs.
     Line64* theLine = iPlainLineListHead;
 
@@ -561,6 +2418,21 @@
     UInt8   theContentsStringLength = strlen(theContentsString);
     char*   theTextSegString        = "(__TEXT,__";
 
+    // -records only keep function names, which processCodeLine: turns into
+    // records of their own. otool's own section names are dropped below,
+    // after they've set iEndOfText.
+    if (iOpts.recordFormat &&
+        !(ioLine->next && ioLine->next->info.isCode &&
+        ioLine->next->info.isFunction) &&
+        (strstr(ioLine->chars, theContentsString) ||
+        !strstr(ioLine->chars, theTextSegString)))
+    {
+        ioLine->chars[0]    = 0;
+        ioLine->length      = 0;
+
+        return;
+    }
+
     // Kill the "Contents of" if it exists.
     if (strstr(ioLine->chars, theContentsString))
     {
@@ -590,6 +2462,14 @@
             iCurrentFunctionStart = ioLine->info.address;
         }
 
+        if (iOpts.recordFormat)
+        {
+            ioLine->chars[0]    = 0;
+            ioLine->length      = 0;
+
+            return;
+        }
+
         char    theTempLine[MAX_LINE_LENGTH];
 
         theTempLine[0]  = '\n';
@@ -609,63 +2489,16 @@
     {
         if (strstr(ioLine->chars, "__Z") == ioLine->chars)
         {
-            char demangledName[MAX_LINE_LENGTH];
-
-            // Line should end with ":\n". Terminate over the colon if it exists.
-            if (ioLine->chars[ioLine->length - 2] == ':')
-                ioLine->chars[ioLine->length - 2] = 0;
-            else
-                ioLine->chars[ioLine->length - 1] = 0;
+            // Line should end with ":\n". Drop both, like c++filt did.
+            char*   demangled   = [self demangledName: ioLine->chars
+                length: strcspn(ioLine->chars, ":\n")];
 
-            NSFileHandle* filtWrite = [iCPFiltInputPipe fileHandleForWriting];
-            NSFileHandle* filtRead = [iCPFiltOutputPipe fileHandleForReading];
-            NSMutableData* dataToWrite = [NSMutableData dataWithBytes: ioLine->chars
-                                                               length: strlen(ioLine->chars)];
-
-            [dataToWrite appendBytes: "\n"
-                              length: 1];
-
-            @try {
-                [filtWrite writeData: dataToWrite];
-            }
-            @catch (NSException* e) {
-                NSLog(@"otx: [Exe64Processor processLine:] failed to write to c++filt: %@", [e reason]);
-            }
-
-            NSData* readData = nil;
-
-            @try {
-                readData = [filtRead availableData];
-            }
-            @catch (NSException* e) {
-                NSLog(@"otx: [Exe64Processor processLine:] failed to read from c++filt: %@", [e reason]);
-            }
-
-            [readData getBytes: demangledName];
-
-            if (readData != nil)
+            if (demangled)
             {
-                NSUInteger demangledDataLength = [readData length];
-                NSUInteger demangledStringLength = MIN(demangledDataLength, MAX_LINE_LENGTH - 1);
-
-                if (demangledStringLength < demangledDataLength)
-                    NSLog(@"otx: demangled C++ name is too large. Increase MAX_LINE_LENGTH to %lu.\n"
-                           "Name demangling will now go off the rails.", (unsigned long)demangledDataLength);
-
-                // Get the string and terminate it.
-                [readData getBytes: demangledName
-                            length: demangledStringLength];
-                demangledName[demangledStringLength] = 0;
-
                 free(ioLine->chars);
-                ioLine->length = demangledStringLength;
-                ioLine->chars = malloc(ioLine->length + 1);
-
-                strncpy(ioLine->chars, demangledName, ioLine->length + 1);
-            }
-            else
-            {
-                NSLog(@"otx: [Exe64Processor processLine:] got nil data from c++filt");
+                ioLine->length  = strlen(demangled) + 1;
+                ioLine->chars   = malloc(ioLine->length + 1);
+                snprintf(ioLine->chars, ioLine->length + 1, "%s\n", demangled);
             }
         }
     }
@@ -689,22 +2522,40 @@
     char    theAddressCString[17]   = {0};
     char    theMnemonicCString[20]  = {0};
 
-    char    addrSpaces[MAX_FIELD_SPACING] = MAX_FIELD_SPACES;
-    char    instSpaces[MAX_FIELD_SPACING] = MAX_FIELD_SPACES;
-    char    mnemSpaces[MAX_FIELD_SPACING] = MAX_FIELD_SPACES;
-    char    opSpaces[MAX_FIELD_SPACING] = MAX_FIELD_SPACES;
-    char    commentSpaces[MAX_FIELD_SPACING] = MAX_FIELD_SPACES;
-
     char    theOrigCommentCString[MAX_COMMENT_LENGTH];
     char    theCommentCString[MAX_COMMENT_LENGTH];
 
     theOrigCommentCString[0]    = 0;
     theCommentCString[0]        = 0;
 
+    // With -incremental, an unchanged function's lines get the last run's
+    // comments and block breaks instead of being analyzed again.
+    IncrementalEntry*   reusedLine  = NULL;
+
+    if (iOpts.incrementalPath)
+    {
+        if ((*ioLine)->info.isFunction)
+        {
+            Function64Info  searchKey   = {(*ioLine)->info.address, NULL, 0, 0};
+            Function64Info* funcInfo    = bsearch(&searchKey,
+                iFuncInfos, iNumFuncInfos, sizeof(Function64Info),
+                (COMPARISON_FUNC_TYPE)Function64_Info_Compare);
+
+            [self beginIncrementalFunction:
+                (funcInfo) ? funcInfo->incHash : NULL];
+        }
+
+        reusedLine  = [self beginIncrementalLine];
+    }
+
     // Swap in saved registers if necessary
-    BOOL    needNewLine = [self restoreRegisters:*ioLine];
+    BOOL    needNewLine = (reusedLine) ?
+        (reusedLine->flags & IncrementalNewLine) != 0 :
+        [self restoreRegisters:*ioLine];
 
     iLineOperandsCString[0] = 0;
+    iLineSelector           = NULL;
+    iLineClassName          = NULL;
 
     char*   origFormatString    = "%s\t%s\t%s%n";
     uint32_t  consumedAfterOp     = 0;
@@ -758,30 +2609,6 @@
         inBuffer[8], inBuffer[9], inBuffer[10], inBuffer[11],
         inBuffer[12], inBuffer[13], inBuffer[14]);
 
-    i = iFieldWidths.instruction - (*ioLine)->info.codeLength * 2;
-    mnemSpaces[i - 1] = 0;
-
-    i = iFieldWidths.mnemonic - strlen(theMnemonicCString);
-    opSpaces[i - 1] = 0;
-
-    // Terminate commentSpaces based on operands field width.
-    if (iLineOperandsCString[0] && theOrigCommentCString[0])
-    {
-        size_t opLength = strlen(iLineOperandsCString);
-
-        if (opLength < iFieldWidths.operands)
-        {
-            i = iFieldWidths.operands - opLength;
-            commentSpaces[i - 1] = 0;
-        }
-        else
-            commentSpaces[0] = 0;
-    }
-    else
-    {
-        commentSpaces[0] = 0;
-    }
-
     // Remove "; symbol stub for: "
     if (theOrigCommentCString[0])
     {
@@ -794,6 +2621,15 @@
             snprintf(theCommentCString, MAX_COMMENT_LENGTH, "%s", theOrigCommentCString);
     }
 
+    // otool's comment names the callee, if any. Keep it for the -xref
+    // index and -records before commentForMsgSend:fromLine: replaces it.
+    char    theCalleeCString[MAX_COMMENT_LENGTH];
+
+    theCalleeCString[0] = 0;
+
+    if (iOpts.xrefIndexPath || iOpts.recordFormat)
+        strncpy(theCalleeCString, theCommentCString, MAX_COMMENT_LENGTH);
+
     BOOL    needFuncName = NO;
     char    theMethCName[1000];
 
@@ -876,8 +2712,10 @@
             }
         }   // if ([self getObjcMethod:&theSwappedInfoPtr fromAddress:mCurrentFuncPtr])
 
-        // Add or replace the method name if possible, else add '\n'.
-        if ((*ioLine)->prev && (*ioLine)->prev->info.isCode)    // prev line is code
+        // Add or replace the method name if possible, else add '\n'. A NULL
+        // prev means the previous function's last line was cut off from this
+        // one for processing on another thread, so treat it as code.
+        if (!(*ioLine)->prev || (*ioLine)->prev->info.isCode)   // prev line is code
         {
             if (theMethCName[0])
             {
@@ -918,15 +2756,12 @@
         else    // prev line is not code
         {
             if (theMethCName[0])
-            {
-                Line64* theNewLine  = malloc(sizeof(Line64));
-
-                theNewLine->length  = strlen(theMethCName);
-                theNewLine->chars   = malloc(theNewLine->length + 1);
-
-                strncpy(theNewLine->chars, theMethCName,
-                    theNewLine->length + 1);
-                [self replaceLine:(*ioLine)->prev withLine:theNewLine inList:&iPlainLineListHead];
+            {   // Replace otool's method name with ours.
+                free((*ioLine)->prev->chars);
+                (*ioLine)->prev->length = strlen(theMethCName);
+                (*ioLine)->prev->chars  = malloc((*ioLine)->prev->length + 1);
+                strncpy((*ioLine)->prev->chars, theMethCName,
+                    (*ioLine)->prev->length + 1);
             }
             else
             {   // theMethName sux, add '\n' to otool's method name.
@@ -954,11 +2789,30 @@
         [self resetRegisters:*ioLine];
     }   // if ((*ioLine)->info.isFunction)
 
+    BOOL    hadOperands = (iLineOperandsCString[0] != 0);
+
     // Find a comment if necessary.
-    if (!theCommentCString[0])
+    if (reusedLine)
+    {
+        const char* theReusedComment    =
+            iOldIncStrings + reusedLine->comment;
+
+        if (reusedLine->flags & IncrementalCommentInOperands)
+            snprintf(iLineOperandsCString, MAX_OPERANDS_LENGTH, "%s",
+                theReusedComment);
+        else
+            snprintf(theCommentCString, MAX_COMMENT_LENGTH, "%s",
+                theReusedComment);
+    }
+    else if (!theCommentCString[0])
     {
+        UInt64  startTicks  = (iOpts.debugMode) ? mach_absolute_time() : 0;
+
         [self commentForLine:*ioLine];
 
+        if (iOpts.debugMode)
+            iCommentTicks  += mach_absolute_time() - startTicks;
+
         size_t origCommentLength = strlen(iLineCommentCString);
         // BEWARE IF origCommentLength > MAX_COMMENT_LENGTH !!!
 
@@ -996,20 +2850,6 @@
                 snprintf(theCommentCString, MAX_COMMENT_LENGTH, "%s", tempComment);
             else
                 snprintf(iLineOperandsCString, MAX_COMMENT_LENGTH, "%s", tempComment);
-
-            // Terminate commentSpaces based on operands field width.
-            size_t opLength = strlen(iLineOperandsCString);
-
-            if (opLength < iFieldWidths.operands)
-            {
-                commentSpaces[0] = ' ';
-                UInt8 k = iFieldWidths.operands - opLength;
-                commentSpaces[k - 1]    = 0;
-            }
-            else
-            {
-                commentSpaces[0] = 0;
-            }
         }
     }   // if (!theCommentCString[0])
     else    // otool gave us a comment.
@@ -1023,110 +2863,28 @@
     if (iLineOperandsCString[0] && iOpts.demangleCppNames)
     {
         if (strstr(iLineOperandsCString, "__Z") == iLineOperandsCString)
-        {
-            char demangledName[MAX_OPERANDS_LENGTH];
-
-            NSFileHandle* filtWrite = [iCPFiltInputPipe fileHandleForWriting];
-            NSFileHandle* filtRead = [iCPFiltOutputPipe fileHandleForReading];
-            NSMutableData* dataToWrite = [NSMutableData dataWithBytes: iLineOperandsCString
-                                                               length: strlen(iLineOperandsCString)];
-
-            [dataToWrite appendBytes: "\n"
-                              length: 1];
-
-            @try {
-                [filtWrite writeData: dataToWrite];
-            }
-            @catch (NSException* e) {
-                NSLog(@"otx: [Exe64Processor processCodeLine:] failed to write operands to c++filt: %@", [e reason]);
-            }
-
-            NSData* readData = nil;
-
-            @try {
-                readData = [filtRead availableData];
-            }
-            @catch (NSException* e) {
-                NSLog(@"otx: [Exe64Processor processCodeLine:] failed to read operands from c++filt: %@", [e reason]);
-            }
-
-            if (readData != nil)
-            {
-                NSUInteger demangledDataLength = [readData length];
-                NSUInteger demangledStringLength = MIN(demangledDataLength, MAX_OPERANDS_LENGTH - 1);
-
-                if (demangledStringLength < demangledDataLength)
-                    NSLog(@"otx: demangled C++ name is too large. Increase MAX_OPERANDS_LENGTH to %lu.\n"
-                           "Name demangling will now go off the rails.", (unsigned long)demangledDataLength);
-
-                [readData getBytes: demangledName
-                            length: demangledStringLength];
-
-                // Remove the trailing newline and terminate.
-                demangledStringLength--;
-                demangledName[demangledStringLength] = 0;
-                strncpy(iLineOperandsCString, demangledName, demangledStringLength + 1);
-            }
-            else
-            {
-                NSLog(@"otx: [Exe64Processor processCodeLine:] got nil operands data from c++filt");
-            }
-        }
+            [self demangleCString: iLineOperandsCString
+                maxLength: MAX_OPERANDS_LENGTH];
     }
 
     // Demangle comment if necessary.
     if (theCommentCString[0] && iOpts.demangleCppNames)
     {
         if (strstr(theCommentCString, "__Z") == theCommentCString)
-        {
-            char    demangledName[MAX_COMMENT_LENGTH];
-
-            NSFileHandle* filtWrite = [iCPFiltInputPipe fileHandleForWriting];
-            NSFileHandle* filtRead = [iCPFiltOutputPipe fileHandleForReading];
-            NSMutableData* dataToWrite = [NSMutableData dataWithBytes: theCommentCString
-                                                               length: strlen(theCommentCString)];
-
-            [dataToWrite appendBytes: "\n"
-                              length: 1];
-
-            @try {
-                [filtWrite writeData: dataToWrite];
-            }
-            @catch (NSException* e) {
-                NSLog(@"otx: [Exe64Processor processCodeLine:] failed to write comment to c++filt: %@", [e reason]);
-            }
-
-            NSData* readData = nil;
-
-            @try {
-                readData = [filtRead availableData];
-            }
-            @catch (NSException* e) {
-                NSLog(@"otx: [Exe64Processor processCodeLine:] failed to read comment from c++filt: %@", [e reason]);
-            }
-
-            if (readData != nil)
-            {
-                NSUInteger demangledDataLength = [readData length];
-                NSUInteger demangledStringLength = MIN(demangledDataLength, MAX_COMMENT_LENGTH - 1);
-
-                if (demangledStringLength < demangledDataLength)
-                    NSLog(@"otx: demangled C++ name is too large. Increase MAX_COMMENT_LENGTH to %lu.\n"
-                           "Name demangling will now go off the rails.", (unsigned long)demangledDataLength);
+            [self demangleCString: theCommentCString
+                maxLength: MAX_COMMENT_LENGTH];
+    }
 
-                [readData getBytes: demangledName
-                            length: demangledStringLength];
+    // Save the comment for the next -incremental run.
+    if (iOpts.incrementalPath)
+    {
+        uint32_t    theIncFlags = (needNewLine) ? IncrementalNewLine : 0;
 
-                // Remove the trailing newline and terminate.
-                demangledStringLength--;
-                demangledName[demangledStringLength] = 0;
-                strncpy(theCommentCString, demangledName, demangledStringLength + 1);
-            }
-            else
-            {
-                NSLog(@"otx: [Exe64Processor processCodeLine:] got nil comment data from c++filt");
-            }
-        }
+        if (!hadOperands && iLineOperandsCString[0])
+            [self endIncrementalLine: iLineOperandsCString
+                flags: theIncFlags | IncrementalCommentInOperands];
+        else
+            [self endIncrementalLine: theCommentCString flags: theIncFlags];
     }
 
     // Optionally add local offset.
@@ -1147,16 +2905,8 @@
                 break;
             }
         }
-
-        // Terminate addrSpaces based on offset field width.
-        i   = iFieldWidths.offset - 6;
-        addrSpaces[i - 1] = 0;
     }
 
-    // Terminate instSpaces based on address field width.
-    i   = iFieldWidths.address - 16;
-    instSpaces[i - 1] = 0;
-
     // Insert a generic function name if needed.
     if (needFuncName)
     {
@@ -1185,77 +2935,125 @@
         [self insertLine:funcName before:*ioLine inList:&iPlainLineListHead];
     }
 
-    // Finally, assemble the new string.
-    char    finalFormatCString[MAX_FORMAT_LENGTH];
-    uint32_t  formatMarker    = 0;
-
-    if (needNewLine)
+    // Record the function's name and any call for the -xref index.
+    if (iOpts.xrefIndexPath)
     {
-        formatMarker++;
-        finalFormatCString[0]   = '\n';
-        finalFormatCString[1]   = 0;
+        if ((*ioLine)->info.isFunction && (*ioLine)->prev)
+            [self addXref: (*ioLine)->prev->chars kind: XrefFunction
+                site: iCurrentFunctionStart function: iCurrentFunctionStart];
+
+        if ([self codeIsCall: (*ioLine)->info.code])
+        {
+            char*   theCallee   = theCalleeCString;
+
+            if (!theCallee[0])
+                theCallee   = (theCommentCString[0]) ?
+                    theCommentCString : iLineOperandsCString;
+
+            [self addXref: theCallee kind: XrefCall
+                site: (*ioLine)->info.address function: iCurrentFunctionStart];
+        }
     }
-    else
-        finalFormatCString[0]   = 0;
 
-    if (iOpts.localOffsets)
-        formatMarker += snprintf(&finalFormatCString[formatMarker],
-            10, "%s", "%s %s");
+    // Finally, assemble the new string. Each field is padded to its width
+    // from iFieldWidths, and the last one isn't padded at all. For -records,
+    // the line becomes the function's and instruction's records instead,
+    // and the function's name line is emptied.
+    char        theFinalCString[MAX_LINE_LENGTH];
+    size_t      theFinalLength  = 0;
 
-    if (iLineOperandsCString[0])
+    if (iOpts.recordFormat)
     {
-        if (theCommentCString[0])
-            snprintf(&finalFormatCString[formatMarker],
-                30, "%s", "%s %s%s %s%s %s%s %s%s\n");
-        else
-            snprintf(&finalFormatCString[formatMarker],
-                30, "%s", "%s %s%s %s%s %s%s\n");
-    }
-    else
-        snprintf(&finalFormatCString[formatMarker],
-            30, "%s", "%s %s%s %s%s\n");
+        InsnRecord  theRecord   = {(*ioLine)->info.address,
+            iCurrentFunctionStart, theMnemonicCString, iLineOperandsCString,
+            theCalleeCString, iLineSelector, iLineClassName, theCommentCString};
+        char*       theFuncName = NULL;
 
-    char    theFinalCString[MAX_LINE_LENGTH] = "";
+        memcpy(theRecord.code, (*ioLine)->info.code,
+            (*ioLine)->info.codeLength);
+        theRecord.codeLength    = (*ioLine)->info.codeLength;
 
-    if (iOpts.localOffsets)
-        snprintf(theFinalCString, MAX_LINE_LENGTH,
-            finalFormatCString, localOffsetString,
-            addrSpaces, theAddressCString,
-            instSpaces, theCodeCString,
-            mnemSpaces, theMnemonicCString,
-            opSpaces, iLineOperandsCString,
-            commentSpaces, theCommentCString);
-    else
-        snprintf(theFinalCString, MAX_LINE_LENGTH,
-            finalFormatCString, theAddressCString,
-            instSpaces, theCodeCString,
-            mnemSpaces, theMnemonicCString,
-            opSpaces, iLineOperandsCString,
-            commentSpaces, theCommentCString);
+        if ((*ioLine)->info.isFunction && (*ioLine)->prev &&
+            !(*ioLine)->prev->info.isCode)
+            theFuncName = (*ioLine)->prev->chars;
 
-    free((*ioLine)->chars);
+        theFinalLength  = [self recordInstruction: &theRecord
+            functionName: theFuncName toCString: theFinalCString
+            maxLength: MAX_LINE_LENGTH];
 
-    if (iOpts.separateLogicalBlocks && iEnteringNewBlock &&
-        theFinalCString[0] != '\n')
-    {
-        (*ioLine)->length   = strlen(theFinalCString) + 1;
-        (*ioLine)->chars    = malloc((*ioLine)->length + 1);
-        (*ioLine)->chars[0] = '\n';
-        strncpy(&(*ioLine)->chars[1], theFinalCString, (*ioLine)->length);
+        if (theFuncName)
+        {
+            (*ioLine)->prev->chars[0]   = 0;
+            (*ioLine)->prev->length     = 0;
+        }
     }
     else
     {
-        (*ioLine)->length   = strlen(theFinalCString);
-        (*ioLine)->chars    = malloc((*ioLine)->length + 1);
-        strncpy((*ioLine)->chars, theFinalCString, (*ioLine)->length + 1);
+        const char* theLastField    = theMnemonicCString;
+
+        if (needNewLine || (iOpts.separateLogicalBlocks && iEnteringNewBlock))
+            theFinalCString[theFinalLength++]   = '\n';
+
+        if (iOpts.localOffsets)
+            theFinalLength  = AppendField(theFinalCString, theFinalLength,
+                localOffsetString, iFieldWidths.offset);
+
+        theFinalLength  = AppendField(theFinalCString, theFinalLength,
+            theAddressCString, iFieldWidths.address);
+
+        theFinalLength  = AppendField(theFinalCString, theFinalLength,
+            theCodeCString, iFieldWidths.instruction);
+
+        if (iLineOperandsCString[0])
+        {
+            theFinalLength  = AppendField(theFinalCString, theFinalLength,
+                theMnemonicCString, iFieldWidths.mnemonic);
+            theLastField    = iLineOperandsCString;
+
+            if (theCommentCString[0])
+            {
+                theFinalLength  = AppendField(theFinalCString, theFinalLength,
+                    iLineOperandsCString, iFieldWidths.operands);
+                theLastField    = theCommentCString;
+            }
+        }
+
+        size_t  theLastLength   = MIN(strlen(theLastField),
+            MAX_LINE_LENGTH - theFinalLength - 2);
+
+        memcpy(&theFinalCString[theFinalLength], theLastField, theLastLength);
+        theFinalLength                     += theLastLength;
+        theFinalCString[theFinalLength++]   = '\n';
+        theFinalCString[theFinalLength]     = 0;
+
+        if (iOpts.entabOutput)
+            theFinalLength  = [self entabCString: theFinalCString
+                length: theFinalLength];
     }
 
+    free((*ioLine)->chars);
+    (*ioLine)->length   = theFinalLength;
+    (*ioLine)->chars    = malloc(theFinalLength + 1);
+    memcpy((*ioLine)->chars, theFinalCString, theFinalLength + 1);
+
     // The test above can fail even if mEnteringNewBlock was YES, so we
     // should reset it here instead.
     iEnteringNewBlock = NO;
 
-    [self updateRegisters:*ioLine];
-    [self postProcessCodeLine:ioLine];
+    if (!reusedLine)
+    {
+        UInt64  startTicks  = (iOpts.debugMode) ? mach_absolute_time() : 0;
+
+        [self updateRegisters:*ioLine];
+
+        if (iOpts.debugMode)
+        {
+            iRegistersTicks    += mach_absolute_time() - startTicks;
+            iTimedLines++;
+        }
+
+        [self postProcessCodeLine:ioLine];
+    }
 
     // Possibly prepend a \n to the following line.
     if ([self codeIsBlockJump:(*ioLine)->info.code])
@@ -1326,39 +3124,36 @@
         return NO;
     }
 
-    if (iDataSect.size)
-    {
-        if (fprintf(outFile, "\n(__DATA,__data) section\n") < 0)
-        {
-            perror("otx: unable to write to output file");
-            return NO;
-        }
-
-        [self printDataSection: &iDataSect toFile: outFile];
-    }
+    OutputWriter    writer;
 
-    if (iCoalDataSect.size)
+    if (![self openOutputWriter: &writer toFile: outFile withToc: NO])
     {
-        if (fprintf(outFile, "\n(__DATA,__coalesced_data) section\n") < 0)
-        {
-            perror("otx: unable to write to output file");
-            return NO;
-        }
+        if (iOutputFilePath)
+            fclose(outFile);
 
-        [self printDataSection: &iCoalDataSect toFile: outFile];
+        return NO;
     }
 
-    if (iCoalDataNTSect.size)
+    section_info_64*    theSects[]  =
+        {&iDataSect, &iCoalDataSect, &iCoalDataNTSect};
+    char*               theNames[]  = {"\n(__DATA,__data) section\n",
+        "\n(__DATA,__coalesced_data) section\n",
+        "\n(__DATA,__datacoal_nt) section\n"};
+    BOOL                result      = YES;
+    UInt8               i;
+
+    for (i = 0; i < sizeof(theSects) / sizeof(theSects[0]) && result; i++)
     {
-        if (fprintf(outFile, "\n(__DATA,__datacoal_nt) section\n") < 0)
-        {
-            perror("otx: unable to write to output file");
-            return NO;
-        }
+        if (!theSects[i]->size)
+            continue;
 
-        [self printDataSection: &iCoalDataNTSect toFile: outFile];
+        result  = [self writeOutput: &writer bytes: theNames[i]
+            length: strlen(theNames[i])] &&
+            [self printDataSection: theSects[i] toWriter: &writer];
     }
 
+    result  = [self closeOutputWriter: &writer] && result;
+
     if (iOutputFilePath)
     {
         if (fclose(outFile) != 0)
@@ -1368,94 +3163,18 @@
         }
     }
 
-    return YES;
+    return result;
 }
 
-#define _64_BIT_ADDRESS_COLUMN_LENGTH_ 18
-
-//  printDataSection:toFile:
+//  printDataSection:toWriter:
 // ----------------------------------------------------------------------------
 
-- (void)printDataSection: (section_info_64*)inSect
-                  toFile: (FILE*)outFile;
+- (BOOL)printDataSection: (section_info_64*)inSect
+                toWriter: (OutputWriter*)ioWriter
 {
-    uint32_t bytesLeft;
-    uint32_t i, j, k;
-    uint32_t theDataSize = (uint32_t)inSect->size;
-    char theLineCString[80];
-    char* theMachPtr = (char*)iMachHeaderPtr;
-
-    theLineCString[0] = 0;
-
-    for (i = 0; i < theDataSize; i += 16)
-    {
-        bytesLeft = theDataSize - i;
-
-        unsigned char theASCIIData[20] = {0};
-
-        if (bytesLeft < 16) // last line
-        {
-            theLineCString[0] = 0;
-            snprintf(theLineCString, _64_BIT_ADDRESS_COLUMN_LENGTH_ + 1 ,"%016llx |", inSect->s.addr + i);
-
-            unsigned char theHexData[17] = {0};
-
-            memcpy(theHexData, (const void*)(theMachPtr + inSect->s.offset + i), bytesLeft);
-            memcpy(theASCIIData, theHexData, bytesLeft);
-
-            j   = _64_BIT_ADDRESS_COLUMN_LENGTH_;
-
-            for (k = 0; k < bytesLeft; k++)
-            {
-                if ((k % 4) == 0)
-                    theLineCString[j++] = 0x20;
-
-                snprintf(&theLineCString[j], 4, "%02x", theHexData[k]);
-                j += 2;
-
-                if (theASCIIData[k] < 0x20 || theASCIIData[k] == 0x7f)
-                    theASCIIData[k] = '.';
-            }
-
-            // Append spaces.
-            for (; j < _64_BIT_ADDRESS_COLUMN_LENGTH_ + 38; j++)
-                theLineCString[j] = 0x20;
-
-            // Append ASCII chars.
-            snprintf(&theLineCString[j], 80, "%s\n", theASCIIData);
-        }
-        else    // first lines
-        {           
-            uint32_t* theHexPtr = (uint32_t*)(theMachPtr + inSect->s.offset + i);
-            UInt8 j;
-
-            memcpy(theASCIIData, (const void*)(theMachPtr + inSect->s.offset + i), 16);
-
-            for (j = 0; j < 16; j++)
-                if (theASCIIData[j] < 0x20 || theASCIIData[j] == 0x7f)
-                    theASCIIData[j] = '.';
-
-#if TARGET_RT_LITTLE_ENDIAN
-            theHexPtr[0] = OSSwapInt32(theHexPtr[0]);
-            theHexPtr[1] = OSSwapInt32(theHexPtr[1]);
-            theHexPtr[2] = OSSwapInt32(theHexPtr[2]);
-            theHexPtr[3] = OSSwapInt32(theHexPtr[3]);
-#endif
-
-            snprintf(theLineCString, sizeof(theLineCString),
-                "%016llx | %08x %08x %08x %08x  %s\n",
-                inSect->s.addr + i,
-                theHexPtr[0], theHexPtr[1], theHexPtr[2], theHexPtr[3],
-                theASCIIData);
-        }
-
-        if (fprintf(outFile, "%s", theLineCString) < 0)
-        {
-            perror("otx: [Exe64Processor printDataSection:toFile:]: "
-                "unable to write to output file");
-            return;
-        }
-    }
+    return [self printHexDump: (UInt8*)iMachHeaderPtr + inSect->s.offset
+        length: inSect->size address: inSect->s.addr addressDigits: 16
+        toWriter: ioWriter];
 }
 
 #pragma mark -
@@ -1477,6 +3196,9 @@
 {
     NSString* md5String = [self generateMD5String];
 
+    if (!md5String)
+        return;
+
     Line64* newLine = calloc(1, sizeof(Line64));
     const char* utf8String = [md5String UTF8String];
 
@@ -1487,119 +3209,6 @@
     [self insertLine:newLine after:iPlainLineListHead inList:&iPlainLineListHead];
 }
 
-#pragma mark -
-//  entabLine:
-// ----------------------------------------------------------------------------
-//  A cheap and fast way to entab a line, assuming it contains no tabs already.
-//  If tabs get added in the future, this WILL break. Single spaces are not
-//  replaced with tabs, even when possible, since it would save no additional
-//  bytes. Comments are not entabbed, as that would remove the user's ability
-//  to search for them in the source code or a hex editor.
-
-- (void)entabLine: (Line64*)ioLine;
-{
-    if (!ioLine || !ioLine->chars)
-        return;
-
-    // only need to do this math once...
-    static uint32_t   startOfComment  = 0;
-
-    if (startOfComment == 0)
-    {
-        startOfComment  = iFieldWidths.address + iFieldWidths.instruction +
-            iFieldWidths.mnemonic + iFieldWidths.operands;
-
-        if (iOpts.localOffsets)
-            startOfComment  += iFieldWidths.offset;
-    }
-
-    char    entabbedLine[MAX_LINE_LENGTH];
-    size_t  theOrigLength   = ioLine->length;
-
-    // If 1st char is '\n', skip it.
-    uint32_t  firstChar   = (ioLine->chars[0] == '\n');
-    uint32_t  i;          // old line marker
-    uint32_t  j   = 0;    // new line marker
-
-    if (firstChar)
-    {
-        j++;
-        entabbedLine[0] = '\n';
-        entabbedLine[1] = 0;
-    }
-    else
-        entabbedLine[0] = 0;
-
-    // Inspect 4 bytes at a time.
-    for (i = firstChar; i < theOrigLength; i += 4)
-    {
-        // Don't entab comments.
-        if (i >= (startOfComment + firstChar) - 4)
-        {
-            strncpy(&entabbedLine[j], &ioLine->chars[i],
-                (theOrigLength - i) + 1);
-
-            break;
-        }
-
-        // If fewer than 4 bytes remain, adding any tabs is pointless.
-        if (i > theOrigLength - 4)
-        {   // Copy the remainder and split.
-            while (i < theOrigLength)
-                entabbedLine[j++] = ioLine->chars[i++];
-
-            // Add the null terminator.
-            entabbedLine[j] = 0;
-
-            break;
-        }
-
-        // If the 4th char is not a space, the first 3 chars don't matter.
-        if (ioLine->chars[i + 3] == 0x20)   // 4th char is a space...
-        {
-            if (ioLine->chars[i + 2] == 0x20)   // 3rd char is a space...
-            {
-                if (ioLine->chars[i + 1] == 0x20)   // 2nd char is a space...
-                {
-                    if (ioLine->chars[i] == 0x20)   // all 4 chars are spaces!
-                        entabbedLine[j++] = '\t';   // write a tab and split
-                    else    // only the 1st char is not a space
-                    {       // copy 1st char and tab
-                        entabbedLine[j++] = ioLine->chars[i];
-                        entabbedLine[j++] = '\t';
-                    }
-                }
-                else    // 2nd char is not a space
-                {       // copy 1st 2 chars and tab
-                    entabbedLine[j++] = ioLine->chars[i];
-                    entabbedLine[j++] = ioLine->chars[i + 1];
-                    entabbedLine[j++] = '\t';
-                }
-            }
-            else    // 3rd char is not a space
-            {       // copy 1st 3 chars and tab
-                entabbedLine[j++] = ioLine->chars[i];
-                entabbedLine[j++] = ioLine->chars[i + 1];
-                entabbedLine[j++] = ioLine->chars[i + 2];
-                entabbedLine[j++] = '\t';
-            }
-        }
-        else    // 4th char is not a space
-        {       // copy all 4 chars
-            memcpy(&entabbedLine[j], &ioLine->chars[i], 4);
-            j += 4;
-        }
-
-        // Add the null terminator.
-        entabbedLine[j] = 0;
-    }
-
-    // Replace the old C string with the new one.
-    free(ioLine->chars);
-    ioLine->length  = strlen(entabbedLine);
-    ioLine->chars   = malloc(ioLine->length + 1);
-    strncpy(ioLine->chars, entabbedLine, ioLine->length + 1);
-}
 
 //  getPointer:type:    (was get_pointer)
 // ----------------------------------------------------------------------------
@@ -1725,13 +3334,12 @@
         {
             theType = PointerType;
 
-            static uint32_t recurseCount = 0;
 
             while (theType == PointerType)
             {
-                recurseCount++;
+                iPointerRecurseCount++;
 
-                if (recurseCount > 5)
+                if (iPointerRecurseCount > 5)
                 {
                     theType = DataGenericType;
                     break;
@@ -1748,7 +3356,7 @@
                 theValue = *(UInt64*)thePtr;
             }
 
-            recurseCount = 0;
+            iPointerRecurseCount = 0;
         }
 
         if (outType)
@@ -83,6 +83,473 @@ typedef struct
 }
 TextFieldWidths;
 
+/*  StateArena
+
+    A bump allocator for saved machine states. Memory is handed out from a
+    list of chunks and can only be freed all at once, by resetArena:, so
+    states stored in the same arena can share arrays without reference
+    counting.
+*/
+typedef struct ArenaChunk
+{
+    struct ArenaChunk*  next;
+    size_t              size;       // usable bytes after the header
+    size_t              used;
+}
+ArenaChunk;
+
+typedef struct
+{
+    ArenaChunk* chunks;     // most recent first
+}
+StateArena;
+
+#define ARENA_CHUNK_SIZE    16384
+#define ARENA_HEADER_SIZE   ((sizeof(ArenaChunk) + 15) & ~15)
+
+/*  OutputWriter
+
+    Gathers output into OUTPUT_BUFFER_SIZE buffers and hands each full one
+    to a serial dispatch queue that writes it, so writing overlaps with
+    processing. At most OUTPUT_MAX_PENDING buffers wait to be written before
+    writeOutput:bytes:length: blocks. 'failed' is set by the writer when a
+    write fails, and everything after that is dropped.
+
+    With -z, the queue also gzips each buffer as a separate gzip member
+    before writing it, using 'stream'. Concatenated members are a valid gzip
+    file, and each can be decompressed on its own. endOutputBlock: flushes
+    buffers that are at least OUTPUT_MIN_BLOCK full between functions, so
+    members usually start with a function.
+*/
+typedef struct
+{
+    SInt32                  fileNum;
+    char*                   buffer;
+    size_t                  used;
+    dispatch_queue_t        queue;
+    dispatch_semaphore_t    pending;
+    volatile BOOL           failed;
+    BOOL                    compress;
+    z_stream                stream;     // used only on 'queue'
+    UInt64                  offset;     // bytes passed to writeOutput:...
+    BOOL                    writeToc;   // see openOutputWriter:toFile:withToc:
+    UInt64                  fileOffset; // bytes written, on 'queue'
+    struct TocFileMember*   members;    // -z only, on 'queue'
+    uint32_t                numMembers;
+    uint32_t                maxMembers;
+}
+OutputWriter;
+
+#define OUTPUT_BUFFER_SIZE  (256 * 1024)
+#define OUTPUT_MAX_PENDING  8
+#define OUTPUT_MIN_BLOCK    (OUTPUT_BUFFER_SIZE / 2)
+
+/*  Hex dumps
+
+    Data sections are dumped as rows of an address, 16 bytes in hex and the
+    same bytes as ASCII, see FormatHexRows. printHexDump:length:address:
+    addressDigits:toWriter: formats HEXDUMP_CHUNK_SIZE bytes per task, up
+    to HEXDUMP_BATCH_CHUNKS tasks at a time.
+*/
+#define HEXDUMP_CHUNK_SIZE      (64 * 1024)
+#define HEXDUMP_BATCH_CHUNKS    32
+#define HEXDUMP_ROW_LENGTH(d)   ((d) + 57)  // "addr |", 4 * " xxxxxxxx", "  ", ASCII, '\n'
+
+/*  XrefSite
+
+    A call site, a message send or a function name, recorded for the -xref
+    index. 'key' is the callee's name, the selector or the function's name,
+    and lives in the iXrefStrings arena. For function names, 'site' and
+    'function' are both the function's address.
+*/
+typedef struct
+{
+    char*   key;
+    UInt64  site;           // address of the call instruction
+    UInt64  function;       // address of the function containing 'site'
+    UInt8   kind;
+}
+XrefSite;
+
+// XrefSite.kind values
+enum {
+    XrefCall        = 1,
+    XrefSelector,
+    XrefFunction
+};
+
+/*  Xref index file
+
+    Written by writeXrefIndex, read by 'otx -query'. Everything is in host
+    byte order. An XrefIndexHeader is followed by 'numKeys' XrefIndexKeys
+    sorted by kind and then name, 'numSites' XrefIndexSites grouped by key
+    and sorted by address within each group, 'numFuncs' XrefIndexFuncs
+    sorted by address, and 'stringsSize' bytes of null-terminated names.
+    'name' fields are offsets into the names.
+*/
+#define XREF_INDEX_MAGIC    0x6f747858  // 'otxX'
+#define XREF_INDEX_VERSION  1
+
+typedef struct
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    numKeys;
+    uint32_t    numSites;
+    uint32_t    numFuncs;
+    uint32_t    stringsSize;
+}
+XrefIndexHeader;
+
+typedef struct
+{
+    uint32_t    name;
+    uint32_t    kind;
+    uint32_t    firstSite;
+    uint32_t    numSites;
+}
+XrefIndexKey;
+
+typedef struct
+{
+    UInt64  site;
+    UInt64  function;
+}
+XrefIndexSite;
+
+typedef struct
+{
+    UInt64      address;
+    uint32_t    name;
+    uint32_t    pad;
+}
+XrefIndexFunc;
+
+/*  TocEntry
+
+    A function's place in the output, recorded for -toc as its name line is
+    written, see printLinesFrom:before:toWriter:. 'name' lives in the
+    iTocStrings arena. 'offset' counts uncompressed bytes.
+*/
+typedef struct
+{
+    char*   name;
+    UInt64  address;
+    UInt64  endAddress;     // exclusive
+    UInt64  offset;
+    UInt64  length;
+}
+TocEntry;
+
+/*  Table of contents file
+
+    Written by writeTocFile: for -toc, so tools can find a function in the
+    output without scanning it. Everything is in host byte order. A
+    TocFileHeader is followed by 'numEntries' TocFileEntries sorted by
+    address, 'numMembers' TocFileMembers sorted by offset, and 'stringsSize'
+    bytes of null-terminated names. 'offset' and 'length' count bytes of
+    uncompressed output. With -z, each TocFileMember is a gzip member, so a
+    reader can inflate from the last member at or before an entry's offset.
+*/
+#define TOC_FILE_MAGIC      0x6f747854  // 'otxT'
+#define TOC_FILE_VERSION    1
+
+typedef struct
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    numEntries;
+    uint32_t    numMembers;
+    uint32_t    stringsSize;
+    uint32_t    pad;
+}
+TocFileHeader;
+
+typedef struct
+{
+    UInt64      address;
+    UInt64      endAddress;
+    UInt64      offset;
+    UInt64      length;
+    uint32_t    name;
+    uint32_t    pad;
+}
+TocFileEntry;
+
+typedef struct TocFileMember
+{
+    UInt64      outputOffset;   // uncompressed offset of the member's start
+    UInt64      fileOffset;
+}
+TocFileMember;
+
+/*  SplitPiece
+
+    One function's output for -split, see printLinesToDirectory:. 'name'
+    says which file the piece goes in, see SplitNameForFunction. Functions
+    with the same name share a file. 'name' and 'text' are malloc'd and
+    freed by writeSplitPieces:count:.
+*/
+typedef struct
+{
+    char*       name;
+    char*       text;
+    size_t      length;
+    uint32_t    index;      // in output order
+}
+SplitPiece;
+
+/*  SplitFile
+
+    A file's path and its index in output order, sorted by
+    writeSplitPieces:count: to find paths that differ only in case.
+*/
+typedef struct
+{
+    const char* path;
+    uint32_t    index;
+}
+SplitFile;
+
+/*  ChecksumDigest
+
+    Digests of the whole file, or of one slice of a universal binary, see
+    startChecksums. 'archName' is NULL for the whole file.
+*/
+typedef struct
+{
+    const char* archName;
+    uint32_t    offset;
+    uint32_t    size;
+    UInt8       md5[CC_MD5_DIGEST_LENGTH];
+    UInt8       sha256[CC_SHA256_DIGEST_LENGTH];
+}
+ChecksumDigest;
+
+/*  IncrementalFunc, IncrementalLine
+
+    One function's results for the next -incremental run, see
+    addIncrementalFunction: and addIncrementalLine:. 'hash' is the
+    function's FunctionHash_AddLine digest, and its lines are the 'numLines'
+    IncrementalLines starting at 'firstLine'. Each line keeps the comment
+    our analysis came up with, from the iIncStrings arena, and
+    IncrementalLineFlags.
+*/
+#define INCREMENTAL_HASH_LENGTH     16
+#define FUNCTION_HASH_MAX_DATA      4   // per line, see FunctionHash_AddLine
+
+enum {
+    IncrementalNewLine              = 1,    // a block starts here
+    IncrementalCommentInOperands    = 2     // the line had no operands
+};
+
+typedef struct
+{
+    UInt8       hash[INCREMENTAL_HASH_LENGTH];
+    uint32_t    firstLine;
+    uint32_t    numLines;
+}
+IncrementalFunc;
+
+typedef struct
+{
+    const char* comment;
+    uint32_t    flags;
+}
+IncrementalLine;
+
+/*  -incremental state file
+
+    An IncrementalFileHeader, 'numFuncs' IncrementalFuncs sorted by hash,
+    'numLines' IncrementalEntries, which are IncrementalLines with their
+    comment as an offset into the next 'stringsSize' bytes of null-terminated
+    comments, the empty one first. 'optionsHash' covers the arch and the
+    options that change comments, state saved with different ones is ignored.
+*/
+#define INCREMENTAL_FILE_MAGIC      0x6f747849  // 'otxI'
+#define INCREMENTAL_FILE_VERSION    1
+
+typedef struct
+{
+    uint32_t    magic;
+    uint32_t    version;
+    UInt8       optionsHash[INCREMENTAL_HASH_LENGTH];
+    uint32_t    numFuncs;
+    uint32_t    numLines;
+    uint32_t    stringsSize;
+    uint32_t    pad;
+}
+IncrementalFileHeader;
+
+typedef struct
+{
+    uint32_t    comment;
+    uint32_t    flags;
+}
+IncrementalEntry;
+
+#define SPLIT_MAX_NAME_LENGTH   200
+#define SPLIT_HEADER_NAME       "header"
+#define SPLIT_MANIFEST_FILE     "manifest.txt"
+
+/*  InsnRecord, FuncRecord
+
+    One instruction or function for -records output, see
+    recordInstruction:functionName:toCString:maxLength:. For JSON Lines the
+    strings are borrowed from processCodeLine:, for columnar output they're
+    copied into iRecordStrings. Missing strings are NULL or empty.
+*/
+typedef struct
+{
+    UInt64      address;
+    UInt64      function;       // address of the containing function
+    const char* mnemonic;
+    const char* operands;
+    const char* symbol;         // callee named by otool
+    const char* selector;       // message sends only
+    const char* className;      // receiver's class, if known
+    const char* comment;
+    UInt8       code[15];
+    UInt8       codeLength;
+}
+InsnRecord;
+
+typedef struct
+{
+    UInt64      address;
+    const char* name;
+}
+FuncRecord;
+
+/*  Columnar records file
+
+    Written by writeColumnarRecords for '-records columnar', meant to be
+    mmap'd. Everything is in host byte order. A RecordsHeader is followed by
+    the columns, each starting at the file offset in 'columns' and 8-byte
+    aligned. Instruction and function columns have 'numInsns' and
+    'numFuncs' entries respectively, sorted by address. String columns hold
+    offsets into the last column, 'stringsSize' bytes of null-terminated,
+    deduplicated strings where offset 0 is the empty string.
+*/
+#define RECORDS_MAGIC       0x6f747852  // 'otxR'
+#define RECORDS_VERSION     1
+
+enum {
+    RecordAddressColumn,        // UInt64
+    RecordFunctionColumn,       // UInt64
+    RecordCodeColumn,           // RecordCode
+    RecordMnemonicColumn,       // uint32_t string offsets from here on
+    RecordOperandsColumn,
+    RecordSymbolColumn,
+    RecordSelectorColumn,
+    RecordClassColumn,
+    RecordCommentColumn,
+    RecordFuncAddressColumn,    // UInt64
+    RecordFuncNameColumn,       // uint32_t string offset
+    RecordStringsColumn,        // char
+    RecordNumColumns
+};
+
+typedef struct
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    numInsns;
+    uint32_t    numFuncs;
+    uint32_t    stringsSize;
+    uint32_t    pad;
+    UInt64      columns[RecordNumColumns];
+}
+RecordsHeader;
+
+typedef struct
+{
+    UInt8   length;
+    UInt8   bytes[15];
+}
+RecordCode;
+
+/*  RecordStrings
+
+    The string column under construction, see RecordStrings_Intern. 'slots'
+    is an open-addressed hash table of string offsets plus one, sized by
+    writeColumnarRecords so it's never more than half full.
+*/
+typedef struct
+{
+    char*       strings;
+    uint32_t    size;
+    uint32_t    maxSize;
+    uint32_t*   slots;
+    uint32_t    maxSlots;   // power of 2
+}
+RecordStrings;
+
+/*  DemangleCache
+
+    Memoized demangler results, see demangleCString:maxLength:. 'entries' is
+    an open-addressed hash table keyed by mangled name, at most half full.
+    A NULL 'demangled' means the name didn't demangle. Both strings live in
+    'strings'. Workers share their parent's cache, so everything is guarded
+    by 'lock'. Entries loaded by -demangle-cache point into 'mappedFile'
+    instead, and are marked 'saved'. 'loadedSize' is where the last whole
+    record in that file ended, and 'loadedInode' says which file it was.
+*/
+typedef struct
+{
+    char*       mangled;
+    char*       demangled;
+    uint32_t    hash;
+    BOOL        saved;      // already in the -demangle-cache file
+}
+DemangleEntry;
+
+typedef struct
+{
+    DemangleEntry*  entries;
+    uint32_t        numEntries;
+    uint32_t        maxEntries;     // power of 2
+    StateArena      strings;
+    pthread_mutex_t lock;
+    char*           mappedFile;
+    size_t          mappedSize;
+    size_t          loadedSize;
+    ino_t           loadedInode;
+}
+DemangleCache;
+
+#define DEMANGLE_CACHE_SIZE     1024
+
+/*  Demangle cache file
+
+    Written by saveDemangleCacheFile for -demangle-cache, so later runs, in
+    this or other processes, skip names that were already demangled.
+    Everything is in host byte order. A DemangleFileHeader is followed by
+    DemangleFileRecords, each followed by the null-terminated mangled name,
+    the null-terminated demangled name unless 'demangledLength' is
+    DEMANGLE_FAILED, and padding to 4 bytes. Writers append records while
+    holding an exclusive flock, and readers take a shared one. A writer
+    that dies mid-append leaves a partial record at the end, which readers
+    ignore and the next writer truncates.
+*/
+typedef struct
+{
+    uint32_t    magic;      // DEMANGLE_FILE_MAGIC
+    uint32_t    version;    // DEMANGLE_FILE_VERSION
+}
+DemangleFileHeader;
+
+typedef struct
+{
+    uint32_t    mangledLength;
+    uint32_t    demangledLength;
+}
+DemangleFileRecord;
+
+#define DEMANGLE_FILE_MAGIC     0x4478746F  // "otxD" on little-endian
+#define DEMANGLE_FILE_VERSION   1
+#define DEMANGLE_FAILED         0xFFFFFFFF
+
 // Constants for dealing with objc_msgSend variants.
 enum {
     send,
@@ -121,17 +588,16 @@ enum {
     OCProtoRefType,     // 21 - objc2_protocol_t* in (__DATA,__objc_protorefs)
 };
 
-#define MAX_FIELD_SPACING           50      // spaces between fields
-#define MAX_FIELD_SPACES            "                                                  "  // 50 spaces
-#define MAX_FORMAT_LENGTH           50      // snprintf() format string
 #define MAX_OPERANDS_LENGTH         1000
 #define MAX_COMMENT_LENGTH          2000
 #define MAX_LINE_LENGTH             10000
 #define MAX_TYPE_STRING_LENGTH      200     // for encoded ObjC data types
-#define MAX_MD5_LINE                40      // for the md5 pipe
+#define MAX_CHECKSUM_LINE           100     // "sha256 (x86_64): ", 64 hex digits, '\n'
 #define MAX_ARCH_STRING_LENGTH      20      // "ppc", "i386" etc.
 #define MAX_UNIBIN_OTOOL_CMD_SIZE   MAXPATHLEN + MAX_ARCH_STRING_LENGTH + 7 // strlen(" -arch ")
 #define MAX_STACK_SIZE              40      // maximum number of stack variables
+#define MAX_GATHER_PASSES           4       // per function, see gatherFuncInfosForFunction:to:
+#define MAX_SAVED_REGISTERS         64      // bits in MachineState.validRegs
 
 #define ANON_FUNC_BASE          "Anon"
 #define ANON_FUNC_BASE_LENGTH   4
@@ -165,16 +631,67 @@ enum {
     NSString*           iOutputFilePath;
     uint32_t              iFileArchMagic;         // 0xCAFEBABE etc.
     BOOL                iExeIsFat;
-    ThunkInfo*          iThunks;                // x86 only
+    ThunkInfo*          iThunks;                // x86 only, sorted by address
     uint32_t              iNumThunks;             // x86 only
+    uint32_t            iMaxThunks;             // x86 only
     TextFieldWidths     iFieldWidths;
     ProcOptions         iOpts;
-    NSTask*             iCPFiltTask;
-    NSPipe*             iCPFiltInputPipe;
-    NSPipe*             iCPFiltOutputPipe;
+    DemangleCache*      iDemangleCache;         // shared with workers
+    dispatch_group_t    iChecksumGroup;         // see startChecksums
+    ChecksumDigest*     iChecksums;
+    uint32_t            iNumChecksums;
+
+    // -incremental, see loadIncrementalState
+    char*               iOldIncState;           // mapped, or NULL
+    size_t              iOldIncSize;
+    IncrementalFunc*    iOldIncFuncs;
+    uint32_t            iNumOldIncFuncs;
+    IncrementalEntry*   iOldIncLines;
+    const char*         iOldIncStrings;
+    IncrementalEntry*   iReusedLines;           // the current function's
+    uint32_t            iNumReusedLines;
+    uint32_t            iReusedLineIndex;
+    uint32_t            iNumReusedFuncs;
+    IncrementalFunc*    iIncFuncs;
+    uint32_t            iNumIncFuncs;
+    uint32_t            iMaxIncFuncs;
+    IncrementalLine*    iIncLines;
+    uint32_t            iNumIncLines;
+    uint32_t            iMaxIncLines;
+    StateArena          iIncStrings;
+    BOOL                iIncRecording;          // the current function
 
     uint32_t            iMatchedSelectorCount;
     uint32_t            iMissedSelectorCount;
+    uint32_t            iGatherPasses;
+    uint32_t            iBlockVisits;
+    UInt64              iCommentTicks;          // -debug, see printSummary
+    UInt64              iRegistersTicks;
+    uint32_t            iTimedLines;
+
+    // -xref index, see addXref:kind:site:function:
+    XrefSite*           iXrefs;
+    uint32_t            iNumXrefs;
+    uint32_t            iMaxXrefs;
+    XrefSite*           iXrefFuncs;
+    uint32_t            iNumXrefFuncs;
+    uint32_t            iMaxXrefFuncs;
+    StateArena          iXrefStrings;
+
+    // -toc, see addTocEntry:address:offset:
+    TocEntry*           iTocEntries;
+    uint32_t            iNumTocEntries;
+    uint32_t            iMaxTocEntries;
+    StateArena          iTocStrings;
+
+    // -records output, see recordInstruction:functionName:toCString:maxLength:
+    InsnRecord*         iInsnRecords;
+    uint32_t            iNumInsnRecords;
+    uint32_t            iMaxInsnRecords;
+    FuncRecord*         iFuncRecords;
+    uint32_t            iNumFuncRecords;
+    uint32_t            iMaxFuncRecords;
+    StateArena          iRecordStrings;
 
     // FunctionInfo stuff
     uint32_t              iCurrentGenericFuncNum;
@@ -189,6 +706,13 @@ enum {
     BOOL        iEnteringNewBlock;
     SInt64      iCurrentFuncInfoIndex;
 
+    // per-thread scratch state, formerly function statics
+    BOOL        iTypeIsArray;           // see getDescription:forType:
+    uint32_t    iPointerRecurseCount;   // see getPointer:type:
+    uint32_t    iStartOfComment;        // see entabCString:length:
+    const char* iLineSelector;          // see commentForMsgSend:fromLine:
+    const char* iLineClassName;         // ditto
+
     // saved strings
     char        iArchString[MAX_ARCH_STRING_LENGTH];    // "ppc", "i386" etc.
     char        iLineCommentCString[MAX_COMMENT_LENGTH];
@@ -199,10 +723,12 @@ enum {
        controller: (id)inController
           options: (ProcOptions*)inOptions;
 - (BOOL)printDataSections;
-- (void)printDataSection: (section_info*)inSect
-                  toFile: (FILE*)outFile;
+- (BOOL)printDataSection: (section_info*)inSect
+                toWriter: (OutputWriter*)ioWriter;
 - (UInt8)sendTypeFromMsgSend: (char*)inString;
 
+- (void)startChecksums;
+- (void)waitForChecksums;
 - (NSString*)generateMD5String;
 - (void)decodeMethodReturnType: (const char*)inTypeCode
                         output: (char*)outCString;
@@ -210,6 +736,78 @@ enum {
 - (void)getDescription: (char*)ioCString
                forType: (const char*)inTypeCode;
 
+- (void*)allocFromArena: (StateArena*)ioArena
+                   size: (size_t)inSize;
+- (void)resetArena: (StateArena*)ioArena;
+- (void)printEscapedString: (const char*)inString
+                    toFile: (FILE*)outFile;
+
+- (size_t)entabCString: (char*)ioCString
+                length: (size_t)inLength;
+
+- (void)demangleCString: (char*)ioCString
+              maxLength: (size_t)inMaxLength;
+- (char*)demangledName: (const char*)inName
+                length: (size_t)inLength;
+- (void)loadDemangleCacheFile;
+- (void)saveDemangleCacheFile;
+- (BOOL)trimDemangleCacheFile: (int)inFD
+                        stats: (struct stat*)inStats;
+
+- (BOOL)openOutputWriter: (OutputWriter*)outWriter
+                  toFile: (FILE*)inFile
+                 withToc: (BOOL)inWithToc;
+- (BOOL)writeOutput: (OutputWriter*)ioWriter
+              bytes: (const char*)inBytes
+             length: (size_t)inLength;
+- (BOOL)flushOutputWriter: (OutputWriter*)ioWriter;
+- (BOOL)endOutputBlock: (OutputWriter*)ioWriter;
+- (char*)deflateOutput: (OutputWriter*)ioWriter
+                 bytes: (const char*)inBytes
+                length: (size_t)inLength
+             newLength: (size_t*)outLength;
+- (BOOL)closeOutputWriter: (OutputWriter*)ioWriter;
+
+- (BOOL)printHexDump: (const UInt8*)inBytes
+              length: (size_t)inLength
+             address: (UInt64)inAddress
+       addressDigits: (UInt8)inDigits
+            toWriter: (OutputWriter*)ioWriter;
+
+- (void)addThunk: (ThunkInfo)inThunk;
+- (ThunkInfo*)findThunkAtAddress: (uint32_t)inAddress;
+
+- (void)addXref: (const char*)inKey
+           kind: (UInt8)inKind
+           site: (UInt64)inSite
+       function: (UInt64)inFunction;
+- (void)mergeXrefsFrom: (ExeProcessor*)inWorker;
+- (BOOL)writeXrefIndex;
+
+- (void)addTocEntry: (const char*)inName
+            address: (UInt64)inAddress
+             offset: (UInt64)inOffset;
+- (BOOL)writeTocFile: (OutputWriter*)inWriter;
+
+- (BOOL)writeSplitPieces: (SplitPiece*)inPieces
+                   count: (uint32_t)inCount;
+
+- (void)incrementalOptionsHash: (UInt8*)outHash;
+- (void)loadIncrementalState;
+- (IncrementalFunc*)findIncrementalFunc: (const UInt8*)inHash;
+- (void)beginIncrementalFunction: (const UInt8*)inHash;
+- (IncrementalEntry*)beginIncrementalLine;
+- (void)endIncrementalLine: (const char*)inComment
+                     flags: (uint32_t)inFlags;
+- (BOOL)writeIncrementalState;
+
+- (size_t)recordInstruction: (InsnRecord*)inRecord
+               functionName: (const char*)inName
+                  toCString: (char*)outCString
+                  maxLength: (size_t)inMaxLength;
+- (void)mergeRecordsFrom: (ExeProcessor*)inWorker;
+- (BOOL)writeColumnarRecords;
+
 - (void) printSummary;
 
 #ifdef OTX_DEBUG
@@ -244,6 +842,104 @@ Sym_Compare_64(
     return (sym1->n_value > sym2->n_value);
 }
 
+static int
+ThunkInfo_Compare(
+    ThunkInfo*  t1,
+    ThunkInfo*  t2)
+{
+    if (t1->address < t2->address)
+        return -1;
+
+    return (t1->address > t2->address);
+}
+
+static int
+XrefSite_Compare(
+    XrefSite*   x1,
+    XrefSite*   x2)
+{
+    if (x1->kind != x2->kind)
+        return (x1->kind < x2->kind) ? -1 : 1;
+
+    int result  = strcmp(x1->key, x2->key);
+
+    if (result)
+        return result;
+
+    if (x1->site < x2->site)
+        return -1;
+
+    return (x1->site > x2->site);
+}
+
+static int
+XrefSite_Address_Compare(
+    XrefSite*   x1,
+    XrefSite*   x2)
+{
+    if (x1->site < x2->site)
+        return -1;
+
+    return (x1->site > x2->site);
+}
+
+static int
+TocEntry_Compare(
+    TocEntry*   t1,
+    TocEntry*   t2)
+{
+    if (t1->address < t2->address)
+        return -1;
+
+    return (t1->address > t2->address);
+}
+
+static int
+IncrementalFunc_Compare(
+    IncrementalFunc*    f1,
+    IncrementalFunc*    f2)
+{
+    return memcmp(f1->hash, f2->hash, INCREMENTAL_HASH_LENGTH);
+}
+
+static int
+SplitPiece_Compare(
+    SplitPiece* p1,
+    SplitPiece* p2)
+{
+    int result  = strcmp(p1->name, p2->name);
+
+    if (result)
+        return result;
+
+    if (p1->index < p2->index)
+        return -1;
+
+    return (p1->index > p2->index);
+}
+
+static int
+InsnRecord_Compare(
+    InsnRecord* r1,
+    InsnRecord* r2)
+{
+    if (r1->address < r2->address)
+        return -1;
+
+    return (r1->address > r2->address);
+}
+
+static int
+FuncRecord_Compare(
+    FuncRecord* r1,
+    FuncRecord* r2)
+{
+    if (r1->address < r2->address)
+        return -1;
+
+    return (r1->address > r2->address);
+}
+
 static int
 objc2_32_ivar_t_Compare(
     objc2_32_ivar_t* i1,
@@ -258,6 +954,504 @@ objc2_32_ivar_t_Compare(
 // ----------------------------------------------------------------------------
 // Utils
 
+// Append inValue to the inLength chars of ioLine and pad it with spaces to
+// inWidth, leaving at least one. Return the new length.
+static size_t
+AppendField(
+    char*       ioLine,
+    size_t      inLength,
+    const char* inValue,
+    size_t      inWidth)
+{
+    size_t  valueLength = strlen(inValue);
+    size_t  padLength   = (valueLength < inWidth) ? inWidth - valueLength : 1;
+
+    memcpy(&ioLine[inLength], inValue, valueLength);
+    memset(&ioLine[inLength + valueLength], ' ', padLength);
+
+    return inLength + valueLength + padLength;
+}
+
+// Point ioName past the newlines before one of otool's function name lines
+// and return the name's length, without trailing newlines, spaces or colon.
+static size_t
+TrimFunctionName(
+    const char**    ioName)
+{
+    const char* name    = *ioName;
+    size_t      length;
+
+    while (*name == '\n')
+        name++;
+
+    length  = strlen(name);
+
+    while (length && (name[length - 1] == '\n' || name[length - 1] == ' '))
+        length--;
+
+    if (length && name[length - 1] == ':')
+        length--;
+
+    *ioName = name;
+
+    return length;
+}
+
+// Return the -split name of the file that holds the function named by
+// otool's name line inName. Obj-C methods, named by processCodeLine: as
+// "-[Class sel]", "+(type)[Class(Category) sel]" etc., go in a file per
+// class, named "classes/Class". Other functions get a file each, named
+// "functions/" and the function's name. See SplitPathForName for the
+// file's path. The caller frees the result.
+static char*
+SplitNameForFunction(
+    const char* inName)
+{
+    size_t      nameLength  = TrimFunctionName(&inName);
+    const char* dirName     = "functions";
+    const char* bracket     = NULL;
+    size_t      i;
+
+    if (nameLength && (inName[0] == '-' || inName[0] == '+'))
+        bracket = memchr(inName, '[', nameLength);
+
+    if (bracket)
+    {
+        dirName     = "classes";
+        nameLength -= bracket + 1 - inName;
+        inName      = bracket + 1;
+
+        for (i = 0; i < nameLength; i++)
+            if (inName[i] == ' ' || inName[i] == '(' || inName[i] == ']')
+                break;
+
+        nameLength  = i;
+    }
+
+    if (!nameLength)
+    {
+        inName      = "unnamed";
+        nameLength  = strlen(inName);
+    }
+
+    size_t  maxLength   = strlen(dirName) + nameLength + 2;
+    char*   theName     = malloc(maxLength);
+
+    if (theName)
+        snprintf(theName, maxLength, "%s/%.*s", dirName, (int)nameLength,
+            inName);
+
+    return theName;
+}
+
+// Return the path, relative to the output directory, of the -split file
+// named inName, see SplitNameForFunction. Everything after the directory is
+// made portable and kept out of other directories, which can make different
+// names share a path. writeSplitPieces:count: then passes a nonzero inCopy
+// for all but the first, which adds a "~inCopy" suffix. Portable names
+// never have a '~', so the suffix can't clash with them. The caller frees
+// the result.
+static char*
+SplitPathForName(
+    const char* inName,
+    uint32_t    inCopy)
+{
+    const char* slash   = strchr(inName, '/');
+    char        thePath[SPLIT_MAX_NAME_LENGTH + 40];
+    size_t      i, j    = 0;
+
+    if (slash)
+    {
+        j       = slash + 1 - inName;
+        memcpy(thePath, inName, j);
+        inName  = slash + 1;
+    }
+
+    for (i = 0; inName[i] && i < SPLIT_MAX_NAME_LENGTH; i++)
+    {
+        char    theChar = inName[i];
+
+        thePath[j++]    = (isalnum((UInt8)theChar) || theChar == '_' ||
+            theChar == '-' || theChar == '+' || theChar == '.') ? theChar : '_';
+    }
+
+    if (inCopy)
+        j  += snprintf(&thePath[j], sizeof(thePath) - j, "~%u", inCopy);
+
+    snprintf(&thePath[j], sizeof(thePath) - j, ".txt");
+
+    return strdup(thePath);
+}
+
+// Sort SplitFiles by path, ignoring case, then in output order.
+static int
+SplitFile_Compare(
+    SplitFile*  f1,
+    SplitFile*  f2)
+{
+    int result  = strcasecmp(f1->path, f2->path);
+
+    if (result)
+        return result;
+
+    if (f1->index < f2->index)
+        return -1;
+
+    return (f1->index > f2->index);
+}
+
+// Append ',"inKey":"inValue"' to the inLength chars of ioLine, escaping
+// inValue for JSON, unless inValue is empty. Stops short of inMaxLength - 1
+// chars, truncating inValue if necessary. Return the new length.
+static size_t
+AppendJSONField(
+    char*       ioLine,
+    size_t      inLength,
+    size_t      inMaxLength,
+    const char* inKey,
+    const char* inValue)
+{
+    if (!inValue || !inValue[0])
+        return inLength;
+
+    size_t  keyLength   = strlen(inKey);
+
+    // ,"":"" plus the longest escape
+    if (inLength + keyLength + 12 >= inMaxLength)
+        return inLength;
+
+    ioLine[inLength++]  = ',';
+    ioLine[inLength++]  = '"';
+    memcpy(&ioLine[inLength], inKey, keyLength);
+    inLength           += keyLength;
+    ioLine[inLength++]  = '"';
+    ioLine[inLength++]  = ':';
+    ioLine[inLength++]  = '"';
+
+    for (; *inValue && inLength + 7 < inMaxLength; inValue++)
+    {
+        UInt8   theChar = *inValue;
+
+        if (theChar == '"' || theChar == '\\')
+        {
+            ioLine[inLength++]  = '\\';
+            ioLine[inLength++]  = theChar;
+        }
+        else if (theChar < 0x20)
+            inLength   += snprintf(&ioLine[inLength], 7, "\\u%04x", theChar);
+        else
+            ioLine[inLength++]  = theChar;
+    }
+
+    ioLine[inLength++]  = '"';
+    ioLine[inLength]    = 0;
+
+    return inLength;
+}
+
+// Format inLength bytes as hex dump rows into outBuffer, which must hold
+// HEXDUMP_ROW_LENGTH(inDigits) chars per 16 bytes, and return the number of
+// chars written. The last row is padded so its ASCII lines up. inBytes is
+// only read.
+static size_t
+FormatHexRows(
+    char*           outBuffer,
+    const UInt8*    inBytes,
+    size_t          inLength,
+    UInt64          inAddress,
+    UInt8           inDigits)
+{
+    static const char   hexDigits[]   = "0123456789abcdef";
+    char*               out             = outBuffer;
+    size_t              i, k;
+
+    for (i = 0; i < inLength; i += 16)
+    {
+        const UInt8*    row         = &inBytes[i];
+        size_t          rowLength   = MIN(16, inLength - i);
+        UInt64          address     = inAddress + i;
+        SInt8           d;
+
+        for (d = inDigits - 1; d >= 0; d--)
+        {
+            out[d]      = hexDigits[address & 0xf];
+            address   >>= 4;
+        }
+
+        out    += inDigits;
+        *out++  = ' ';
+        *out++  = '|';
+
+        for (k = 0; k < 16; k++)
+        {
+            if (!(k % 4))
+                *out++  = ' ';
+
+            if (k < rowLength)
+            {
+                out[0]  = hexDigits[row[k] >> 4];
+                out[1]  = hexDigits[row[k] & 0xf];
+            }
+            else
+                out[0]  = out[1]    = ' ';
+
+            out += 2;
+        }
+
+        *out++  = ' ';
+        *out++  = ' ';
+
+        for (k = 0; k < rowLength; k++)
+            *out++  = (row[k] < 0x20 || row[k] == 0x7f) ? '.' : row[k];
+
+        *out++  = '\n';
+    }
+
+    return out - outBuffer;
+}
+
+// FNV-1a
+static uint32_t
+DemangleCache_Hash(
+    const char* inName,
+    size_t      inLength)
+{
+    uint32_t    hash    = 2166136261U;
+    size_t      i;
+
+    for (i = 0; i < inLength; i++)
+        hash    = (hash ^ (UInt8)inName[i]) * 16777619U;
+
+    return hash;
+}
+
+// Return the entry for the first inLength chars of inName, or the empty slot
+// where it belongs.
+static DemangleEntry*
+DemangleCache_Find(
+    DemangleCache*  inCache,
+    const char*     inName,
+    size_t          inLength,
+    uint32_t        inHash)
+{
+    uint32_t        mask    = inCache->maxEntries - 1;
+    uint32_t        slot    = inHash & mask;
+    DemangleEntry*  entry   = &inCache->entries[slot];
+
+    while (entry->mangled)
+    {
+        if (entry->hash == inHash && !strncmp(entry->mangled, inName, inLength)
+            && entry->mangled[inLength] == 0)
+            break;
+
+        slot    = (slot + 1) & mask;
+        entry   = &inCache->entries[slot];
+    }
+
+    return entry;
+}
+
+// Size of the -demangle-cache record inOffset bytes into the inSize bytes at
+// inBase, or 0 if there isn't a whole one there.
+static size_t
+DemangleFile_RecordSize(
+    const char* inBase,
+    size_t      inOffset,
+    size_t      inSize)
+{
+    if (inOffset + sizeof(DemangleFileRecord) > inSize)
+        return 0;
+
+    DemangleFileRecord* record      = (DemangleFileRecord*)(inBase + inOffset);
+    const char*         mangled     = inBase + inOffset +
+        sizeof(DemangleFileRecord);
+    BOOL                demangled   =
+        (record->demangledLength != DEMANGLE_FAILED);
+    size_t              recordSize  = sizeof(DemangleFileRecord) +
+        (size_t)record->mangledLength + 1;
+
+    if (record->mangledLength > inSize ||
+        (demangled && record->demangledLength > inSize))
+        return 0;
+
+    if (demangled)
+        recordSize += (size_t)record->demangledLength + 1;
+
+    recordSize  = (recordSize + 3) & ~3;
+
+    if (recordSize > inSize - inOffset || mangled[record->mangledLength] != 0 ||
+        (demangled &&
+        mangled[record->mangledLength + 1 + record->demangledLength] != 0))
+        return 0;
+
+    return recordSize;
+}
+
+// Make room for one more entry, growing the table to keep it at most half
+// full. Slots found before this returns YES may have moved.
+static BOOL
+DemangleCache_Reserve(
+    DemangleCache*  ioCache)
+{
+    if ((ioCache->numEntries + 1) * 2 > ioCache->maxEntries)
+    {
+        DemangleEntry*  oldEntries  = ioCache->entries;
+        uint32_t        oldMax      = ioCache->maxEntries;
+        DemangleEntry*  newEntries  =
+            calloc(oldMax * 2, sizeof(DemangleEntry));
+        uint32_t        i;
+
+        if (newEntries)
+        {
+            ioCache->entries    = newEntries;
+            ioCache->maxEntries = oldMax * 2;
+
+            for (i = 0; i < oldMax; i++)
+            {
+                if (!oldEntries[i].mangled)
+                    continue;
+
+                *DemangleCache_Find(ioCache, oldEntries[i].mangled,
+                    strlen(oldEntries[i].mangled), oldEntries[i].hash) =
+                    oldEntries[i];
+            }
+
+            free(oldEntries);
+        }
+    }
+
+    // Never fill the last empty slot, lookups rely on finding one.
+    return (ioCache->numEntries + 1 < ioCache->maxEntries);
+}
+
+// Add one code line of otool's verbose output, minus its address, to a
+// function's -incremental hash. Code addresses, including %rip targets
+// counted from inNextAddress, become signed offsets from the function's
+// start, so the hash survives the function moving. A %rip operand's data
+// target is hashed as "@data", immediates and other addresses as they are.
+// The line's data addresses, and immediates outside __text that may be
+// addresses, go to outDataAddys, and their number is returned. The caller
+// hashes what they point to, since the comments are built from that.
+static uint32_t
+FunctionHash_AddLine(
+    CC_SHA256_CTX*  ioContext,
+    const char*     inText,
+    UInt64          inOffset,
+    UInt64          inNextAddress,
+    UInt64          inFuncStart,
+    UInt64          inTextStart,
+    UInt64          inTextEnd,
+    UInt64*         outDataAddys)   // FUNCTION_HASH_MAX_DATA of them
+{
+    char        theCString[MAX_LINE_LENGTH];
+    size_t      length      = 0;
+    uint32_t    numAddys    = 0;
+    const char* p           = inText;
+
+    CC_SHA256_Update(ioContext, &inOffset, sizeof(inOffset));
+
+    while (*p && length < MAX_LINE_LENGTH - 24)
+    {
+        if (p[0] != '0' || p[1] != 'x' || !isxdigit(p[2]) ||
+            (p > inText && isalnum(p[-1])))
+        {
+            theCString[length++]    = *p++;
+            continue;
+        }
+
+        char*   end     = NULL;
+        UInt64  value   = strtoull(p + 2, &end, 16);
+        BOOL    isImm   = (p > inText && p[-1] == '$');
+        BOOL    isData  = NO;
+
+        if (!isImm && !strncmp(end, "(%rip)", 6))
+        {
+            // The '-' of a negative displacement is already copied.
+            if (length && theCString[length - 1] == '-')
+            {
+                length--;
+                value   = inNextAddress - value;
+            }
+            else
+                value   = inNextAddress + value;
+
+            isData  = (value < inTextStart || value >= inTextEnd);
+        }
+
+        if (!isImm && !isData && value >= inTextStart && value < inTextEnd)
+        {
+            if (value >= inFuncStart)
+                length += snprintf(&theCString[length], 24, "@%llx",
+                    value - inFuncStart);
+            else
+                length += snprintf(&theCString[length], 24, "@-%llx",
+                    inFuncStart - value);
+        }
+        else
+        {
+            if (isData)
+                length += snprintf(&theCString[length], 24, "@data");
+            else
+                length += snprintf(&theCString[length], 24, "0x%llx", value);
+
+            if ((value < inTextStart || value >= inTextEnd) &&
+                numAddys < FUNCTION_HASH_MAX_DATA)
+                outDataAddys[numAddys++]    = value;
+        }
+
+        p   = end;
+    }
+
+    CC_SHA256_Update(ioContext, theCString, length);
+
+    return numAddys;
+}
+
+// Return the offset of inString in ioStrings' blob, adding it if it's not
+// there yet, or UINT32_MAX if we ran out of memory. The empty string is
+// always at offset 0.
+static uint32_t
+RecordStrings_Intern(
+    RecordStrings*  ioStrings,
+    const char*     inString)
+{
+    if (!inString || !inString[0])
+        return 0;
+
+    uint32_t    length  = strlen(inString);
+    uint32_t    mask    = ioStrings->maxSlots - 1;
+    uint32_t    slot    = DemangleCache_Hash(inString, length) & mask;
+
+    while (ioStrings->slots[slot])
+    {
+        if (!strcmp(&ioStrings->strings[ioStrings->slots[slot] - 1], inString))
+            return ioStrings->slots[slot] - 1;
+
+        slot    = (slot + 1) & mask;
+    }
+
+    if (ioStrings->size + length + 1 > ioStrings->maxSize)
+    {
+        uint32_t    newMax      =
+            MAX(ioStrings->maxSize * 2, ioStrings->size + length + 1);
+        char*       newStrings  = realloc(ioStrings->strings, newMax);
+
+        if (!newStrings)
+            return UINT32_MAX;
+
+        ioStrings->strings  = newStrings;
+        ioStrings->maxSize  = newMax;
+    }
+
+    uint32_t    offset  = ioStrings->size;
+
+    memcpy(&ioStrings->strings[offset], inString, length + 1);
+    ioStrings->size         += length + 1;
+    ioStrings->slots[slot]   = offset + 1;
+
+    return offset;
+}
+
 // This could be a macro if I could figure out the syntax
 static int
 strcmp_sectname(const char *data, const char *str)
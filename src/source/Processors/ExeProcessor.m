@@ -9,6 +9,8 @@
 
 #import <Cocoa/Cocoa.h>
 
+#import <mach/mach_time.h>
+
 #import "ExeProcessor.h"
 #import "ArchSpecifics.h"
 #import "ListUtils.h"
@@ -17,6 +19,10 @@
 #import "SysUtils.h"
 #import "UserDefaultKeys.h"
 
+// libc++abi's Itanium ABI demangler, the same one c++filt uses.
+extern char* __cxa_demangle(
+    const char* inMangledName, char* ioBuffer, size_t* ioLength, int* outStatus);
+
 @implementation ExeProcessor
 
 // ExeProcessor is a base class that handles processor-independent issues.
@@ -81,20 +87,32 @@
     iFileArchMagic  = *(uint32_t*)iRAMFile;
     iExeIsFat   = (iFileArchMagic == FAT_MAGIC || iFileArchMagic == FAT_CIGAM);
 
-    // Setup the C++ name demangler.
+    // Setup the C++ name demangler's cache.
     if (iOpts.demangleCppNames)
     {
-        NSArray* args = [NSArray arrayWithObjects: @"-_", nil];
+        iDemangleCache  = calloc(1, sizeof(DemangleCache));
+
+        if (iDemangleCache)
+            iDemangleCache->entries =
+                calloc(DEMANGLE_CACHE_SIZE, sizeof(DemangleEntry));
+
+        if (!iDemangleCache || !iDemangleCache->entries)
+        {
+            fprintf(stderr, "otx: not enough memory to demangle C++ names\n");
+
+            if (iDemangleCache)
+                free(iDemangleCache);
 
-        iCPFiltTask = [[NSTask alloc] init];
-        iCPFiltInputPipe = [[NSPipe alloc] init];
-        iCPFiltOutputPipe = [[NSPipe alloc] init];
+            iDemangleCache  = NULL;
+        }
+        else
+        {
+            iDemangleCache->maxEntries  = DEMANGLE_CACHE_SIZE;
+            pthread_mutex_init(&iDemangleCache->lock, NULL);
 
-        [iCPFiltTask setLaunchPath: @"/usr/bin/c++filt"];
-        [iCPFiltTask setArguments: args];
-        [iCPFiltTask setStandardInput: iCPFiltInputPipe];
-        [iCPFiltTask setStandardOutput: iCPFiltOutputPipe];
-        [iCPFiltTask launch];
+            if (iOpts.demangleCachePath)
+                [self loadDemangleCacheFile];
+        }
     }
 
     return self;
@@ -105,6 +123,15 @@
 
 - (void)dealloc
 {
+    // The hashing reads iRAMFile.
+    [self waitForChecksums];
+
+    if (iChecksumGroup)
+    {
+        dispatch_release(iChecksumGroup);
+        iChecksumGroup  = NULL;
+    }
+
     if (iRAMFile)
     {
         free(iRAMFile);
@@ -117,22 +144,79 @@
         iThunks = NULL;
     }
 
-    if (iCPFiltInputPipe)
+    if (iXrefs)
+    {
+        free(iXrefs);
+        iXrefs  = NULL;
+    }
+
+    if (iXrefFuncs)
+    {
+        free(iXrefFuncs);
+        iXrefFuncs  = NULL;
+    }
+
+    [self resetArena: &iXrefStrings];
+
+    if (iInsnRecords)
+    {
+        free(iInsnRecords);
+        iInsnRecords    = NULL;
+    }
+
+    if (iFuncRecords)
+    {
+        free(iFuncRecords);
+        iFuncRecords    = NULL;
+    }
+
+    [self resetArena: &iRecordStrings];
+
+    if (iTocEntries)
+    {
+        free(iTocEntries);
+        iTocEntries = NULL;
+    }
+
+    [self resetArena: &iTocStrings];
+
+    if (iChecksums)
+    {
+        free(iChecksums);
+        iChecksums  = NULL;
+    }
+
+    if (iOldIncState)
+    {
+        munmap(iOldIncState, iOldIncSize);
+        iOldIncState    = NULL;
+    }
+
+    if (iIncFuncs)
     {
-        [iCPFiltInputPipe release];
-        iCPFiltInputPipe = nil;
+        free(iIncFuncs);
+        iIncFuncs   = NULL;
     }
 
-    if (iCPFiltOutputPipe)
+    if (iIncLines)
     {
-        [iCPFiltOutputPipe release];
-        iCPFiltOutputPipe = nil;
+        free(iIncLines);
+        iIncLines   = NULL;
     }
 
-    if (iCPFiltTask)
+    [self resetArena: &iIncStrings];
+
+    if (iDemangleCache)
     {
-        [iCPFiltTask terminate];
-        [iCPFiltTask release];
+        free(iDemangleCache->entries);
+        [self resetArena: &iDemangleCache->strings];
+
+        if (iDemangleCache->mappedFile)
+            munmap(iDemangleCache->mappedFile, iDemangleCache->mappedSize);
+
+        pthread_mutex_destroy(&iDemangleCache->lock);
+        free(iDemangleCache);
+        iDemangleCache  = NULL;
     }
 
     [super dealloc];
@@ -202,14 +286,12 @@
     So, any occurence of 'c' may be a char or a BOOL. The best option I can
     see is to treat arrays as char arrays and atomic values as BOOL, and maybe
     let the user disagree via preferences. Since the data type of an array is
-    decoded with a recursive call, we can use the following static variable
-    for this purpose.
+    decoded with a recursive call, we can use the iTypeIsArray ivar for this
+    purpose.
 
     As of otx 0.14b, letting the user override this behavior with a pref is
     left as an exercise for the reader.
 */
-    static BOOL isArray = NO;
-
     // Convert '^^' prefix to '**' suffix.
     while (inTypeCode[theNextChar] == '^')
     {
@@ -273,7 +355,7 @@
             strncpy(theTypeCString, "bool", 5);
             break;
         case 'c':
-            strncpy(theTypeCString, (isArray) ? "char" : "BOOL", 5);
+            strncpy(theTypeCString, (iTypeIsArray) ? "char" : "BOOL", 5);
             break;
         case 'C':
             strncpy(theTypeCString, "unsigned char", 14);
@@ -342,9 +424,9 @@
 
             theCType[0] = 0;
 
-            isArray = YES;
+            iTypeIsArray = YES;
             [self getDescription:theCType forType:&inTypeCode[theNextChar]];
-            isArray = NO;
+            iTypeIsArray = NO;
 
             snprintf(theTypeCString, MAX_TYPE_STRING_LENGTH, "%s[%s]", theCType, theArrayCCount);
 
@@ -369,94 +451,184 @@
     return NO;
 }
 
-- (void)printDataSection: (section_info*)inSect
-                  toFile: (FILE*)outFile
-{}
+- (BOOL)printDataSection: (section_info*)inSect
+                toWriter: (OutputWriter*)ioWriter
+{
+    return NO;
+}
 
-- (NSString*)generateMD5String
+//  startChecksums
+// ----------------------------------------------------------------------------
+//  Hash the exe we already have in RAM on a background queue, so the digests
+//  are ready by the time otool is done. Universal binaries also get one
+//  digest per slice. generateMD5String waits for the result.
+
+- (void)startChecksums
 {
-    NSString* md5Path = [NSString pathWithComponents: [NSArray arrayWithObjects:
-        @"/", @"sbin", @"md5", nil]];
-    NSTask* md5Task = [[[NSTask alloc] init] autorelease];
-    NSPipe* md5Pipe = [NSPipe pipe];
-    NSPipe* errorPipe = [NSPipe pipe];
-    NSArray* args = [NSArray arrayWithObjects: @"-q", [iOFile path], nil];
+    if (iChecksumGroup)
+        return;
 
-    [md5Task setLaunchPath: md5Path];
-    [md5Task setArguments: args];
-    [md5Task setStandardInput: [NSPipe pipe]];
-    [md5Task setStandardOutput: md5Pipe];
-    [md5Task setStandardError: errorPipe];
+    uint32_t    numSlices   = 0;
+    fat_arch*   faPtr       = NULL;
 
-    @try
+    if (iExeIsFat && iRAMFileSize >= sizeof(fat_header))
     {
-        [md5Task launch];
+        fat_header  fh  = *(fat_header*)iRAMFile;
+
+        // fat_header and fat_arch are always big-endian. Swap if necessary.
+#if TARGET_RT_LITTLE_ENDIAN
+        swap_fat_header(&fh, OSLittleEndian);
+#endif
+
+        faPtr   = (fat_arch*)(iRAMFile + sizeof(fat_header));
+
+        if (fh.nfat_arch <= (iRAMFileSize - sizeof(fat_header)) / sizeof(fat_arch))
+            numSlices   = fh.nfat_arch;
     }
-    @catch (NSException* e)
+
+    iChecksums  = calloc(numSlices + 1, sizeof(ChecksumDigest));
+
+    if (!iChecksums)
     {
-        NSLog(@"otx: unable to launch md5: %@", [e reason]);
-        return nil;
+        fprintf(stderr, "otx: not enough memory for checksums\n");
+        return;
     }
 
-    [md5Task waitUntilExit];
+    iChecksums[0].size  = iRAMFileSize;
+    iNumChecksums       = 1;
 
-    int md5Status = [md5Task terminationStatus];
+    uint32_t    i;
 
-    if (md5Status != 0) // md5Task failed, log and bail
+    for (i = 0; i < numSlices; i++)
     {
-        NSData* errorData = nil;
+        fat_arch    fa  = faPtr[i];
 
-        @try
-        {
-            errorData = [[errorPipe fileHandleForReading] availableData];
-        }
-        @catch (NSException* e)
-        {
-            NSLog(@"otx: unable to read data from md5 error for \"%@\": %@", [iOFile path], [e reason]);
-            return nil;
-        }
+#if TARGET_RT_LITTLE_ENDIAN
+        swap_fat_arch(&fa, 1, OSLittleEndian);
+#endif
 
-        if (errorData == nil)
+        if (fa.offset > iRAMFileSize || fa.size > iRAMFileSize - fa.offset)
         {
-            NSLog(@"otx: md5 error data is nil for \"%@\"", [iOFile path]);
-            return nil;
+            fprintf(stderr, "otx: skipping truncated slice %u in checksums\n", i);
+            continue;
         }
 
-        NSString* errorString = [[[NSString alloc] initWithBytes: [errorData bytes]
-                                                          length: [errorData length]
-                                                        encoding: NSUTF8StringEncoding] autorelease];
+        const NXArchInfo*   archInfo    =
+            NXGetArchInfoFromCpuType(fa.cputype, fa.cpusubtype);
 
-        if (errorString == nil || [errorString length] == 0)
-            errorString = @"unknown error";
+        if (!archInfo)
+            archInfo    = NXGetArchInfoFromCpuType(fa.cputype, CPU_SUBTYPE_MULTIPLE);
 
-        NSLog(@"otx: unable to generate md5 checksum for \"%@\": %@", [iOFile path], errorString);
-        return nil;
+        iChecksums[iNumChecksums].archName  = archInfo ? archInfo->name : "unknown";
+        iChecksums[iNumChecksums].offset    = fa.offset;
+        iChecksums[iNumChecksums].size      = fa.size;
+        iNumChecksums++;
     }
 
-    NSData* md5Data = nil;
+    // The whole file and each slice hash on their own threads.
+    ChecksumDigest* digests     = iChecksums;
+    uint32_t        numDigests  = iNumChecksums;
+    BOOL            sha256      = iOpts.sha256Checksum;
+    const UInt8*    fileBytes   = (const UInt8*)iRAMFile;
+
+    iChecksumGroup  = dispatch_group_create();
+    dispatch_group_async(iChecksumGroup,
+        dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+        ^{
+            dispatch_apply(numDigests,
+                dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                ^(size_t inIndex)
+                {
+                    ChecksumDigest* digest  = &digests[inIndex];
+
+                    CC_MD5(fileBytes + digest->offset, digest->size, digest->md5);
+
+                    if (sha256)
+                        CC_SHA256(fileBytes + digest->offset, digest->size,
+                            digest->sha256);
+                });
+        });
+}
 
-    @try
-    {
-        md5Data = [[md5Pipe fileHandleForReading] availableData];
-    }
-    @catch (NSException* e)
+//  waitForChecksums
+// ----------------------------------------------------------------------------
+//  Block until the hashing from startChecksums, if any, is done with
+//  iRAMFile. The digests stay in iChecksums.
+
+- (void)waitForChecksums
+{
+    if (iChecksumGroup)
+        dispatch_group_wait(iChecksumGroup, DISPATCH_TIME_FOREVER);
+}
+
+//  generateMD5String
+// ----------------------------------------------------------------------------
+//  Wait for the digests from startChecksums and format them as lines for the
+//  top of the output. Starts the hashing itself if nobody else did.
+
+- (NSString*)generateMD5String
+{
+    if (!iChecksumGroup)
+        [self startChecksums];
+
+    if (!iChecksumGroup)
+        return nil;
+
+    [self waitForChecksums];
+
+    uint32_t    numLines    = iNumChecksums * (iOpts.sha256Checksum ? 2 : 1);
+    size_t      maxLength   = numLines * MAX_CHECKSUM_LINE + 2;
+    char*       theCString  = malloc(maxLength);
+
+    if (!theCString)
     {
-        NSLog(@"otx: unable to read from md5 data for \"%@\": %@", [iOFile path], [e reason]);
+        fprintf(stderr, "otx: not enough memory for checksums\n");
         return nil;
     }
 
-    if (md5Data == nil || [md5Data length] == 0) // md5Task produced no data, log and bail
+    static const char   hexDigits[] = "0123456789abcdef";
+    size_t              length      = 0;
+    uint32_t            pass;
+    uint32_t            i;
+
+    theCString[length++]    = '\n';
+
+    for (pass = 0; pass < (iOpts.sha256Checksum ? 2 : 1); pass++)
     {
-        NSLog(@"otx: unexpected failure while generating md5 checksum of \"%@\"", [iOFile path]);
-        return nil;
+        const char* digestName      = pass ? "sha256" : "md5";
+        uint32_t    digestLength    = pass ?
+            CC_SHA256_DIGEST_LENGTH : CC_MD5_DIGEST_LENGTH;
+
+        for (i = 0; i < iNumChecksums; i++)
+        {
+            const UInt8*    digest  = pass ?
+                iChecksums[i].sha256 : iChecksums[i].md5;
+            uint32_t        j;
+
+            if (iChecksums[i].archName)
+                length  += snprintf(&theCString[length], maxLength - length,
+                    "%s (%.*s): ", digestName, MAX_ARCH_STRING_LENGTH,
+                    iChecksums[i].archName);
+            else
+                length  += snprintf(&theCString[length], maxLength - length,
+                    "%s: ", digestName);
+
+            for (j = 0; j < digestLength; j++)
+            {
+                theCString[length++]    = hexDigits[digest[j] >> 4];
+                theCString[length++]    = hexDigits[digest[j] & 0xf];
+            }
+
+            theCString[length++]    = '\n';
+        }
     }
 
-    NSString* stringFromData = [[[NSString alloc] initWithBytes: [md5Data bytes]
-                                                         length: [md5Data length]
-                                                       encoding: NSUTF8StringEncoding] autorelease];
+    NSString*   theString   = [[[NSString alloc] initWithBytes: theCString
+        length: length encoding: NSASCIIStringEncoding] autorelease];
 
-    return [NSString stringWithFormat: @"\nmd5: %@\n", [stringFromData stringByTrimmingCharactersInSet:
-        [NSCharacterSet whitespaceAndNewlineCharacterSet]]];
+    free(theCString);
+
+    return theString;
 }
 
 #pragma mark -
@@ -500,92 +672,2226 @@
     [self getDescription:outCString forType:&inTypeCode[theNextChar]];
 }
 
-
-#ifdef OTX_DEBUG
-//  printSymbol:
+#pragma mark -
+//  allocFromArena:size:
 // ----------------------------------------------------------------------------
-//  Used for symbol debugging.
+//  Return inSize bytes from the arena's current chunk, starting a new chunk
+//  if it's full. The memory is 16-byte aligned and not zeroed.
 
-- (void)printSymbol: (nlist)inSym
+- (void*)allocFromArena: (StateArena*)ioArena
+                   size: (size_t)inSize
 {
-    fprintf(stderr, "----------------\n\n");
-    fprintf(stderr, " n_strx = 0x%08x\n", inSym.n_un.n_strx);
-    fprintf(stderr, " n_type = 0x%02x\n", inSym.n_type);
-    fprintf(stderr, " n_sect = 0x%02x\n", inSym.n_sect);
-    fprintf(stderr, " n_desc = 0x%04x\n", inSym.n_desc);
-    fprintf(stderr, "n_value = 0x%08x (%u)\n\n", inSym.n_value, inSym.n_value);
+    ArenaChunk* chunk   = ioArena->chunks;
 
-    if ((inSym.n_type & N_STAB) != 0)
-    {   // too complicated, see <mach-o/stab.h>
-        fprintf(stderr, "STAB symbol\n");
+    inSize  = (inSize + 15) & ~15;
+
+    if (!chunk || chunk->used + inSize > chunk->size)
+    {
+        size_t  size    = MAX(ARENA_CHUNK_SIZE, inSize);
+
+        chunk   = malloc(ARENA_HEADER_SIZE + size);
+
+        if (!chunk)
+        {
+            fprintf(stderr, "otx: not enough memory for saved states\n");
+            return NULL;
+        }
+
+        chunk->next     = ioArena->chunks;
+        chunk->size     = size;
+        chunk->used     = 0;
+        ioArena->chunks = chunk;
     }
-    else    // not a STAB
+
+    void*   ptr = (char*)chunk + ARENA_HEADER_SIZE + chunk->used;
+
+    chunk->used += inSize;
+
+    return ptr;
+}
+
+//  resetArena:
+// ----------------------------------------------------------------------------
+//  Free everything allocated from the arena.
+
+- (void)resetArena: (StateArena*)ioArena
+{
+    ArenaChunk* chunk   = ioArena->chunks;
+
+    while (chunk)
     {
-        if ((inSym.n_type & N_PEXT) != 0)
-            fprintf(stderr, "Private external symbol\n\n");
-        else if ((inSym.n_type & N_EXT) != 0)
-            fprintf(stderr, "External symbol\n\n");
+        ArenaChunk* next    = chunk->next;
 
-        UInt8   theNType    = inSym.n_type & N_TYPE;
-        UInt16  theRefType  = inSym.n_desc & REFERENCE_TYPE;
+        free(chunk);
+        chunk   = next;
+    }
 
-        fprintf(stderr, "Symbol type: ");
+    ioArena->chunks = NULL;
+}
 
-        if (theNType == N_ABS)
-            fprintf(stderr, "Absolute\n");
-        else if (theNType == N_SECT)
-            fprintf(stderr, "Defined in section %u\n", inSym.n_sect);
-        else if (theNType == N_INDR)
-            fprintf(stderr, "Indirect\n");
+//  printEscapedString:toFile:
+// ----------------------------------------------------------------------------
+//  Write inString for use inside double quotes in DOT or JSON output.
+
+- (void)printEscapedString: (const char*)inString
+                    toFile: (FILE*)outFile
+{
+    const char* theChar;
+
+    for (theChar = inString; *theChar; theChar++)
+    {
+        if (*theChar == '"' || *theChar == '\\')
+            fprintf(outFile, "\\%c", *theChar);
+        else if ((UInt8)*theChar < 0x20)
+            fprintf(outFile, "\\u%04x", (UInt8)*theChar);
         else
+            fputc(*theChar, outFile);
+    }
+}
+
+#pragma mark -
+//  openOutputWriter:toFile:withToc:
+// ----------------------------------------------------------------------------
+//  Start batching output for inFile, see OutputWriter. Every successful open
+//  must be matched by closeOutputWriter:. Only the listing's writer passes
+//  YES for inWithToc, so that -toc records where its functions went.
+
+- (BOOL)openOutputWriter: (OutputWriter*)outWriter
+                  toFile: (FILE*)inFile
+                 withToc: (BOOL)inWithToc
+{
+    outWriter->fileNum  = fileno(inFile);
+    outWriter->buffer   = malloc(OUTPUT_BUFFER_SIZE);
+    outWriter->used     = 0;
+    outWriter->failed   = NO;
+
+    if (!outWriter->buffer)
+    {
+        fprintf(stderr, "otx: not enough memory for output buffer\n");
+        return NO;
+    }
+
+    outWriter->compress     = iOpts.compressOutput;
+    outWriter->offset       = 0;
+    outWriter->fileOffset   = 0;
+    outWriter->members      = NULL;
+    outWriter->numMembers   = 0;
+    outWriter->maxMembers   = 0;
+    memset(&outWriter->stream, 0, sizeof(z_stream));
+
+    outWriter->writeToc     = (iOpts.tocPath && inWithToc);
+
+    // 15 + 16 window bits selects the gzip wrapper.
+    if (outWriter->compress && deflateInit2(&outWriter->stream,
+        Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+        Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        fprintf(stderr, "otx: unable to start compressing output\n");
+        free(outWriter->buffer);
+        return NO;
+    }
+
+    outWriter->queue    = dispatch_queue_create("otx.output", NULL);
+    outWriter->pending  = dispatch_semaphore_create(OUTPUT_MAX_PENDING);
+
+    return YES;
+}
+
+//  writeOutput:bytes:length:
+// ----------------------------------------------------------------------------
+//  Append inBytes to the current buffer, handing it to the writer queue
+//  whenever it fills up.
+
+- (BOOL)writeOutput: (OutputWriter*)ioWriter
+              bytes: (const char*)inBytes
+             length: (size_t)inLength
+{
+    while (inLength)
+    {
+        if (ioWriter->failed)
+            return NO;
+
+        size_t  count   = MIN(inLength, OUTPUT_BUFFER_SIZE - ioWriter->used);
+
+        memcpy(ioWriter->buffer + ioWriter->used, inBytes, count);
+        ioWriter->used      += count;
+        ioWriter->offset    += count;
+        inBytes         += count;
+        inLength        -= count;
+
+        if (ioWriter->used == OUTPUT_BUFFER_SIZE)
         {
-            if (theNType == N_UNDF)
-                fprintf(stderr, "Undefined\n");
-            else if (theNType == N_PBUD)
-                fprintf(stderr, "Prebound undefined\n");
+            if (![self flushOutputWriter: ioWriter])
+                return NO;
+        }
+    }
 
-            switch (theRefType)
+    return YES;
+}
+
+//  flushOutputWriter:
+// ----------------------------------------------------------------------------
+//  Hand the current buffer to the writer queue and start a new one. Blocks
+//  while OUTPUT_MAX_PENDING buffers are already waiting.
+
+- (BOOL)flushOutputWriter: (OutputWriter*)ioWriter
+{
+    if (!ioWriter->used)
+        return !ioWriter->failed;
+
+    char*   newBuffer   = malloc(OUTPUT_BUFFER_SIZE);
+
+    if (!newBuffer)
+    {
+        fprintf(stderr, "otx: not enough memory for output buffer\n");
+        ioWriter->failed    = YES;
+        return NO;
+    }
+
+    char*   buffer  = ioWriter->buffer;
+    size_t  length  = ioWriter->used;
+    UInt64  start   = ioWriter->offset - length;
+
+    ioWriter->buffer    = newBuffer;
+    ioWriter->used      = 0;
+
+    dispatch_semaphore_wait(ioWriter->pending, DISPATCH_TIME_FOREVER);
+    dispatch_async(ioWriter->queue,
+    ^{
+        char*   output          = buffer;
+        size_t  outputLength    = length;
+        size_t  written         = 0;
+
+        if (ioWriter->compress && !ioWriter->failed)
+        {
+            output  = [self deflateOutput: ioWriter bytes: buffer
+                length: length newLength: &outputLength];
+
+            if (!output)
+                ioWriter->failed    = YES;
+            else if (ioWriter->writeToc)
             {
-                case REFERENCE_FLAG_UNDEFINED_NON_LAZY:
-                    fprintf(stderr, "REFERENCE_FLAG_UNDEFINED_NON_LAZY\n");
-                    break;
-                case REFERENCE_FLAG_UNDEFINED_LAZY:
-                    fprintf(stderr, "REFERENCE_FLAG_UNDEFINED_LAZY\n");
-                    break;
-                case REFERENCE_FLAG_DEFINED:
-                    fprintf(stderr, "REFERENCE_FLAG_DEFINED\n");
-                    break;
-                case REFERENCE_FLAG_PRIVATE_DEFINED:
-                    fprintf(stderr, "REFERENCE_FLAG_PRIVATE_DEFINED\n");
-                    break;
-                case REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY:
-                    fprintf(stderr, "REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY\n");
-                    break;
-                case REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY:
-                    fprintf(stderr, "REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY\n");
-                    break;
+                if (ioWriter->numMembers == ioWriter->maxMembers)
+                {
+                    ioWriter->maxMembers    = MAX(64, ioWriter->maxMembers * 2);
+                    ioWriter->members       = realloc(ioWriter->members,
+                        sizeof(TocFileMember) * ioWriter->maxMembers);
+                }
+
+                ioWriter->members[ioWriter->numMembers++]   =
+                    (TocFileMember){start, ioWriter->fileOffset};
+            }
+        }
 
-                default:
-                    break;
+        while (!ioWriter->failed && written < outputLength)
+        {
+            ssize_t count   = write(ioWriter->fileNum,
+                output + written, outputLength - written);
+
+            if (count == -1 && errno == EINTR)
+                continue;
+
+            if (count <= 0)
+            {
+                perror("otx: unable to write to output file");
+                ioWriter->failed    = YES;
             }
+            else
+                written += count;
         }
-    }
 
-    fprintf(stderr, "\n");
+        ioWriter->fileOffset   += written;
+
+        if (output && output != buffer)
+            free(output);
+
+        free(buffer);
+        dispatch_semaphore_signal(ioWriter->pending);
+    });
+
+    return !ioWriter->failed;
 }
 
-//  printBlocks:
+//  endOutputBlock:
 // ----------------------------------------------------------------------------
-//  Used for block debugging. Sublclasses may override.
+//  Called between functions. When compressing, hand the current buffer to
+//  the writer queue if it holds at least OUTPUT_MIN_BLOCK bytes, so the
+//  next gzip member starts here.
 
-- (void)printBlocks: (uint32_t)inFuncIndex;
-{}
-#endif  // OTX_DEBUG
+- (BOOL)endOutputBlock: (OutputWriter*)ioWriter
+{
+    if (ioWriter->compress && ioWriter->used >= OUTPUT_MIN_BLOCK)
+        return [self flushOutputWriter: ioWriter];
 
-- (void) printSummary
+    return !ioWriter->failed;
+}
+
+//  deflateOutput:bytes:length:newLength:
+// ----------------------------------------------------------------------------
+//  Return inBytes compressed as a complete gzip member, or NULL on failure.
+//  Runs on the writer queue, the caller frees the result.
+
+- (char*)deflateOutput: (OutputWriter*)ioWriter
+                 bytes: (const char*)inBytes
+                length: (size_t)inLength
+             newLength: (size_t*)outLength
 {
-    unsigned percentage = (iMatchedSelectorCount * 100) / (iMatchedSelectorCount + iMissedSelectorCount);
-    fprintf(stderr, "%u selectors matched, %u missed, %u%%\n", iMatchedSelectorCount, iMissedSelectorCount, percentage);
+    z_stream*   stream  = &ioWriter->stream;
+    uLong       bound   = deflateBound(stream, inLength) + 32;  // gzip wrapper
+    char*       output  = malloc(bound);
+
+    if (!output)
+    {
+        fprintf(stderr, "otx: not enough memory to compress output\n");
+        return NULL;
+    }
+
+    deflateReset(stream);
+    stream->next_in     = (Bytef*)inBytes;
+    stream->avail_in    = inLength;
+    stream->next_out    = (Bytef*)output;
+    stream->avail_out   = bound;
+
+    if (deflate(stream, Z_FINISH) != Z_STREAM_END)
+    {
+        fprintf(stderr, "otx: unable to compress output\n");
+        free(output);
+        return NULL;
+    }
+
+    *outLength  = bound - stream->avail_out;
+
+    return output;
+}
+
+//  closeOutputWriter:
+// ----------------------------------------------------------------------------
+//  Write whatever's left and wait for the writer queue to finish. Doesn't
+//  close the file.
+
+- (BOOL)closeOutputWriter: (OutputWriter*)ioWriter
+{
+    [self flushOutputWriter: ioWriter];
+    dispatch_sync(ioWriter->queue, ^{});
+
+    BOOL    result  = !ioWriter->failed;
+
+    if (result && ioWriter->writeToc)
+        result  = [self writeTocFile: ioWriter];
+
+    if (ioWriter->compress)
+        deflateEnd(&ioWriter->stream);
+
+    dispatch_release(ioWriter->queue);
+    dispatch_release(ioWriter->pending);
+    free(ioWriter->buffer);
+    ioWriter->buffer    = NULL;
+
+    if (ioWriter->members)
+        free(ioWriter->members);
+
+    ioWriter->members   = NULL;
+
+    return result;
+}
+
+//  printHexDump:length:address:addressDigits:toWriter:
+// ----------------------------------------------------------------------------
+//  Write a hex dump of inLength bytes that start at inAddress. Chunks of
+//  HEXDUMP_CHUNK_SIZE bytes are formatted concurrently, then handed to the
+//  writer in order.
+
+- (BOOL)printHexDump: (const UInt8*)inBytes
+              length: (size_t)inLength
+             address: (UInt64)inAddress
+       addressDigits: (UInt8)inDigits
+            toWriter: (OutputWriter*)ioWriter
+{
+    size_t  numChunks   =
+        (inLength + HEXDUMP_CHUNK_SIZE - 1) / HEXDUMP_CHUNK_SIZE;
+    size_t  chunkSize   =
+        HEXDUMP_CHUNK_SIZE / 16 * HEXDUMP_ROW_LENGTH(inDigits);
+    char*   buffers     = malloc(chunkSize * HEXDUMP_BATCH_CHUNKS);
+    size_t* lengths     = malloc(sizeof(size_t) * HEXDUMP_BATCH_CHUNKS);
+    size_t  firstChunk, i;
+    BOOL    result      = YES;
+
+    if (!buffers || !lengths)
+    {
+        fprintf(stderr, "otx: not enough memory for hex dump\n");
+        free(buffers);
+        free(lengths);
+        return NO;
+    }
+
+    for (firstChunk = 0; firstChunk < numChunks && result;
+        firstChunk += HEXDUMP_BATCH_CHUNKS)
+    {
+        size_t  batchChunks = MIN(HEXDUMP_BATCH_CHUNKS, numChunks - firstChunk);
+
+        dispatch_apply(batchChunks,
+            dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+        ^(size_t n)
+        {
+            size_t  offset  = (firstChunk + n) * HEXDUMP_CHUNK_SIZE;
+
+            lengths[n]  = FormatHexRows(&buffers[n * chunkSize],
+                &inBytes[offset], MIN(HEXDUMP_CHUNK_SIZE, inLength - offset),
+                inAddress + offset, inDigits);
+        });
+
+        for (i = 0; i < batchChunks && result; i++)
+            result  = [self writeOutput: ioWriter
+                bytes: &buffers[i * chunkSize] length: lengths[i]];
+    }
+
+    free(buffers);
+    free(lengths);
+
+    return result;
+}
+
+#pragma mark -
+//  entabCString:length:
+// ----------------------------------------------------------------------------
+//  Entab a code line in place and return its new length, assuming it
+//  contains no tabs already. Tab stops are every 4 columns. In each 4-column
+//  stretch that ends before the comment field, trailing spaces become a
+//  single tab. Comments are not entabbed, as that would remove the user's
+//  ability to search for them in the source code or a hex editor.
+
+- (size_t)entabCString: (char*)ioCString
+                length: (size_t)inLength
+{
+    // only need to do this math once...
+    if (iStartOfComment == 0)
+    {
+        iStartOfComment = iFieldWidths.address + iFieldWidths.instruction +
+            iFieldWidths.mnemonic + iFieldWidths.operands;
+
+        if (iOpts.localOffsets)
+            iStartOfComment += iFieldWidths.offset;
+    }
+
+    // If 1st char is '\n', skip it.
+    size_t  firstChar   = (ioCString[0] == '\n');
+    size_t  i;                  // old line marker
+    size_t  j   = firstChar;    // new line marker
+
+    // The new line is never longer than the old one, so it can be written
+    // over it.
+    for (i = firstChar; i + 4 <= inLength &&
+        i + 4 < iStartOfComment + firstChar; i += 4)
+    {
+        size_t  keep    = 4;
+
+        while (keep && ioCString[i + keep - 1] == ' ')
+            keep--;
+
+        memmove(&ioCString[j], &ioCString[i], keep);
+        j  += keep;
+
+        if (keep < 4)
+            ioCString[j++]  = '\t';
+    }
+
+    // Copy the rest, including the null terminator.
+    memmove(&ioCString[j], &ioCString[i], inLength - i + 1);
+
+    return j + inLength - i;
+}
+
+//  demangleCString:maxLength:
+// ----------------------------------------------------------------------------
+//  Replace the C++ symbol name at the start of ioCString with its demangled
+//  form, keeping whatever follows the name. The result is truncated to fit
+//  in inMaxLength bytes. Names that don't demangle are left alone.
+
+- (void)demangleCString: (char*)ioCString
+              maxLength: (size_t)inMaxLength
+{
+    size_t  nameLength  = 0;
+
+    while (isalnum(ioCString[nameLength]) || ioCString[nameLength] == '_' ||
+        ioCString[nameLength] == '$' || ioCString[nameLength] == '.')
+        nameLength++;
+
+    char*   demangled   = [self demangledName: ioCString length: nameLength];
+
+    if (!demangled)
+        return;
+
+    size_t  demangledLength = MIN(strlen(demangled), inMaxLength - 1);
+    size_t  restLength      = MIN(strlen(&ioCString[nameLength]),
+        inMaxLength - 1 - demangledLength);
+
+    memmove(&ioCString[demangledLength], &ioCString[nameLength], restLength);
+    memcpy(ioCString, demangled, demangledLength);
+    ioCString[demangledLength + restLength] = 0;
+}
+
+//  demangledName:length:
+// ----------------------------------------------------------------------------
+//  Return the demangled form of the first inLength chars of inName, a symbol
+//  name with the leading underscore that Mach-O adds, or NULL if it doesn't
+//  demangle. Each name is demangled once, later calls hit iDemangleCache.
+//  The returned string lives as long as the cache does.
+
+- (char*)demangledName: (const char*)inName
+                length: (size_t)inLength
+{
+    DemangleCache*  cache   = iDemangleCache;
+
+    if (!cache || inLength < 2)
+        return NULL;
+
+    uint32_t    hash    = DemangleCache_Hash(inName, inLength);
+
+    pthread_mutex_lock(&cache->lock);
+
+    DemangleEntry*  entry   =
+        DemangleCache_Find(cache, inName, inLength, hash);
+
+    if (entry->mangled)
+    {
+        char*   result  = entry->demangled;
+
+        pthread_mutex_unlock(&cache->lock);
+        return result;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    // Demangle without holding the lock, so workers don't wait on each
+    // other. Skip the leading underscore.
+    char*   mangled     = malloc(inLength);
+    char*   demangled   = NULL;
+    int     status      = 0;
+
+    if (!mangled)
+        return NULL;
+
+    memcpy(mangled, &inName[1], inLength - 1);
+    mangled[inLength - 1]   = 0;
+    demangled   = __cxa_demangle(mangled, NULL, NULL, &status);
+    free(mangled);
+
+    if (status != 0 && demangled)
+    {
+        free(demangled);
+        demangled   = NULL;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    // Another worker may have added it in the meantime.
+    entry   = DemangleCache_Find(cache, inName, inLength, hash);
+
+    if (!entry->mangled && DemangleCache_Reserve(cache))
+    {
+        entry   = DemangleCache_Find(cache, inName, inLength, hash);
+
+        size_t  demangledLength = (demangled) ? strlen(demangled) + 1 : 0;
+        char*   strings         = [self allocFromArena: &cache->strings
+            size: inLength + 1 + demangledLength];
+
+        if (strings)
+        {
+            memcpy(strings, inName, inLength);
+            strings[inLength]   = 0;
+            entry->mangled      = strings;
+            entry->demangled    = NULL;
+            entry->hash         = hash;
+            entry->saved        = NO;
+
+            if (demangled)
+            {
+                entry->demangled    = &strings[inLength + 1];
+                memcpy(entry->demangled, demangled, demangledLength);
+            }
+
+            cache->numEntries++;
+        }
+    }
+
+    char*   result  = entry->demangled;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    if (demangled)
+        free(demangled);
+
+    return result;
+}
+
+//  loadDemangleCacheFile
+// ----------------------------------------------------------------------------
+//  Map the -demangle-cache file and add its names to iDemangleCache, so
+//  they're never demangled again. Other processes only append to the file,
+//  or truncate a partial record after the ones loaded here, so the mapping
+//  stays valid. A missing file is fine,
+//  saveDemangleCacheFile
+// ----------------------------------------------------------------------------
+//  Append every name demangled in this run to the -demangle-cache file,
+//  creating it if needed. Names that any run has already saved are left
+//  out. The records go out in a single write while holding an exclusive
+//  flock, see DemangleFileHeader.
+
+- (void)saveDemangleCacheFile
+{
+    DemangleCache*  cache   = iDemangleCache;
+
+    if (!cache || !iOpts.demangleCachePath)
+        return;
+
+    int fd  = open(iOpts.demangleCachePath, O_RDWR | O_APPEND | O_CREAT, 0644);
+
+    if (fd == -1)
+    {
+        perror("otx: unable to open demangle cache");
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    flock(fd, LOCK_EX);
+
+    struct stat         stats;
+    DemangleFileHeader  header  = {DEMANGLE_FILE_MAGIC, DEMANGLE_FILE_VERSION};
+    BOOL                result  = YES;
+
+    // Whoever creates the file writes the header. Don't append to anything
+    // else.
+    if (fstat(fd, &stats) != 0)
+        result  = NO;
+    else if (stats.st_size == 0)
+    {
+        result          = (write(fd, &header, sizeof(header)) == sizeof(header));
+        stats.st_size   = sizeof(header);
+    }
+    else if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != DEMANGLE_FILE_MAGIC ||
+        header.version != DEMANGLE_FILE_VERSION)
+    {
+        fprintf(stderr, "otx: %s is not a demangle cache, not saving to it\n",
+            iOpts.demangleCachePath);
+        flock(fd, LOCK_UN);
+        close(fd);
+        pthread_mutex_unlock(&cache->lock);
+        return;
+    }
+
+    if (result)
+        result  = [self trimDemangleCacheFile: fd stats: &stats];
+
+    char*       buffer      = NULL;
+    size_t      bufferSize  = 0;
+    size_t      maxBuffer   = 0;
+    uint32_t    i;
+
+    for (i = 0; result && i < cache->maxEntries; i++)
+    {
+        DemangleEntry*  entry   = &cache->entries[i];
+
+        if (!entry->mangled || entry->saved)
+            continue;
+
+        DemangleFileRecord  record  =
+            {strlen(entry->mangled), DEMANGLE_FAILED};
+        size_t              recordSize  =
+            sizeof(DemangleFileRecord) + record.mangledLength + 1;
+
+        if (entry->demangled)
+        {
+            record.demangledLength  = strlen(entry->demangled);
+            recordSize             += record.demangledLength + 1;
+        }
+
+        recordSize  = (recordSize + 3) & ~3;
+
+        if (bufferSize + recordSize > maxBuffer)
+        {
+            maxBuffer   = MAX(4096, MAX(maxBuffer * 2, bufferSize + recordSize));
+
+            char*   newBuffer   = realloc(buffer, maxBuffer);
+
+            if (!newBuffer)
+            {
+                fprintf(stderr, "otx: not enough memory to save demangle cache\n");
+                free(buffer);
+                flock(fd, LOCK_UN);
+                close(fd);
+                pthread_mutex_unlock(&cache->lock);
+                return;
+            }
+
+            buffer  = newBuffer;
+        }
+
+        char*   recordPtr   = buffer + bufferSize;
+
+        memset(recordPtr, 0, recordSize);
+        memcpy(recordPtr, &record, sizeof(record));
+        recordPtr  += sizeof(record);
+        memcpy(recordPtr, entry->mangled, record.mangledLength);
+
+        if (entry->demangled)
+            memcpy(recordPtr + record.mangledLength + 1, entry->demangled,
+                record.demangledLength);
+
+        bufferSize  += recordSize;
+    }
+
+    size_t  written = 0;
+
+    while (result && written < bufferSize)
+    {
+        ssize_t count   = write(fd, buffer + written, bufferSize - written);
+
+        if (count <= 0)
+            result  = NO;
+        else
+            written += count;
+    }
+
+    if (!result)
+        perror("otx: unable to write demangle cache");
+    else if (bufferSize)
+    {
+        for (i = 0; i < cache->maxEntries; i++)
+            if (cache->entries[i].mangled)
+                cache->entries[i].saved = YES;
+    }
+
+    flock(fd, LOCK_UN);
+    close(fd);
+    free(buffer);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+//  trimDemangleCacheFile:stats:
+// ----------------------------------------------------------------------------
+//  Called by saveDemangleCacheFile with inFD locked. Read the records other
+//  runs appended since loadDemangleCacheFile, and mark their names saved so
+//  they're not written twice. Then truncate the file after its last whole
+//  record, in case a run died while appending to it.
+
+- (BOOL)trimDemangleCacheFile: (int)inFD
+                        stats: (struct stat*)inStats
+{
+    DemangleCache*  cache       = iDemangleCache;
+    size_t          startOffset = sizeof(DemangleFileHeader);
+
+    // If the file was replaced since we loaded it, read all of it.
+    if (cache->loadedSize && cache->loadedInode == inStats->st_ino &&
+        (off_t)cache->loadedSize <= inStats->st_size)
+        startOffset = cache->loadedSize;
+
+    size_t  tailSize    = inStats->st_size - startOffset;
+
+    if (!tailSize)
+        return YES;
+
+    char*   tail    = malloc(tailSize);
+
+    if (!tail)
+    {
+        fprintf(stderr, "otx: not enough memory to save demangle cache\n");
+        return NO;
+    }
+
+    if (pread(inFD, tail, tailSize, startOffset) != (ssize_t)tailSize)
+    {
+        free(tail);
+        return NO;
+    }
+
+    size_t  offset  = 0;
+    size_t  recordSize;
+
+    while ((recordSize = DemangleFile_RecordSize(tail, offset, tailSize)))
+    {
+        DemangleFileRecord* record  = (DemangleFileRecord*)(tail + offset);
+        char*               mangled = tail + offset + sizeof(DemangleFileRecord);
+        DemangleEntry*      entry   = DemangleCache_Find(cache, mangled,
+            record->mangledLength,
+            DemangleCache_Hash(mangled, record->mangledLength));
+
+        if (entry->mangled)
+            entry->saved    = YES;
+
+        offset  += recordSize;
+    }
+
+    free(tail);
+
+    if (offset < tailSize)
+    {
+        fprintf(stderr, "otx: dropping a partial record from %s\n",
+            iOpts.demangleCachePath);
+
+        if (ftruncate(inFD, startOffset + offset) != 0)
+            return NO;
+    }
+
+    return YES;
+}
+
+#pragma mark -
+//  addThunk:
+// ----------------------------------------------------------------------------
+//  Insert inThunk into iThunks, keeping it sorted by address for
+//  findThunkAtAddress:. A thunk found twice is stored once.
+
+- (void)addThunk: (ThunkInfo)inThunk
+{
+    uint32_t    lo  = 0;
+    uint32_t    hi  = iNumThunks;
+
+    while (lo < hi)
+    {
+        uint32_t    mid = (lo + hi) / 2;
+
+        if (iThunks[mid].address < inThunk.address)
+            lo  = mid + 1;
+        else
+            hi  = mid;
+    }
+
+    if (lo < iNumThunks && iThunks[lo].address == inThunk.address)
+    {
+        iThunks[lo] = inThunk;
+        return;
+    }
+
+    if (iNumThunks == iMaxThunks)
+    {
+        iMaxThunks  = MAX(8, iMaxThunks * 2);
+        iThunks     = realloc(iThunks, sizeof(ThunkInfo) * iMaxThunks);
+    }
+
+    memmove(&iThunks[lo + 1], &iThunks[lo],
+        sizeof(ThunkInfo) * (iNumThunks - lo));
+    iThunks[lo] = inThunk;
+    iNumThunks++;
+}
+
+//  findThunkAtAddress:
+// ----------------------------------------------------------------------------
+//  Return the get_pc_thunk routine at inAddress, or NULL.
+
+- (ThunkInfo*)findThunkAtAddress: (uint32_t)inAddress
+{
+    if (!iThunks)
+        return NULL;
+
+    ThunkInfo   searchKey   = {inAddress, 0};
+
+    return bsearch(&searchKey, iThunks, iNumThunks, sizeof(ThunkInfo),
+        (COMPARISON_FUNC_TYPE)ThunkInfo_Compare);
+}
+
+#pragma mark -
+//  addXref:kind:site:function:
+// ----------------------------------------------------------------------------
+//  Record a call, message send or function name for the -xref index. Does
+//  nothing unless the index was requested. Function names are otool's name
+//  lines, so surrounding newlines and the trailing colon are dropped.
+
+- (void)addXref: (const char*)inKey
+           kind: (UInt8)inKind
+           site: (UInt64)inSite
+       function: (UInt64)inFunction
+{
+    if (!iOpts.xrefIndexPath || !inKey)
+        return;
+
+    size_t  keyLength;
+
+    if (inKind == XrefFunction)
+        keyLength   = TrimFunctionName(&inKey);
+    else
+        keyLength   = strlen(inKey);
+
+    if (!keyLength)
+        return;
+
+    char*   key = [self allocFromArena: &iXrefStrings size: keyLength + 1];
+
+    if (!key)
+        return;
+
+    memcpy(key, inKey, keyLength);
+    key[keyLength]  = 0;
+
+    XrefSite    theXref = {key, inSite, inFunction, inKind};
+
+    if (inKind == XrefFunction)
+    {
+        if (iNumXrefFuncs == iMaxXrefFuncs)
+        {
+            iMaxXrefFuncs   = MAX(256, iMaxXrefFuncs * 2);
+            iXrefFuncs      = realloc(iXrefFuncs,
+                sizeof(XrefSite) * iMaxXrefFuncs);
+        }
+
+        iXrefFuncs[iNumXrefFuncs++] = theXref;
+    }
+    else
+    {
+        if (iNumXrefs == iMaxXrefs)
+        {
+            iMaxXrefs   = MAX(1024, iMaxXrefs * 2);
+            iXrefs      = realloc(iXrefs, sizeof(XrefSite) * iMaxXrefs);
+        }
+
+        iXrefs[iNumXrefs++] = theXref;
+    }
+}
+
+//  mergeXrefsFrom:
+// ----------------------------------------------------------------------------
+//  Take over everything a worker recorded, see processLinesInParallel. The
+//  worker's strings move to our arena, so its keys stay valid after it's
+//  disposed. Not thread-safe, callers synchronize on self.
+
+- (void)mergeXrefsFrom: (ExeProcessor*)inWorker
+{
+    if (inWorker->iNumXrefs)
+    {
+        if (iNumXrefs + inWorker->iNumXrefs > iMaxXrefs)
+        {
+            iMaxXrefs   = iNumXrefs + inWorker->iNumXrefs;
+            iXrefs      = realloc(iXrefs, sizeof(XrefSite) * iMaxXrefs);
+        }
+
+        memcpy(&iXrefs[iNumXrefs], inWorker->iXrefs,
+            sizeof(XrefSite) * inWorker->iNumXrefs);
+        iNumXrefs   += inWorker->iNumXrefs;
+    }
+
+    if (inWorker->iNumXrefFuncs)
+    {
+        if (iNumXrefFuncs + inWorker->iNumXrefFuncs > iMaxXrefFuncs)
+        {
+            iMaxXrefFuncs   = iNumXrefFuncs + inWorker->iNumXrefFuncs;
+            iXrefFuncs      = realloc(iXrefFuncs,
+                sizeof(XrefSite) * iMaxXrefFuncs);
+        }
+
+        memcpy(&iXrefFuncs[iNumXrefFuncs], inWorker->iXrefFuncs,
+            sizeof(XrefSite) * inWorker->iNumXrefFuncs);
+        iNumXrefFuncs   += inWorker->iNumXrefFuncs;
+    }
+
+    // Append the worker's chunks to ours.
+    ArenaChunk* lastChunk   = inWorker->iXrefStrings.chunks;
+
+    if (lastChunk)
+    {
+        while (lastChunk->next)
+            lastChunk   = lastChunk->next;
+
+        lastChunk->next         = iXrefStrings.chunks;
+        iXrefStrings.chunks     = inWorker->iXrefStrings.chunks;
+    }
+
+    if (inWorker->iXrefs)
+        free(inWorker->iXrefs);
+
+    if (inWorker->iXrefFuncs)
+        free(inWorker->iXrefFuncs);
+
+    inWorker->iXrefs                = NULL;
+    inWorker->iNumXrefs             = 0;
+    inWorker->iMaxXrefs             = 0;
+    inWorker->iXrefFuncs            = NULL;
+    inWorker->iNumXrefFuncs         = 0;
+    inWorker->iMaxXrefFuncs         = 0;
+    inWorker->iXrefStrings.chunks   = NULL;
+}
+
+//  writeXrefIndex
+// ----------------------------------------------------------------------------
+//  Sort everything addXref:kind:site:function: recorded and write it to
+//  iOpts.xrefIndexPath. See XrefIndexHeader for the layout.
+
+- (BOOL)writeXrefIndex
+{
+    qsort(iXrefs, iNumXrefs, sizeof(XrefSite),
+        (COMPARISON_FUNC_TYPE)XrefSite_Compare);
+    qsort(iXrefFuncs, iNumXrefFuncs, sizeof(XrefSite),
+        (COMPARISON_FUNC_TYPE)XrefSite_Address_Compare);
+
+    XrefIndexKey*   keys        =
+        malloc(sizeof(XrefIndexKey) * MAX(iNumXrefs, 1));
+    XrefIndexSite*  sites       =
+        malloc(sizeof(XrefIndexSite) * MAX(iNumXrefs, 1));
+    XrefIndexFunc*  funcs       =
+        malloc(sizeof(XrefIndexFunc) * MAX(iNumXrefFuncs, 1));
+    char*           strings     = NULL;
+    uint32_t        stringsSize = 0;
+    uint32_t        maxStrings  = 0;
+    uint32_t        numKeys     = 0;
+    uint32_t        numFuncs    = 0;
+    uint32_t        i;
+
+    if (!keys || !sites || !funcs)
+    {
+        fprintf(stderr, "otx: not enough memory for xref index\n");
+        free(keys);
+        free(sites);
+        free(funcs);
+        return NO;
+    }
+
+    for (i = 0; i < iNumXrefs + iNumXrefFuncs; i++)
+    {
+        BOOL        isFunc  = (i >= iNumXrefs);
+        XrefSite*   theXref = (isFunc) ?
+            &iXrefFuncs[i - iNumXrefs] : &iXrefs[i];
+
+        // Each name is stored once per key or function.
+        if (isFunc)
+        {
+            if (numFuncs && funcs[numFuncs - 1].address == theXref->site)
+                continue;
+        }
+        else if (numKeys && keys[numKeys - 1].kind == theXref->kind &&
+            !strcmp(&strings[keys[numKeys - 1].name], theXref->key))
+        {
+            sites[i]    = (XrefIndexSite){theXref->site, theXref->function};
+            keys[numKeys - 1].numSites++;
+            continue;
+        }
+
+        uint32_t    keyLength   = strlen(theXref->key) + 1;
+
+        if (stringsSize + keyLength > maxStrings)
+        {
+            maxStrings  = MAX(maxStrings * 2, stringsSize + keyLength);
+            strings     = realloc(strings, maxStrings);
+
+            if (!strings)
+            {
+                fprintf(stderr, "otx: not enough memory for xref index\n");
+                free(keys);
+                free(sites);
+                free(funcs);
+                return NO;
+            }
+        }
+
+        memcpy(&strings[stringsSize], theXref->key, keyLength);
+
+        if (isFunc)
+            funcs[numFuncs++]   =
+                (XrefIndexFunc){theXref->site, stringsSize, 0};
+        else
+        {
+            sites[i]            =
+                (XrefIndexSite){theXref->site, theXref->function};
+            keys[numKeys++]     =
+                (XrefIndexKey){stringsSize, theXref->kind, i, 1};
+        }
+
+        stringsSize += keyLength;
+    }
+
+    XrefIndexHeader header  = {XREF_INDEX_MAGIC, XREF_INDEX_VERSION,
+        numKeys, iNumXrefs, numFuncs, stringsSize};
+    FILE*           outFile = fopen(iOpts.xrefIndexPath, "wb");
+    BOOL            result  = (outFile != NULL);
+
+    if (!outFile)
+        perror("otx: unable to open xref index file");
+    else
+    {
+        if (fwrite(&header, sizeof(header), 1, outFile) != 1                ||
+            fwrite(keys, sizeof(XrefIndexKey), numKeys, outFile) != numKeys ||
+            fwrite(sites, sizeof(XrefIndexSite), iNumXrefs, outFile) !=
+                iNumXrefs                                                   ||
+            fwrite(funcs, sizeof(XrefIndexFunc), numFuncs, outFile) !=
+                numFuncs                                                    ||
+            fwrite(strings, 1, stringsSize, outFile) != stringsSize)
+        {
+            perror("otx: unable to write xref index file");
+            result  = NO;
+        }
+
+        if (fclose(outFile) != 0)
+        {
+            perror("otx: unable to close xref index file");
+            result  = NO;
+        }
+    }
+
+    free(keys);
+    free(sites);
+    free(funcs);
+    free(strings);
+
+    return result;
+}
+
+#pragma mark -
+//  addTocEntry:address:offset:
+// ----------------------------------------------------------------------------
+//  Record that the function at inAddress, named by otool's name line inName,
+//  starts at inOffset in the output. Its end address is filled in by
+//  printLinesFrom:before:toWriter: as its code is written.
+
+- (void)addTocEntry: (const char*)inName
+            address: (UInt64)inAddress
+             offset: (UInt64)inOffset
+{
+    size_t  nameLength  = TrimFunctionName(&inName);
+    char*   theName     = [self allocFromArena: &iTocStrings
+        size: nameLength + 1];
+
+    if (!theName)
+        return;
+
+    memcpy(theName, inName, nameLength);
+    theName[nameLength] = 0;
+
+    if (iNumTocEntries == iMaxTocEntries)
+    {
+        iMaxTocEntries  = MAX(256, iMaxTocEntries * 2);
+        iTocEntries     = realloc(iTocEntries,
+            sizeof(TocEntry) * iMaxTocEntries);
+    }
+
+    iTocEntries[iNumTocEntries++]   =
+        (TocEntry){theName, inAddress, inAddress, inOffset, 0};
+}
+
+//  writeTocFile:
+// ----------------------------------------------------------------------------
+//  Write the entries recorded while inWriter wrote the listing, and its gzip
+//  members, to iOpts.tocPath. See TocFileHeader for the layout.
+
+- (BOOL)writeTocFile: (OutputWriter*)inWriter
+{
+    uint32_t    i;
+
+    // Entries were recorded in output order, so each one ends where the
+    // next begins.
+    for (i = 0; i < iNumTocEntries; i++)
+        iTocEntries[i].length   = ((i + 1 < iNumTocEntries) ?
+            iTocEntries[i + 1].offset : inWriter->offset) -
+            iTocEntries[i].offset;
+
+    qsort(iTocEntries, iNumTocEntries, sizeof(TocEntry),
+        (COMPARISON_FUNC_TYPE)TocEntry_Compare);
+
+    TocFileEntry*   entries     =
+        malloc(sizeof(TocFileEntry) * MAX(iNumTocEntries, 1));
+    char*           strings     = NULL;
+    uint32_t        stringsSize = 0;
+
+    if (!entries)
+    {
+        fprintf(stderr, "otx: not enough memory for table of contents\n");
+        return NO;
+    }
+
+    for (i = 0; i < iNumTocEntries; i++)
+        stringsSize    += strlen(iTocEntries[i].name) + 1;
+
+    strings     = malloc(MAX(stringsSize, 1));
+    stringsSize = 0;
+
+    if (!strings)
+    {
+        fprintf(stderr, "otx: not enough memory for table of contents\n");
+        free(entries);
+        return NO;
+    }
+
+    for (i = 0; i < iNumTocEntries; i++)
+    {
+        TocEntry*   theEntry    = &iTocEntries[i];
+        uint32_t    nameLength  = strlen(theEntry->name) + 1;
+
+        entries[i]  = (TocFileEntry){theEntry->address, theEntry->endAddress,
+            theEntry->offset, theEntry->length, stringsSize, 0};
+        memcpy(&strings[stringsSize], theEntry->name, nameLength);
+        stringsSize += nameLength;
+    }
+
+    TocFileHeader   header  = {TOC_FILE_MAGIC, TOC_FILE_VERSION,
+        iNumTocEntries, inWriter->numMembers, stringsSize, 0};
+    FILE*           outFile = fopen(iOpts.tocPath, "wb");
+    BOOL            result  = (outFile != NULL);
+
+    if (!outFile)
+        perror("otx: unable to open table of contents file");
+    else
+    {
+        if (fwrite(&header, sizeof(header), 1, outFile) != 1           ||
+            fwrite(entries, sizeof(TocFileEntry), iNumTocEntries,
+                outFile) != iNumTocEntries                              ||
+            fwrite(inWriter->members, sizeof(TocFileMember),
+                inWriter->numMembers, outFile) != inWriter->numMembers  ||
+            fwrite(strings, 1, stringsSize, outFile) != stringsSize)
+        {
+            perror("otx: unable to write table of contents file");
+            result  = NO;
+        }
+
+        if (fclose(outFile) != 0)
+        {
+            perror("otx: unable to close table of contents file");
+            result  = NO;
+        }
+    }
+
+    free(entries);
+    free(strings);
+
+    return result;
+}
+
+#pragma mark -
+//  writeSplitPieces:count:
+// ----------------------------------------------------------------------------
+//  Write each group of pieces that share a name to its own file under
+//  iOpts.splitPath, in output order, and list the files in a manifest. The
+//  files are written concurrently, so first make sure no two of them get
+//  the same path, even on a case-insensitive volume, see SplitPathForName.
+//  With -z, each file is gzipped and gets a ".gz" suffix.
+
+- (BOOL)writeSplitPieces: (SplitPiece*)inPieces
+                   count: (uint32_t)inCount
+{
+    const char* theDirs[]   = {"", "/classes", "/functions"};
+    char        thePath[MAXPATHLEN];
+    uint32_t    i;
+
+    for (i = 0; i < sizeof(theDirs) / sizeof(theDirs[0]); i++)
+    {
+        snprintf(thePath, MAXPATHLEN, "%s%s", iOpts.splitPath, theDirs[i]);
+
+        if (mkdir(thePath, 0755) && errno != EEXIST)
+        {
+            perror("otx: unable to create output directory");
+            return NO;
+        }
+    }
+
+    qsort(inPieces, inCount, sizeof(SplitPiece),
+        (COMPARISON_FUNC_TYPE)SplitPiece_Compare);
+
+    // Find the first piece of each file.
+    uint32_t*   firstPieces = malloc(sizeof(uint32_t) * (inCount + 1));
+    UInt64*     fileSizes   = calloc(inCount + 1, sizeof(UInt64));
+    char**      filePaths   = calloc(inCount + 1, sizeof(char*));
+    SplitFile*  sortedFiles = malloc(sizeof(SplitFile) * (inCount + 1));
+    uint32_t    numFiles    = 0;
+    __block BOOL    failed  = NO;
+
+    if (!firstPieces || !fileSizes || !filePaths || !sortedFiles)
+    {
+        fprintf(stderr, "otx: not enough memory for split output\n");
+        failed  = YES;
+    }
+    else
+    {
+        for (i = 0; i < inCount; i++)
+            if (!i || strcmp(inPieces[i].name, inPieces[i - 1].name))
+                firstPieces[numFiles++] = i;
+
+        firstPieces[numFiles]   = inCount;
+
+        for (i = 0; i < numFiles && !failed; i++)
+        {
+            filePaths[i]    =
+                SplitPathForName(inPieces[firstPieces[i]].name, 0);
+            sortedFiles[i]  = (SplitFile){filePaths[i], i};
+
+            if (!filePaths[i])
+                failed  = YES;
+        }
+
+        // Every file whose path matches an earlier one's, ignoring case,
+        // gets a numbered copy of it instead.
+        if (!failed)
+            qsort(sortedFiles, numFiles, sizeof(SplitFile),
+                (COMPARISON_FUNC_TYPE)SplitFile_Compare);
+
+        uint32_t    first   = 0;
+        uint32_t    copy    = 1;
+
+        for (i = 1; i < numFiles && !failed; i++)
+        {
+            if (strcasecmp(sortedFiles[i].path, sortedFiles[first].path))
+            {
+                first   = i;
+                copy    = 1;
+                continue;
+            }
+
+            uint32_t    index   = sortedFiles[i].index;
+
+            free(filePaths[index]);
+            filePaths[index]    = SplitPathForName(
+                inPieces[firstPieces[index]].name, ++copy);
+
+            if (!filePaths[index])
+                failed  = YES;
+        }
+
+        if (failed)
+            fprintf(stderr, "otx: not enough memory for split output\n");
+    }
+
+    if (!failed)
+    {
+        dispatch_apply(numFiles,
+            dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+        ^(size_t n)
+        {
+            char        theFilePath[MAXPATHLEN];
+            uint32_t    p;
+
+            snprintf(theFilePath, MAXPATHLEN, "%s/%s%s", iOpts.splitPath,
+                filePaths[n], (iOpts.compressOutput) ? ".gz" : "");
+
+            if (iOpts.compressOutput)
+            {
+                gzFile  theFile = gzopen(theFilePath, "wb");
+
+                if (!theFile)
+                {
+                    perror("otx: unable to open output file");
+                    failed  = YES;
+                    return;
+                }
+
+                for (p = firstPieces[n]; p < firstPieces[n + 1]; p++)
+                {
+                    if (inPieces[p].length && gzwrite(theFile,
+                        inPieces[p].text, inPieces[p].length) <= 0)
+                    {
+                        fprintf(stderr, "otx: unable to write %s\n",
+                            theFilePath);
+                        failed  = YES;
+                        break;
+                    }
+
+                    fileSizes[n]   += inPieces[p].length;
+                }
+
+                if (gzclose(theFile) != Z_OK)
+                {
+                    fprintf(stderr, "otx: unable to close %s\n", theFilePath);
+                    failed  = YES;
+                }
+
+                return;
+            }
+
+            FILE*   theFile = fopen(theFilePath, "w");
+
+            if (!theFile)
+            {
+                perror("otx: unable to open output file");
+                failed  = YES;
+                return;
+            }
+
+            for (p = firstPieces[n]; p < firstPieces[n + 1]; p++)
+            {
+                if (fwrite(inPieces[p].text, 1, inPieces[p].length,
+                    theFile) != inPieces[p].length)
+                {
+                    perror("otx: unable to write to output file");
+                    failed  = YES;
+                    break;
+                }
+
+                fileSizes[n]   += inPieces[p].length;
+            }
+
+            if (fclose(theFile) != 0)
+            {
+                perror("otx: unable to close output file");
+                failed  = YES;
+            }
+        });
+    }
+
+    // List each file with its uncompressed size and number of functions.
+    if (!failed)
+    {
+        snprintf(thePath, MAXPATHLEN, "%s/%s", iOpts.splitPath,
+            SPLIT_MANIFEST_FILE);
+
+        FILE*   manifest    = fopen(thePath, "w");
+
+        if (!manifest)
+        {
+            perror("otx: unable to open manifest file");
+            failed  = YES;
+        }
+        else
+        {
+            for (i = 0; i < numFiles && !failed; i++)
+            {
+                if (fprintf(manifest, "%s%s\t%llu\t%u\n", filePaths[i],
+                    (iOpts.compressOutput) ? ".gz" : "", fileSizes[i],
+                    firstPieces[i + 1] - firstPieces[i]) < 0)
+                {
+                    perror("otx: unable to write manifest file");
+                    failed  = YES;
+                }
+            }
+
+            if (fclose(manifest) != 0)
+            {
+                perror("otx: unable to close manifest file");
+                failed  = YES;
+            }
+        }
+    }
+
+    for (i = 0; i < inCount; i++)
+    {
+        free(inPieces[i].name);
+        free(inPieces[i].text);
+    }
+
+    for (i = 0; filePaths && i < numFiles; i++)
+        free(filePaths[i]);
+
+    free(firstPieces);
+    free(fileSizes);
+    free(filePaths);
+    free(sortedFiles);
+
+    return !failed;
+}
+
+#pragma mark -
+//  incrementalOptionsHash:
+// ----------------------------------------------------------------------------
+//  Digest the arch and the options that can change a line's comment or
+//  block breaks, see IncrementalFileHeader.
+
+- (void)incrementalOptionsHash: (UInt8*)outHash
+{
+    UInt8           fields[]    = {
+        iOpts.verboseMsgSends,
+        iOpts.demangleCppNames,
+        iOpts.returnTypes,
+        iOpts.variableTypes,
+        iOpts.returnStatements,
+        iOpts.separateLogicalBlocks
+    };
+    UInt8           digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_CTX   context;
+
+    CC_SHA256_Init(&context);
+    CC_SHA256_Update(&context, iArchString, strlen(iArchString) + 1);
+    CC_SHA256_Update(&context, fields, sizeof(fields));
+    CC_SHA256_Final(digest, &context);
+
+    memcpy(outHash, digest, INCREMENTAL_HASH_LENGTH);
+}
+
+//  loadIncrementalState
+// ----------------------------------------------------------------------------
+//  Map the state saved by the last -incremental run, if there is one and it
+//  was saved with the same arch and options. Without it, every function is
+//  analyzed as usual.
+
+- (void)loadIncrementalState
+{
+    int fd  = open(iOpts.incrementalPath, O_RDONLY);
+
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+            perror("otx: unable to open incremental state file");
+
+        return;
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 ||
+        fileStat.st_size < (off_t)sizeof(IncrementalFileHeader))
+    {
+        fprintf(stderr, "otx: %s is not an incremental state file, "
+            "ignoring it\n", iOpts.incrementalPath);
+        close(fd);
+        return;
+    }
+
+    size_t  fileSize    = fileStat.st_size;
+    char*   fileBase    = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (fileBase == MAP_FAILED)
+    {
+        perror("otx: unable to map incremental state file");
+        return;
+    }
+
+    IncrementalFileHeader*  header      = (IncrementalFileHeader*)fileBase;
+    IncrementalFunc*        funcs       = (IncrementalFunc*)(header + 1);
+    IncrementalEntry*       lines       =
+        (IncrementalEntry*)(funcs + header->numFuncs);
+    const char*             strings     =
+        (const char*)(lines + header->numLines);
+    UInt64                  fullSize    = sizeof(IncrementalFileHeader) +
+        (UInt64)header->numFuncs * sizeof(IncrementalFunc) +
+        (UInt64)header->numLines * sizeof(IncrementalEntry) +
+        header->stringsSize;
+    BOOL                    valid       =
+        header->magic == INCREMENTAL_FILE_MAGIC     &&
+        header->version == INCREMENTAL_FILE_VERSION &&
+        fullSize == fileSize && header->stringsSize &&
+        fileBase[fileSize - 1] == 0;
+    uint32_t                i;
+
+    for (i = 0; valid && i < header->numFuncs; i++)
+        valid   = funcs[i].firstLine <= header->numLines &&
+            funcs[i].numLines <= header->numLines - funcs[i].firstLine;
+
+    for (i = 0; valid && i < header->numLines; i++)
+        valid   = lines[i].comment < header->stringsSize;
+
+    if (!valid)
+    {
+        fprintf(stderr, "otx: %s is not an incremental state file, "
+            "ignoring it\n", iOpts.incrementalPath);
+        munmap(fileBase, fileSize);
+        return;
+    }
+
+    UInt8   optionsHash[INCREMENTAL_HASH_LENGTH];
+
+    [self incrementalOptionsHash: optionsHash];
+
+    if (memcmp(header->optionsHash, optionsHash, INCREMENTAL_HASH_LENGTH))
+    {
+        fprintf(stderr, "otx: %s was saved with another arch or options, "
+            "analyzing every function\n", iOpts.incrementalPath);
+        munmap(fileBase, fileSize);
+        return;
+    }
+
+    iOldIncState    = fileBase;
+    iOldIncSize     = fileSize;
+    iOldIncFuncs    = funcs;
+    iNumOldIncFuncs = header->numFuncs;
+    iOldIncLines    = lines;
+    iOldIncStrings  = strings;
+}
+
+//  findIncrementalFunc:
+// ----------------------------------------------------------------------------
+//  Return last run's results for the function whose FunctionHash_AddLine
+//  digest is inHash, or NULL if it has changed or is new.
+
+- (IncrementalFunc*)findIncrementalFunc: (const UInt8*)inHash
+{
+    if (!iOldIncState)
+        return NULL;
+
+    IncrementalFunc searchKey;
+
+    memcpy(searchKey.hash, inHash, INCREMENTAL_HASH_LENGTH);
+
+    return bsearch(&searchKey, iOldIncFuncs, iNumOldIncFuncs,
+        sizeof(IncrementalFunc), (COMPARISON_FUNC_TYPE)IncrementalFunc_Compare);
+}
+
+//  beginIncrementalFunction:
+// ----------------------------------------------------------------------------
+//  Called by processCodeLine: at each function's first line. Start saving
+//  the function's results under inHash, and look up the ones to reuse.
+//  inHash is NULL for a function we know nothing about, which is neither
+//  saved nor reused.
+
+- (void)beginIncrementalFunction: (const UInt8*)inHash
+{
+    IncrementalFunc*    oldFunc = (inHash) ?
+        [self findIncrementalFunc: inHash] : NULL;
+
+    iReusedLines        = (oldFunc) ? &iOldIncLines[oldFunc->firstLine] : NULL;
+    iNumReusedLines     = (oldFunc) ? oldFunc->numLines : 0;
+    iReusedLineIndex    = 0;
+    iIncRecording       = NO;
+
+    if (!inHash)
+        return;
+
+    if (iNumIncFuncs == iMaxIncFuncs)
+    {
+        uint32_t            newMax      = MAX(256, iMaxIncFuncs * 2);
+        IncrementalFunc*    newFuncs    =
+            realloc(iIncFuncs, sizeof(IncrementalFunc) * newMax);
+
+        if (!newFuncs)
+        {
+            fprintf(stderr, "otx: not enough memory for incremental state\n");
+            return;
+        }
+
+        iIncFuncs       = newFuncs;
+        iMaxIncFuncs    = newMax;
+    }
+
+    IncrementalFunc*    newFunc = &iIncFuncs[iNumIncFuncs++];
+
+    memcpy(newFunc->hash, inHash, INCREMENTAL_HASH_LENGTH);
+    newFunc->firstLine  = iNumIncLines;
+    newFunc->numLines   = 0;
+    iIncRecording       = YES;
+}
+
+//  beginIncrementalLine
+// ----------------------------------------------------------------------------
+//  Called by processCodeLine: at each line. Reserve the line's place in the
+//  current function's saved results, and return its reused results, if
+//  any. The place stays empty unless endIncrementalLine:flags: fills it.
+
+- (IncrementalEntry*)beginIncrementalLine
+{
+    IncrementalEntry*   reusedLine  = NULL;
+
+    if (iReusedLines && iReusedLineIndex < iNumReusedLines)
+        reusedLine  = &iReusedLines[iReusedLineIndex++];
+
+    if (!iIncRecording)
+        return reusedLine;
+
+    if (iNumIncLines == iMaxIncLines)
+    {
+        uint32_t            newMax      = MAX(4096, iMaxIncLines * 2);
+        IncrementalLine*    newLines    =
+            realloc(iIncLines, sizeof(IncrementalLine) * newMax);
+
+        if (!newLines)
+        {
+            fprintf(stderr, "otx: not enough memory for incremental state\n");
+
+            // Drop the whole function, it would be reused with lines missing.
+            iNumIncLines        = iIncFuncs[iNumIncFuncs - 1].firstLine;
+            iNumIncFuncs--;
+            iIncRecording       = NO;
+
+            return reusedLine;
+        }
+
+        iIncLines       = newLines;
+        iMaxIncLines    = newMax;
+    }
+
+    iIncLines[iNumIncLines++]   = (IncrementalLine){NULL, 0};
+    iIncFuncs[iNumIncFuncs - 1].numLines++;
+
+    return reusedLine;
+}
+
+//  endIncrementalLine:flags:
+// ----------------------------------------------------------------------------
+//  Save the final comment and IncrementalLineFlags of the line passed to the
+//  last beginIncrementalLine.
+
+- (void)endIncrementalLine: (const char*)inComment
+                     flags: (uint32_t)inFlags
+{
+    if (!iIncRecording)
+        return;
+
+    IncrementalLine*    theLine = &iIncLines[iNumIncLines - 1];
+    size_t              length  = strlen(inComment);
+
+    theLine->flags  = inFlags;
+
+    if (!length)
+        return;
+
+    char*   theCopy = [self allocFromArena: &iIncStrings size: length + 1];
+
+    if (theCopy)
+    {
+        memcpy(theCopy, inComment, length + 1);
+        theLine->comment    = theCopy;
+    }
+}
+
+//  writeIncrementalState
+// ----------------------------------------------------------------------------
+//  Replace the -incremental state file with this run's results, see
+//  IncrementalFileHeader for the layout. Comments are shared between lines.
+
+- (BOOL)writeIncrementalState
+{
+    // The old state is about to be overwritten.
+    if (iOldIncState)
+    {
+        munmap(iOldIncState, iOldIncSize);
+        iOldIncState    = NULL;
+        iReusedLines    = NULL;
+    }
+
+    qsort(iIncFuncs, iNumIncFuncs, sizeof(IncrementalFunc),
+        (COMPARISON_FUNC_TYPE)IncrementalFunc_Compare);
+
+    RecordStrings       strings     = {NULL, 1, 0, NULL, 1024};
+    IncrementalEntry*   entries     =
+        malloc(sizeof(IncrementalEntry) * MAX(iNumIncLines, 1));
+    BOOL                result      = YES;
+    uint32_t            i;
+
+    while (strings.maxSlots < iNumIncLines * 2 + 2)
+        strings.maxSlots   *= 2;
+
+    strings.slots   = calloc(strings.maxSlots, sizeof(uint32_t));
+    strings.strings = malloc(1024);
+    strings.maxSize = 1024;
+
+    if (!entries || !strings.slots || !strings.strings)
+        result  = NO;
+    else
+    {
+        strings.strings[0]  = 0;
+
+        for (i = 0; i < iNumIncLines && result; i++)
+        {
+            uint32_t    offset  =
+                RecordStrings_Intern(&strings, iIncLines[i].comment);
+
+            if (offset == UINT32_MAX)
+                result  = NO;
+
+            entries[i]  = (IncrementalEntry){offset, iIncLines[i].flags};
+        }
+    }
+
+    if (!result)
+        fprintf(stderr, "otx: not enough memory to write incremental state\n");
+    else
+    {
+        IncrementalFileHeader   header  = {INCREMENTAL_FILE_MAGIC,
+            INCREMENTAL_FILE_VERSION, {0}, iNumIncFuncs, iNumIncLines,
+            strings.size, 0};
+        FILE*                   outFile =
+            fopen(iOpts.incrementalPath, "wb");
+
+        [self incrementalOptionsHash: header.optionsHash];
+
+        if (!outFile)
+        {
+            perror("otx: unable to open incremental state file");
+            result  = NO;
+        }
+        else
+        {
+            if (fwrite(&header, sizeof(header), 1, outFile) != 1     ||
+                fwrite(iIncFuncs, sizeof(IncrementalFunc), iNumIncFuncs,
+                    outFile) != iNumIncFuncs                        ||
+                fwrite(entries, sizeof(IncrementalEntry), iNumIncLines,
+                    outFile) != iNumIncLines                        ||
+                fwrite(strings.strings, 1, strings.size, outFile) !=
+                    strings.size)
+            {
+                perror("otx: unable to write incremental state file");
+                result  = NO;
+            }
+
+            if (fclose(outFile) != 0)
+            {
+                perror("otx: unable to close incremental state file");
+                result  = NO;
+            }
+        }
+    }
+
+    if (entries)
+        free(entries);
+
+    if (strings.slots)
+        free(strings.slots);
+
+    if (strings.strings)
+        free(strings.strings);
+
+    return result;
+}
+
+#pragma mark -
+//  recordInstruction:functionName:toCString:maxLength:
+// ----------------------------------------------------------------------------
+//  Turn one processed instruction, and the function it starts if inName is
+//  not NULL, into -records output. For JSON Lines, write a record per line
+//  to outCString and return its length. Columnar records are kept for
+//  writeColumnarRecords instead, and nothing is written.
+
+- (size_t)recordInstruction: (InsnRecord*)inRecord
+               functionName: (const char*)inName
+                  toCString: (char*)outCString
+                  maxLength: (size_t)inMaxLength
+{
+    size_t  nameLength  = (inName) ? TrimFunctionName(&inName) : 0;
+    UInt8   i;
+
+    outCString[0]   = 0;
+
+    if (iOpts.recordFormat == ColumnarRecords)
+    {
+        InsnRecord      theRecord       = *inRecord;
+        const char**    theStrings[]    = {&theRecord.mnemonic,
+            &theRecord.operands, &theRecord.symbol, &theRecord.selector,
+            &theRecord.className, &theRecord.comment};
+
+        // Keep our own copies, the originals don't outlive the line.
+        for (i = 0; i < sizeof(theStrings) / sizeof(theStrings[0]); i++)
+        {
+            const char* theString   = *theStrings[i];
+            char*       theCopy     = NULL;
+
+            if (theString && theString[0])
+            {
+                size_t  theLength   = strlen(theString);
+
+                theCopy = [self allocFromArena: &iRecordStrings
+                    size: theLength + 1];
+
+                if (theCopy)
+                    memcpy(theCopy, theString, theLength + 1);
+            }
+
+            *theStrings[i]  = (theCopy) ? theCopy : "";
+        }
+
+        if (iNumInsnRecords == iMaxInsnRecords)
+        {
+            iMaxInsnRecords = MAX(1024, iMaxInsnRecords * 2);
+            iInsnRecords    = realloc(iInsnRecords,
+                sizeof(InsnRecord) * iMaxInsnRecords);
+        }
+
+        iInsnRecords[iNumInsnRecords++] = theRecord;
+
+        if (inName && nameLength)
+        {
+            char*   theName = [self allocFromArena: &iRecordStrings
+                size: nameLength + 1];
+
+            if (!theName)
+                return 0;
+
+            memcpy(theName, inName, nameLength);
+            theName[nameLength] = 0;
+
+            if (iNumFuncRecords == iMaxFuncRecords)
+            {
+                iMaxFuncRecords = MAX(256, iMaxFuncRecords * 2);
+                iFuncRecords    = realloc(iFuncRecords,
+                    sizeof(FuncRecord) * iMaxFuncRecords);
+            }
+
+            iFuncRecords[iNumFuncRecords++] =
+                (FuncRecord){inRecord->address, theName};
+        }
+
+        return 0;
+    }
+
+    // Leave room for each record's "}\n".
+    size_t  theMaxLength    = inMaxLength - 2;
+    size_t  theLength       = 0;
+
+    if (inName && nameLength)
+    {
+        char    theName[MAX_LINE_LENGTH];
+
+        nameLength  = MIN(nameLength, MAX_LINE_LENGTH - 1);
+        memcpy(theName, inName, nameLength);
+        theName[nameLength] = 0;
+
+        theLength   = snprintf(outCString, theMaxLength,
+            "{\"type\":\"function\",\"address\":%llu", inRecord->address);
+        theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+            "name", theName);
+        outCString[theLength++] = '}';
+        outCString[theLength++] = '\n';
+    }
+
+    char    theCodeCString[31];
+
+    for (i = 0; i < inRecord->codeLength && i < 15; i++)
+        snprintf(&theCodeCString[i * 2], 3, "%02x", inRecord->code[i]);
+
+    theCodeCString[i * 2]   = 0;
+
+    theLength  += snprintf(&outCString[theLength], theMaxLength - theLength,
+        "{\"type\":\"insn\",\"address\":%llu,\"function\":%llu",
+        inRecord->address, inRecord->function);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "bytes", theCodeCString);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "mnemonic", inRecord->mnemonic);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "operands", inRecord->operands);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "symbol", inRecord->symbol);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "selector", inRecord->selector);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "class", inRecord->className);
+    theLength   = AppendJSONField(outCString, theLength, theMaxLength,
+        "comment", inRecord->comment);
+    outCString[theLength++] = '}';
+    outCString[theLength++] = '\n';
+    outCString[theLength]   = 0;
+
+    return theLength;
+}
+
+//  mergeRecordsFrom:
+// ----------------------------------------------------------------------------
+//  Take over a worker's columnar records, like mergeXrefsFrom:. Not
+//  thread-safe, callers synchronize on self.
+
+- (void)mergeRecordsFrom: (ExeProcessor*)inWorker
+{
+    if (inWorker->iNumInsnRecords)
+    {
+        if (iNumInsnRecords + inWorker->iNumInsnRecords > iMaxInsnRecords)
+        {
+            iMaxInsnRecords = iNumInsnRecords + inWorker->iNumInsnRecords;
+            iInsnRecords    = realloc(iInsnRecords,
+                sizeof(InsnRecord) * iMaxInsnRecords);
+        }
+
+        memcpy(&iInsnRecords[iNumInsnRecords], inWorker->iInsnRecords,
+            sizeof(InsnRecord) * inWorker->iNumInsnRecords);
+        iNumInsnRecords += inWorker->iNumInsnRecords;
+    }
+
+    if (inWorker->iNumFuncRecords)
+    {
+        if (iNumFuncRecords + inWorker->iNumFuncRecords > iMaxFuncRecords)
+        {
+            iMaxFuncRecords = iNumFuncRecords + inWorker->iNumFuncRecords;
+            iFuncRecords    = realloc(iFuncRecords,
+                sizeof(FuncRecord) * iMaxFuncRecords);
+        }
+
+        memcpy(&iFuncRecords[iNumFuncRecords], inWorker->iFuncRecords,
+            sizeof(FuncRecord) * inWorker->iNumFuncRecords);
+        iNumFuncRecords += inWorker->iNumFuncRecords;
+    }
+
+    // Append the worker's chunks to ours.
+    ArenaChunk* lastChunk   = inWorker->iRecordStrings.chunks;
+
+    if (lastChunk)
+    {
+        while (lastChunk->next)
+            lastChunk   = lastChunk->next;
+
+        lastChunk->next         = iRecordStrings.chunks;
+        iRecordStrings.chunks   = inWorker->iRecordStrings.chunks;
+    }
+
+    if (inWorker->iInsnRecords)
+        free(inWorker->iInsnRecords);
+
+    if (inWorker->iFuncRecords)
+        free(inWorker->iFuncRecords);
+
+    inWorker->iInsnRecords          = NULL;
+    inWorker->iNumInsnRecords       = 0;
+    inWorker->iMaxInsnRecords       = 0;
+    inWorker->iFuncRecords          = NULL;
+    inWorker->iNumFuncRecords       = 0;
+    inWorker->iMaxFuncRecords       = 0;
+    inWorker->iRecordStrings.chunks = NULL;
+}
+
+//  writeColumnarRecords
+// ----------------------------------------------------------------------------
+//  Sort the records kept by recordInstruction:functionName:toCString:
+//  maxLength: and append them to the output. See RecordsHeader for the
+//  layout.
+
+- (BOOL)writeColumnarRecords
+{
+    qsort(iInsnRecords, iNumInsnRecords, sizeof(InsnRecord),
+        (COMPARISON_FUNC_TYPE)InsnRecord_Compare);
+    qsort(iFuncRecords, iNumFuncRecords, sizeof(FuncRecord),
+        (COMPARISON_FUNC_TYPE)FuncRecord_Compare);
+
+    uint32_t        numInsns    = iNumInsnRecords;
+    uint32_t        numFuncs    = iNumFuncRecords;
+    uint32_t        numStrings  = numInsns * 6 + numFuncs;
+    RecordStrings   strings     = {NULL, 1, 0, NULL, 1024};
+    UInt64*         addresses   = malloc(sizeof(UInt64) * MAX(numInsns, 1));
+    UInt64*         functions   = malloc(sizeof(UInt64) * MAX(numInsns, 1));
+    RecordCode*     codes       = calloc(MAX(numInsns, 1), sizeof(RecordCode));
+    uint32_t*       offsets     =
+        malloc(sizeof(uint32_t) * 6 * MAX(numInsns, 1));
+    UInt64*         funcAddrs   = malloc(sizeof(UInt64) * MAX(numFuncs, 1));
+    uint32_t*       funcNames   = malloc(sizeof(uint32_t) * MAX(numFuncs, 1));
+    BOOL            result      = YES;
+    uint32_t        i, j;
+
+    while (strings.maxSlots < numStrings * 2 + 2)
+        strings.maxSlots   *= 2;
+
+    strings.slots   = calloc(strings.maxSlots, sizeof(uint32_t));
+    strings.strings = malloc(1024);
+    strings.maxSize = 1024;
+
+    if (!addresses || !functions || !codes || !offsets || !funcAddrs ||
+        !funcNames || !strings.slots || !strings.strings)
+        result  = NO;
+    else
+    {
+        strings.strings[0]  = 0;
+
+        for (i = 0; i < numInsns && result; i++)
+        {
+            InsnRecord* theRecord       = &iInsnRecords[i];
+            const char* theStrings[6]   = {theRecord->mnemonic,
+                theRecord->operands, theRecord->symbol, theRecord->selector,
+                theRecord->className, theRecord->comment};
+
+            addresses[i]        = theRecord->address;
+            functions[i]        = theRecord->function;
+            codes[i].length     = theRecord->codeLength;
+            memcpy(codes[i].bytes, theRecord->code, sizeof(codes[i].bytes));
+
+            for (j = 0; j < 6; j++)
+            {
+                offsets[j * numInsns + i]   =
+                    RecordStrings_Intern(&strings, theStrings[j]);
+
+                if (offsets[j * numInsns + i] == UINT32_MAX)
+                    result  = NO;
+            }
+        }
+
+        for (i = 0; i < numFuncs && result; i++)
+        {
+            funcAddrs[i]    = iFuncRecords[i].address;
+            funcNames[i]    =
+                RecordStrings_Intern(&strings, iFuncRecords[i].name);
+
+            if (funcNames[i] == UINT32_MAX)
+                result  = NO;
+        }
+    }
+
+    if (!result)
+        fprintf(stderr, "otx: not enough memory for columnar records\n");
+
+    // Lay out the columns, see RecordsHeader.
+    RecordsHeader   header          = {RECORDS_MAGIC, RECORDS_VERSION,
+        numInsns, numFuncs, strings.size, 0, {0}};
+    const void*     columnData[RecordNumColumns];
+    UInt64          columnSizes[RecordNumColumns];
+    UInt64          fileOffset      = sizeof(header);
+
+    for (i = RecordMnemonicColumn; i <= RecordCommentColumn; i++)
+    {
+        columnData[i]   = &offsets[(i - RecordMnemonicColumn) * numInsns];
+        columnSizes[i]  = sizeof(uint32_t) * numInsns;
+    }
+
+    columnData[RecordAddressColumn]         = addresses;
+    columnSizes[RecordAddressColumn]        = sizeof(UInt64) * numInsns;
+    columnData[RecordFunctionColumn]        = functions;
+    columnSizes[RecordFunctionColumn]       = sizeof(UInt64) * numInsns;
+    columnData[RecordCodeColumn]            = codes;
+    columnSizes[RecordCodeColumn]           = sizeof(RecordCode) * numInsns;
+    columnData[RecordFuncAddressColumn]     = funcAddrs;
+    columnSizes[RecordFuncAddressColumn]    = sizeof(UInt64) * numFuncs;
+    columnData[RecordFuncNameColumn]        = funcNames;
+    columnSizes[RecordFuncNameColumn]       = sizeof(uint32_t) * numFuncs;
+    columnData[RecordStringsColumn]         = strings.strings;
+    columnSizes[RecordStringsColumn]        = strings.size;
+
+    for (i = 0; i < RecordNumColumns; i++)
+    {
+        header.columns[i]   = fileOffset;
+        fileOffset          = (fileOffset + columnSizes[i] + 7) & ~7ULL;
+    }
+
+    FILE*   outFile = NULL;
+
+    if (result)
+    {
+        // In the CLI target, iOutputFilePath is nil.
+        if (iOutputFilePath)
+            outFile = fopen(UTF8STRING(iOutputFilePath), "a");
+        else
+            outFile = stdout;
+
+        if (!outFile)
+        {
+            perror("otx: unable to open output file");
+            result  = NO;
+        }
+    }
+
+    if (outFile)
+    {
+        static const char   padding[8]  = {0};
+        OutputWriter        writer;
+
+        // Go through the writer, so -z compresses the records too.
+        result  = [self openOutputWriter: &writer toFile: outFile
+            withToc: NO];
+
+        if (result)
+        {
+            result  = [self writeOutput: &writer bytes: (char*)&header
+                length: sizeof(header)];
+
+            for (i = 0; i < RecordNumColumns && result; i++)
+            {
+                size_t  padLength   =
+                    ((columnSizes[i] + 7) & ~7ULL) - columnSizes[i];
+
+                result  = [self writeOutput: &writer bytes: columnData[i]
+                    length: columnSizes[i]] &&
+                    [self writeOutput: &writer bytes: padding
+                    length: padLength];
+            }
+
+            result  = [self closeOutputWriter: &writer] && result;
+        }
+
+        if (iOutputFilePath && fclose(outFile) != 0)
+        {
+            perror("otx: unable to close output file");
+            result  = NO;
+        }
+    }
+
+    free(addresses);
+    free(functions);
+    free(codes);
+    free(offsets);
+    free(funcAddrs);
+    free(funcNames);
+    free(strings.slots);
+    free(strings.strings);
+
+    return result;
+}
+
+#ifdef OTX_DEBUG
+//  printSymbol:
+// ----------------------------------------------------------------------------
+//  Used for symbol debugging.
+
+- (void)printSymbol: (nlist)inSym
+{
+    fprintf(stderr, "----------------\n\n");
+    fprintf(stderr, " n_strx = 0x%08x\n", inSym.n_un.n_strx);
+    fprintf(stderr, " n_type = 0x%02x\n", inSym.n_type);
+    fprintf(stderr, " n_sect = 0x%02x\n", inSym.n_sect);
+    fprintf(stderr, " n_desc = 0x%04x\n", inSym.n_desc);
+    fprintf(stderr, "n_value = 0x%08x (%u)\n\n", inSym.n_value, inSym.n_value);
+
+    if ((inSym.n_type & N_STAB) != 0)
+    {   // too complicated, see <mach-o/stab.h>
+        fprintf(stderr, "STAB symbol\n");
+    }
+    else    // not a STAB
+    {
+        if ((inSym.n_type & N_PEXT) != 0)
+            fprintf(stderr, "Private external symbol\n\n");
+        else if ((inSym.n_type & N_EXT) != 0)
+            fprintf(stderr, "External symbol\n\n");
+
+        UInt8   theNType    = inSym.n_type & N_TYPE;
+        UInt16  theRefType  = inSym.n_desc & REFERENCE_TYPE;
+
+        fprintf(stderr, "Symbol type: ");
+
+        if (theNType == N_ABS)
+            fprintf(stderr, "Absolute\n");
+        else if (theNType == N_SECT)
+            fprintf(stderr, "Defined in section %u\n", inSym.n_sect);
+        else if (theNType == N_INDR)
+            fprintf(stderr, "Indirect\n");
+        else
+        {
+            if (theNType == N_UNDF)
+                fprintf(stderr, "Undefined\n");
+            else if (theNType == N_PBUD)
+                fprintf(stderr, "Prebound undefined\n");
+
+            switch (theRefType)
+            {
+                case REFERENCE_FLAG_UNDEFINED_NON_LAZY:
+                    fprintf(stderr, "REFERENCE_FLAG_UNDEFINED_NON_LAZY\n");
+                    break;
+                case REFERENCE_FLAG_UNDEFINED_LAZY:
+                    fprintf(stderr, "REFERENCE_FLAG_UNDEFINED_LAZY\n");
+                    break;
+                case REFERENCE_FLAG_DEFINED:
+                    fprintf(stderr, "REFERENCE_FLAG_DEFINED\n");
+                    break;
+                case REFERENCE_FLAG_PRIVATE_DEFINED:
+                    fprintf(stderr, "REFERENCE_FLAG_PRIVATE_DEFINED\n");
+                    break;
+                case REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY:
+                    fprintf(stderr, "REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY\n");
+                    break;
+                case REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY:
+                    fprintf(stderr, "REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY\n");
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+
+    fprintf(stderr, "\n");
+}
+
+//  printBlocks:
+// ----------------------------------------------------------------------------
+//  Used for block debugging. Sublclasses may override.
+
+- (void)printBlocks: (uint32_t)inFuncIndex;
+{}
+#endif  // OTX_DEBUG
+
+- (void) printSummary
+{
+    unsigned percentage = (iMatchedSelectorCount * 100) / (iMatchedSelectorCount + iMissedSelectorCount);
+    fprintf(stderr, "%u selectors matched, %u missed, %u%%\n", iMatchedSelectorCount, iMissedSelectorCount, percentage);
+    fprintf(stderr, "%u blocks visited in %u gather passes\n", iBlockVisits, iGatherPasses);
+
+    // What processCodeLine: spent in the arch handlers per code line, for
+    // comparing builds.
+    if (iTimedLines)
+    {
+        mach_timebase_info_data_t   timebase;
+
+        mach_timebase_info(&timebase);
+        fprintf(stderr, "%u code lines, %.1f ns each in commentForLine:, "
+            "%.1f ns each in updateRegisters:\n", iTimedLines,
+            (double)iCommentTicks * timebase.numer / timebase.denom / iTimedLines,
+            (double)iRegistersTicks * timebase.numer / timebase.denom / iTimedLines);
+    }
+
+    if (iOpts.incrementalPath)
+        fprintf(stderr, "%u functions reused from %s\n", iNumReusedFuncs, iOpts.incrementalPath);
 }
 
 @end
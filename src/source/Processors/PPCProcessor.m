@@ -64,6 +64,36 @@ extern BOOL gCancel;
     [super dealloc];
 }
 
+//  newWorker
+// ----------------------------------------------------------------------------
+
+- (id)newWorker
+{
+    PPCProcessor*   worker  = [super newWorker];
+
+    // Don't share our local variable arrays.
+    worker->iLocalSelves    = NULL;
+    worker->iNumLocalSelves = 0;
+    worker->iLocalVars      = NULL;
+    worker->iNumLocalVars   = 0;
+
+    return worker;
+}
+
+//  disposeWorker
+// ----------------------------------------------------------------------------
+
+- (void)disposeWorker
+{
+    if (iLocalSelves)
+        free(iLocalSelves);
+
+    if (iLocalVars)
+        free(iLocalVars);
+
+    [super disposeWorker];
+}
+
 //  loadDyldDataSection:
 // ----------------------------------------------------------------------------
 
@@ -278,21 +308,11 @@ extern BOOL gCancel;
 // FIXME: mCurrentFuncInfoIndex is -1 here when it should not be
                 funcInfo = &iFuncInfos[iCurrentFuncInfoIndex];
 
-                if (!funcInfo->blocks)
-                    break;
-
-                uint32_t  i;
-
-                for (i = 0; i < funcInfo->numBlocks; i++)
-                {
-                    if (funcInfo->blocks[i].beginAddress != absoluteAddy)
-                        continue;
+                BlockInfo*      targetBlock = [self findBlockAtAddress: absoluteAddy
+                    inFunction: funcInfo];
 
-                    if (funcInfo->blocks[i].isEpilog)
-                        snprintf(iLineCommentCString, 8, "return;");
-
-                    break;
-                }
+                if (targetBlock && targetBlock->isEpilog)
+                    snprintf(iLineCommentCString, 8, "return;");
             }
 
             break;
@@ -737,6 +757,10 @@ extern BOOL gCancel;
     }
     
     iMatchedSelectorCount++;
+    [self addXref: selString kind: XrefSelector
+        site: inLine->info.address function: iCurrentFunctionStart];
+
+    iLineSelector   = selString;
 
     UInt8   sendType    = [self sendTypeFromMsgSend:ioComment];
 
@@ -850,6 +874,8 @@ extern BOOL gCancel;
         }
     }
 
+    iLineClassName  = className;
+
     if (className)
     {
         snprintf(tempComment, MAX_COMMENT_LENGTH,
@@ -903,17 +929,19 @@ extern BOOL gCancel;
 
     if (PO(theCode) == 18)  // b, ba, bl, bla
     {
-        Line* theNewLine  = malloc(sizeof(Line));
-
-        memcpy(theNewLine, (*ioLine)->alt, sizeof(Line));
-        theNewLine->chars   = malloc(theNewLine->length + 1);
-        strncpy(theNewLine->chars, (*ioLine)->alt->chars,
-            theNewLine->length + 1);
-
-        // Swap in the verbose line and free the previous verbose lines.
-        [self deleteLinesBefore:(*ioLine)->alt fromList:&iVerboseLineListHead];
-        [self replaceLine:*ioLine withLine:theNewLine inList:&iPlainLineListHead];
-        *ioLine = theNewLine;
+        // Take the verbose line's text. The Line itself stays put, so other
+        // threads can safely walk the list while we do this.
+        free((*ioLine)->chars);
+        (*ioLine)->chars        = (*ioLine)->alt->chars;
+        (*ioLine)->length       = (*ioLine)->alt->length;
+        (*ioLine)->alt->chars   = NULL;
+        (*ioLine)->alt->length  = 0;
+
+        // Free the verbose lines before this one. Worker threads leave that
+        // to processLinesInParallel, see newWorker.
+        if (iVerboseLineListHead && (*ioLine)->alt != iVerboseLineListHead)
+            [self deleteLinesBefore: (*ioLine)->alt
+                fromList: &iVerboseLineListHead];
     }
 }
 
@@ -1451,6 +1479,10 @@ extern BOOL gCancel;
     if (iCurrentFuncInfoIndex < 0)
         return NO;
 
+    // Only lines flagged by addBlockAtAddress:toFunction: can begin a block.
+    if (!inLine->info.startsBlock)
+        return NO;
+
     // Search current FunctionInfo for blocks that start at this address.
     FunctionInfo*   funcInfo    =
         &iFuncInfos[iCurrentFuncInfoIndex];
@@ -1458,54 +1490,43 @@ extern BOOL gCancel;
     if (!funcInfo->blocks)
         return NO;
 
-    uint32_t  i;
-
-    for (i = 0; i < funcInfo->numBlocks; i++)
-    {
-        if (funcInfo->blocks[i].beginAddress !=
-            inLine->info.address)
-            continue;
+    BlockInfo*      theBlock    = [self findBlockAtAddress: inLine->info.address
+        inFunction: funcInfo];
 
-        // Update machine state.
-        MachineState    machState   =
-            funcInfo->blocks[i].state;
+    if (!theBlock)
+        return NO;
 
-        memcpy(iRegInfos, machState.regInfos,
-            sizeof(GPRegisterInfo) * 32);
-        iLR     = machState.regInfos[LRIndex];
-        iCTR    = machState.regInfos[CTRIndex];
+    // Update machine state.
+    MachineState    machState   = theBlock->state;
 
-        if (machState.localSelves)
-        {
-            if (iLocalSelves)
-                free(iLocalSelves);
-
-            iNumLocalSelves = machState.numLocalSelves;
-            iLocalSelves    = malloc(
-                sizeof(VarInfo) * iNumLocalSelves);
-            memcpy(iLocalSelves, machState.localSelves,
-                sizeof(VarInfo) * iNumLocalSelves);
-        }
+    memcpy(iRegInfos, machState.regInfos,
+        sizeof(GPRegisterInfo) * 32);
+    iLR     = machState.regInfos[LRIndex];
+    iCTR    = machState.regInfos[CTRIndex];
 
-        if (machState.localVars)
-        {
-            if (iLocalVars)
-                free(iLocalVars);
-
-            iNumLocalVars   = machState.numLocalVars;
-            iLocalVars      = malloc(
-                sizeof(VarInfo) * iNumLocalVars);
-            memcpy(iLocalVars, machState.localVars,
-                sizeof(VarInfo) * iNumLocalVars);
-        }
+    if (machState.localSelves)
+    {
+        // Reuse our buffers, they're usually big enough already.
+        iNumLocalSelves = machState.numLocalSelves;
+        iLocalSelves    = realloc(iLocalSelves,
+            sizeof(VarInfo) * iNumLocalSelves);
+        memcpy(iLocalSelves, machState.localSelves,
+            sizeof(VarInfo) * iNumLocalSelves);
+    }
 
-        // Optionally add a blank line before this block.
-        if (iOpts.separateLogicalBlocks && inLine->chars[0] != '\n' &&
-            !inLine->info.isFunction)
-            needNewLine = YES;
+    if (machState.localVars)
+    {
+        iNumLocalVars   = machState.numLocalVars;
+        iLocalVars      = realloc(iLocalVars,
+            sizeof(VarInfo) * iNumLocalVars);
+        memcpy(iLocalVars, machState.localVars,
+            sizeof(VarInfo) * iNumLocalVars);
+    }
 
-        break;
-    }   // for (i = 0...)
+    // Optionally add a blank line before this block.
+    if (iOpts.separateLogicalBlocks && inLine->chars[0] != '\n' &&
+        !inLine->info.isFunction)
+        needNewLine = YES;
 
     return needNewLine;
 }
@@ -1518,30 +1539,18 @@ extern BOOL gCancel;
     if (!inLine)
         return NO;
 
-    uint32_t  theAddy = inLine->info.address;
-
-    if (theAddy == iAddrDyldStubBindingHelper   ||
-        theAddy == iAddrDyldFuncLookupPointer)
-        return YES;
-
-    MethodInfo* theDummyInfo    = NULL;
-
-    // In Obj-C apps, the majority of funcs will have Obj-C symbols, so check
-    // those first.
-    if ([self findClassMethod:&theDummyInfo byAddress:theAddy])
-        return YES;
-
-    if ([self findCatMethod:&theDummyInfo byAddress:theAddy])
-        return YES;
-
-    // If it's not an Obj-C method, maybe there's an nlist.
-    if ([self findSymbolByAddress:theAddy])
+    // dyld helpers, Obj-C methods and nlists.
+    if ([self isFunctionStart:inLine->info.address])
         return YES;
 
     // If otool gave us a function name...
     if (inLine->prev && !inLine->prev->info.isCode)
         return YES;
 
+    // LC_FUNCTION_STARTS lists them all, no need to guess.
+    if (iFuncStartsSize)
+        return NO;
+
     BOOL isFunction = NO;
     uint32_t theCode = *(uint32_t*)inLine->info.code;
 
@@ -1644,17 +1653,97 @@ extern BOOL gCancel;
     return IS_BLOCK_BRANCH(theCode);
 }
 
-//  gatherFuncInfos
+//  codeIsCall:
 // ----------------------------------------------------------------------------
 
-- (void)gatherFuncInfos
+- (BOOL)codeIsCall: (UInt8*)inCode
 {
-    Line*           theLine     = iPlainLineListHead;
+    uint32_t theCode = *(uint32_t*)inCode;
+
+    theCode = OSSwapBigToHostInt32(theCode);
+    return IS_BRANCH_LINK(theCode);
+}
+
+//  getBranchInfo:forLine:
+// ----------------------------------------------------------------------------
+//  Return YES if inLine ends a basic block, and describe where control goes
+//  from there. Calls don't end blocks, so neither do branches that set LR.
+
+- (BOOL)getBranchInfo: (BranchInfo*)outInfo
+              forLine: (Line*)inLine
+{
+    uint32_t    theCode = *(uint32_t*)inLine->info.code;
+
+    theCode = OSSwapBigToHostInt32(theCode);
+
+    if (!IS_BLOCK_BRANCH(theCode))
+        return NO;
+
+    *outInfo    = (BranchInfo){0, NO, NO};
+
+    switch (PO(theCode))
+    {
+        case 0x12:  // b
+            outInfo->target     = inLine->info.address + LI(theCode);
+            outInfo->hasTarget  = YES;
+            break;
+
+        case 0x10:  // bc
+            outInfo->target         = inLine->info.address + BD(theCode);
+            outInfo->hasTarget      = YES;
+            outInfo->fallsThrough   = (BO(theCode) & 0x14) != 0x14;
+            break;
+
+        case 0x13:  // bclr, bcctr
+            if (SO(theCode) != 16 && SO(theCode) != 528)
+                return NO;
+
+            outInfo->fallsThrough   = (BO(theCode) & 0x14) != 0x14;
+            break;
+    }
+
+    return YES;
+}
+
+//  getCallTarget:forLine:
+// ----------------------------------------------------------------------------
+//  Return YES if inLine is a bl or bla, with the address it calls. bl $+4
+//  only loads LR with the PC.
+
+- (BOOL)getCallTarget: (uint32_t*)outTarget
+              forLine: (Line*)inLine
+{
+    uint32_t    theCode = *(uint32_t*)inLine->info.code;
+
+    theCode = OSSwapBigToHostInt32(theCode);
+
+    if (PO(theCode) != 0x12 || !LK(theCode))
+        return NO;
+
+    if (AA(theCode))
+        *outTarget  = (uint32_t)LI(theCode);
+    else if (LI(theCode) == 4)
+        return NO;
+    else
+        *outTarget  = inLine->info.address + LI(theCode);
+
+    return YES;
+}
+
+//  gatherFuncInfosFrom:to:
+// ----------------------------------------------------------------------------
+//  Gather block info for the lines from inStartLine up to, but not
+//  including, inEndLine. A NULL inEndLine means the end of the list.
+
+- (void)gatherFuncInfosFrom: (Line*)inStartLine
+                         to: (Line*)inEndLine
+{
+    Line*           theLine     = inStartLine;
     uint32_t          theCode;
     uint32_t          progCounter = 0;
 
     // Loop thru lines.
-    while (theLine)
+    while (theLine && theLine != inEndLine)
     {
         if (!(progCounter % (PROGRESS_FREQ * 5)))
         {
@@ -1677,9 +1766,18 @@ extern BOOL gCancel;
         {
             iCurrentFuncPtr = theLine->info.address;
             [self resetRegisters:theLine];
+            iBlockVisits++;
         }
         else
+        {
+            // Count every entry into a block for the -debug summary.
+            if (theLine->info.startsBlock && iCurrentFuncInfoIndex >= 0 &&
+                [self findBlockAtAddress: theLine->info.address
+                inFunction: &iFuncInfos[iCurrentFuncInfoIndex]])
+                iBlockVisits++;
+
             [self restoreRegisters:theLine];
+        }
 
         [self updateRegisters:theLine];
 
@@ -1704,20 +1802,11 @@ extern BOOL gCancel;
             BlockInfo*  currentBlock    = NULL;
             Line*       endLine         = NULL;
             BOOL        isEpilog        = NO;
-            uint32_t      i;
 
             if (funcInfo->blocks)
-            {   // Blocks exist, find 1st one matching this address.
-                // This is an exhaustive search, but the speed hit should
-                // only be an issue with extremely long functions.
-                for (i = 0; i < funcInfo->numBlocks; i++)
-                {
-                    if (funcInfo->blocks[i].beginAddress == branchTarget)
-                    {
-                        currentBlock = &funcInfo->blocks[i];
-                        break;
-                    }
-                }
+            {   // Blocks exist, find the one matching this address.
+                currentBlock    = [self findBlockAtAddress: branchTarget
+                    inFunction: funcInfo];
 
                 if (currentBlock)
                 {   // Determine if the target block is an epilog.
@@ -1764,67 +1853,43 @@ extern BOOL gCancel;
                     }
                 }
                 else
-                {   // No matching blocks found, so allocate a new one.
-                    funcInfo->numBlocks++;
-                    funcInfo->blocks = realloc(funcInfo->blocks,
-                        sizeof(BlockInfo) * funcInfo->numBlocks);
-                    currentBlock =
-                        &funcInfo->blocks[funcInfo->numBlocks - 1];
-                    *currentBlock = (BlockInfo){0};
+                {   // No matching blocks found, so add a new one.
+                    currentBlock    = [self addBlockAtAddress: branchTarget
+                        toFunction: funcInfo];
                 }
             }
             else
-            {   // No existing blocks, allocate one.
-                funcInfo->numBlocks++;
-                funcInfo->blocks    = calloc(1, sizeof(BlockInfo));
-                currentBlock        = funcInfo->blocks;
+            {   // No existing blocks, add one.
+                currentBlock    = [self addBlockAtAddress: branchTarget
+                    toFunction: funcInfo];
             }
 
             // sanity check
             if (!currentBlock)
             {
-                fprintf(stderr, "otx: [PPCProcessor gatherFuncInfos] "
+                fprintf(stderr, "otx: [PPCProcessor gatherFuncInfosFrom:to:] "
                     "currentBlock is NULL. Flame the dev.\n");
                 return;
             }
 
-            // Create a new MachineState.
-            GPRegisterInfo* savedRegs   = malloc(
-                sizeof(GPRegisterInfo) * 34);
+            // Describe the current MachineState. updateBlock: copies it
+            // into the function's arena only if it's not already there.
+            GPRegisterInfo  savedRegs[34];
 
             memcpy(savedRegs, iRegInfos, sizeof(GPRegisterInfo) * 32);
             savedRegs[LRIndex]  = iLR;
             savedRegs[CTRIndex] = iCTR;
 
-            VarInfo*    savedSelves = NULL;
-
-            if (iLocalSelves)
-            {
-                savedSelves = malloc(
-                    sizeof(VarInfo) * iNumLocalSelves);
-                memcpy(savedSelves, iLocalSelves,
-                    sizeof(VarInfo) * iNumLocalSelves);
-            }
-
-            VarInfo*    savedVars   = NULL;
-
-            if (iLocalVars)
-            {
-                savedVars   = malloc(
-                    sizeof(VarInfo) * iNumLocalVars);
-                memcpy(savedVars, iLocalVars,
-                    sizeof(VarInfo) * iNumLocalVars);
-            }
-
             MachineState    machState   =
-                {savedRegs, savedSelves, iNumLocalSelves,
-                    savedVars, iNumLocalVars};
+                {savedRegs, iLocalSelves, iNumLocalSelves,
+                    iLocalVars, iNumLocalVars};
 
             // Store the new BlockInfo.
             BlockInfo   blockInfo   =
                 {branchTarget, endLine, isEpilog, machState};
 
-            memcpy(currentBlock, &blockInfo, sizeof(BlockInfo));
+            [self updateBlock: currentBlock withInfo: &blockInfo
+                fromLine: theLine numRegs: 34];
         }
 
         theLine = theLine->next;
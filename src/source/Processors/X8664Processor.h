@@ -10,6 +10,7 @@
 
 #import "Exe64Processor.h"
 #import "Deobfuscator.h"
+#import "X86Processor.h"
 
 #define REX_BIT_ON      (1 << 3)
 #define REX_BIT_OFF     0
@@ -51,6 +52,10 @@ enum {
     Var64Info*  iLocalVars;
     uint32_t      iNumLocalVars;
     UInt64      iHighestJumpTarget;
+
+    X86Operands iOperands;              // decoded from iOperandsLine
+    Line64*     iOperandsLine;
+    UInt64      iOperandsAddress;
 }
 
 @end
@@ -65,6 +65,36 @@
     [super dealloc];
 }
 
+//  newWorker
+// ----------------------------------------------------------------------------
+
+- (id)newWorker
+{
+    X8664Processor* worker  = [super newWorker];
+
+    // Don't share our local variable arrays.
+    worker->iLocalSelves    = NULL;
+    worker->iNumLocalSelves = 0;
+    worker->iLocalVars      = NULL;
+    worker->iNumLocalVars   = 0;
+
+    return worker;
+}
+
+//  disposeWorker
+// ----------------------------------------------------------------------------
+
+- (void)disposeWorker
+{
+    if (iLocalSelves)
+        free(iLocalSelves);
+
+    if (iLocalVars)
+        free(iLocalVars);
+
+    [super disposeWorker];
+}
+
 //  loadDyldDataSection:
 // ----------------------------------------------------------------------------
 
@@ -229,15 +259,32 @@
 }
 
 #pragma mark -
+//  operandsForLine:
+// ----------------------------------------------------------------------------
+//  Decode inLine once for all the handlers that look at it.
+
+- (X86Operands*)operandsForLine: (Line64*)inLine
+{
+    if (inLine != iOperandsLine ||
+        inLine->info.address != iOperandsAddress)
+    {
+        X86DecodeOperands(inLine->info.code, YES, &iOperands);
+        iOperandsLine       = inLine;
+        iOperandsAddress    = inLine->info.address;
+    }
+
+    return &iOperands;
+}
+
 //  commentForLine:
 // ----------------------------------------------------------------------------
 
 - (void)commentForLine: (Line64*)inLine;
 {
-    UInt8   opcode = inLine->info.code[0];
+    X86Operands*    ops = [self operandsForLine:inLine];
+    UInt8   opcode = ops->opcode;
     UInt8   modRM = 0;
-    UInt8   opcodeIndex = 0;
-    UInt8   rexByte = 0;
+    UInt8   rexByte = ops->rex;
     char*   theDummyPtr = NULL;
     char*   theSymPtr = NULL;
     UInt64  localAddy = 0;
@@ -245,831 +292,698 @@
 
     iLineCommentCString[0]  = 0;
 
-    while (1)
+    if (!(ops->flags & OPF_NOTE))
+        return;
+
+    switch (opcode)
     {
-        switch (opcode)
+        case 0x0f:  // 2-byte and SSE opcodes   **add sysenter support here
         {
-            case 0x40: case 0x41: case 0x42: case 0x43:
-            case 0x44: case 0x45: case 0x46: case 0x47:
-            case 0x48: case 0x49: case 0x4a: case 0x4b:
-            case 0x4c: case 0x4d: case 0x4e: case 0x4f:
-                // Save the REX bits and continue.
-                rexByte = opcode;
-                opcodeIndex++;
-                opcode = inLine->info.code[opcodeIndex];
-                continue;
-
-            case 0x0f:  // 2-byte and SSE opcodes   **add sysenter support here
+            if (ops->opcode2 == 0x2e)    // ucomiss
             {
-                if (inLine->info.code[opcodeIndex + 1] == 0x2e)    // ucomiss
-                {
-                    localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 3];
-                    localAddy = OSSwapLittleToHostInt32(localAddy);
-                    theDummyPtr = [self getPointer:localAddy type:NULL];
+                localAddy = (uint32_t)ops->disp;
+                theDummyPtr = [self getPointer:localAddy type:NULL];
 
-                    if (theDummyPtr)
-                    {
-                        uint32_t  theInt32    = *(uint32_t*)theDummyPtr;
+                if (theDummyPtr)
+                {
+                    uint32_t  theInt32    = *(uint32_t*)theDummyPtr;
 
-                        theInt32    = OSSwapLittleToHostInt32(theInt32);
-                        snprintf(iLineCommentCString, 30, "%G", *(float*)&theInt32);
-                    }
+                    theInt32    = OSSwapLittleToHostInt32(theInt32);
+                    snprintf(iLineCommentCString, 30, "%G", *(float*)&theInt32);
                 }
-                else if (inLine->info.code[opcodeIndex + 1] == 0x84)   // jcc
-                {
-                    if (!inLine->next)
-                        break;
+            }
+            else if (ops->opcode2 == 0x84)   // jcc
+            {
+                if (!inLine->next)
+                    break;
 
-                    SInt32 targetOffset = *(SInt32*)&inLine->info.code[opcodeIndex + 2];
+                targetAddy = inLine->next->info.address + (SInt32)ops->imm;
 
-                    targetOffset = OSSwapLittleToHostInt32(targetOffset);
-                    targetAddy = inLine->next->info.address + targetOffset;
+                // Search current Function64Info for blocks that start at this address.
+                Function64Info* funcInfo    =
+                    &iFuncInfos[iCurrentFuncInfoIndex];
 
-                    // Search current Function64Info for blocks that start at this address.
-                    Function64Info* funcInfo    =
-                        &iFuncInfos[iCurrentFuncInfoIndex];
+                Block64Info*    targetBlock = [self findBlockAtAddress: targetAddy
+                    inFunction: funcInfo];
 
-                    if (!funcInfo->blocks)
-                        break;
+                if (targetBlock && targetBlock->isEpilog)
+                    snprintf(iLineCommentCString, 8, "return;");
+            }
 
-                    uint32_t  i;
+            break;
+        }
 
-                    for (i = 0; i < funcInfo->numBlocks; i++)
-                    {
-                        if (funcInfo->blocks[i].beginAddress != targetAddy)
-                            continue;
+        case 0x3c:  // cmpb imm8,al
+        {
+            UInt8 imm = (UInt8)ops->imm;
 
-                        if (funcInfo->blocks[i].isEpilog)
-                            snprintf(iLineCommentCString, 8, "return;");
+            // Check for a single printable 7-bit char.
+            if (imm >= 0x20 && imm < 0x7f)
+                snprintf(iLineCommentCString, 4, "'%c'", imm);
 
-                        break;
-                    }
-                }
+            break;
+        }
 
+        case 0x66:
+            if (ops->nextOpcode != 0x0f || ops->opcode2 != 0x2e)    // ucomisd
                 break;
-            }
 
-            case 0x3c:  // cmpb imm8,al
-            {
-                UInt8 imm = inLine->info.code[opcodeIndex + 1];
+            localAddy = (uint32_t)ops->disp;
+            theDummyPtr = [self getPointer:localAddy type:NULL];
 
-                // Check for a single printable 7-bit char.
-                if (imm >= 0x20 && imm < 0x7f)
-                    snprintf(iLineCommentCString, 4, "'%c'", imm);
+            if (theDummyPtr)
+            {
+                UInt64  theInt64    = *(UInt64*)theDummyPtr;
 
-                break;
+                theInt64    = OSSwapLittleToHostInt64(theInt64);
+                snprintf(iLineCommentCString, 30, "%lG", *(double*)&theInt64);
             }
 
-            case 0x66:
-                if (inLine->info.code[opcodeIndex + 1] != 0x0f ||
-                    inLine->info.code[opcodeIndex + 2] != 0x2e)    // ucomisd
-                    break;
-
-                localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 4];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
-                theDummyPtr = [self getPointer:localAddy type:NULL];
-
-                if (theDummyPtr)
-                {
-                    UInt64  theInt64    = *(UInt64*)theDummyPtr;
-
-                    theInt64    = OSSwapLittleToHostInt64(theInt64);
-                    snprintf(iLineCommentCString, 30, "%lG", *(double*)&theInt64);
-                }
+            break;
 
+        case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: 
+        case 0x76: case 0x77: case 0x78: case 0x79: case 0x7a: case 0x7b: 
+        case 0x7c: case 0x7d: case 0x7e: case 0xe3: // jcc
+        case 0xeb:  // jmp
+        {   // FIXME: this doesn't recognize tail calls.
+            if (!inLine->next)
                 break;
 
-            case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: 
-            case 0x76: case 0x77: case 0x78: case 0x79: case 0x7a: case 0x7b: 
-            case 0x7c: case 0x7d: case 0x7e: case 0xe3: // jcc
-            case 0xeb:  // jmp
-            {   // FIXME: this doesn't recognize tail calls.
-                if (!inLine->next)
-                    break;
-
-                SInt8 simm = (SInt8)inLine->info.code[opcodeIndex + 1];
-
-                targetAddy = inLine->next->info.address + simm;
+            targetAddy = inLine->next->info.address + (SInt8)ops->imm;
 
-                // Search current Function64Info for blocks that start at this address.
-                Function64Info* funcInfo = &iFuncInfos[iCurrentFuncInfoIndex];
+            // Search current Function64Info for blocks that start at this address.
+            Function64Info* funcInfo = &iFuncInfos[iCurrentFuncInfoIndex];
 
-                if (!funcInfo->blocks)
-                    break;
+            Block64Info*    targetBlock = [self findBlockAtAddress: targetAddy
+                inFunction: funcInfo];
 
-                uint32_t  i;
+            if (targetBlock && targetBlock->isEpilog)
+                snprintf(iLineCommentCString, 8, "return;");
 
-                for (i = 0; i < funcInfo->numBlocks; i++)
-                {
-                    if (funcInfo->blocks[i].beginAddress != targetAddy)
-                        continue;
-
-                    if (funcInfo->blocks[i].isEpilog)
-                        snprintf(iLineCommentCString, 8, "return;");
+            break;
+        }
 
-                    break;
-                }
+        // immediate group 1 - add, sub, cmp etc
+        case 0x80:  // imm8,r8
+        case 0x83:  // imm8,r32
+        {
+            modRM = ops->modRM;
 
+            // In immediate group 1 we only want cmpb
+            if (OPEXT(modRM) != 7)
                 break;
-            }
 
-            // immediate group 1 - add, sub, cmp etc
-            case 0x80:  // imm8,r8
-            case 0x83:  // imm8,r32
+            if (HAS_ABS_DISP32(modRM)) // RIP-relative addressing
+                localAddy = inLine->next->info.address + ops->disp;
+            else
             {
-                modRM = inLine->info.code[opcodeIndex + 1];
-
-                // In immediate group 1 we only want cmpb
-                if (OPEXT(modRM) != 7)
-                    break;
-
-                UInt8 immOffset = opcodeIndex + 2;
-
-                if (HAS_ABS_DISP32(modRM)) // RIP-relative addressing
-                {
-                    UInt64 baseAddress = inLine->next->info.address;
-                    uint32_t offset = *(uint32_t*)&inLine->info.code[immOffset];
-                    offset = OSSwapLittleToHostInt32(offset);
-                    localAddy = baseAddress + offset;
-                }
-                else
-                {
-                    if (HAS_DISP8(modRM))
-                        immOffset += 1;
-
-                    if (HAS_SIB(modRM))
-                        immOffset += 1;
-
-                    if (HAS_REL_DISP32(modRM) || HAS_ABS_DISP32(modRM))
-                        immOffset += 4;
+                UInt8 imm = (UInt8)ops->imm;
 
-                    UInt8 imm = inLine->info.code[immOffset];
+                // Check for a single printable 7-bit char.
+                if (imm >= 0x20 && imm < 0x7f)
+                    snprintf(iLineCommentCString, 4, "'%c'", imm);
+            }
 
-                    // Check for a single printable 7-bit char.
-                    if (imm >= 0x20 && imm < 0x7f)
-                        snprintf(iLineCommentCString, 4, "'%c'", imm);
-                }
+            break;
+        }
 
+        case 0x2b:  // subl r/m32,r32
+        case 0x3b:  // cmpl r/m32,r32
+        case 0x81:  // immediate group 1 - imm32,r32
+        case 0x88:  // movb r8,r/m8
+        case 0x89:  // movl r32,r/m32
+        case 0x8b:  // movl r/m32,r32
+        case 0xc6:  // movb imm8,r/m32
+            modRM = ops->modRM;
+
+            // In immediate group 1 we only want cmpl
+            if (opcode == 0x81 && OPEXT(modRM) != 7)
                 break;
+
+            if (HAS_ABS_DISP32(modRM)) // RIP-relative addressing
+                localAddy = inLine->next->info.address + ops->disp;
+            else if (MOD(modRM) == MODimm)   // 1st addressing mode
+            {
+                if (RM(modRM) == DISP32)
+                    localAddy = (uint32_t)ops->disp;
             }
+            else
+            {
+                if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to class
+                {
+                    if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
+                        break;
 
-            case 0x2b:  // subl r/m32,r32
-            case 0x3b:  // cmpl r/m32,r32
-            case 0x81:  // immediate group 1 - imm32,r32
-            case 0x88:  // movb r8,r/m8
-            case 0x89:  // movl r32,r/m32
-            case 0x8b:  // movl r/m32,r32
-            case 0xc6:  // movb imm8,r/m32
-                modRM = inLine->info.code[opcodeIndex + 1];
-
-                // In immediate group 1 we only want cmpl
-                if (opcode == 0x81 && OPEXT(modRM) != 7)
-                    break;
+                    // Ignore the 4th addressing mode
+                    if (MOD(modRM) == MODx)
+                        break;
 
-                if (HAS_ABS_DISP32(modRM)) // RIP-relative addressing
-                {
-                    UInt64 baseAddress = inLine->next->info.address;
-                    uint32_t offset = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
+                    objc2_64_ivar_t* theIvar = NULL;
+                    objc2_64_class_t swappedClass =
+                        *iRegInfos[XREG2(modRM, rexByte)].classPtr;
 
-                    offset = OSSwapLittleToHostInt32(offset);
-                    localAddy = baseAddress + offset;
-                }
-                else if (MOD(modRM) == MODimm)   // 1st addressing mode
-                {
-                    if (RM(modRM) == DISP32)
-                    {
-                        localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
-                        localAddy = OSSwapLittleToHostInt32(localAddy);
-                    }
-                }
-                else
-                {
-                    if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to class
-                    {
-                        if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
-                            break;
+                    #if __BIG_ENDIAN__
+                        swap_objc_class((objc_class *)&swappedClass);
+                    #endif
 
-                        // Ignore the 4th addressing mode
-                        if (MOD(modRM) == MODx)
+                    if (!iIsInstanceMethod)
+                    {
+                        if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
                             break;
 
-                        objc2_64_ivar_t* theIvar = NULL;
-                        objc2_64_class_t swappedClass =
-                            *iRegInfos[XREG2(modRM, rexByte)].classPtr;
-
                         #if __BIG_ENDIAN__
                             swap_objc_class((objc_class *)&swappedClass);
                         #endif
+                    }
 
-                        if (!iIsInstanceMethod)
-                        {
-                            if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
-                                break;
-
-                            #if __BIG_ENDIAN__
-                                swap_objc_class((objc_class *)&swappedClass);
-                            #endif
-                        }
-
-                        if (MOD(modRM) == MOD8)
-                        {
-                            UInt8 theSymOffset = inLine->info.code[opcodeIndex + 2];
-
-                            if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                                break;
-                        }
-                        else if (MOD(modRM) == MOD32)
-                        {
-                            uint32_t theSymOffset = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
-
-                            theSymOffset = OSSwapLittleToHostInt32(theSymOffset);
-
-                            if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                                break;
-                        }
-
-                        if (theIvar)
-                            theSymPtr = [self getPointer:theIvar->name type:NULL];
-
-                        if (theSymPtr)
-                        {
-                            if (iOpts.variableTypes)
-                            {
-                                char theTypeCString[MAX_TYPE_STRING_LENGTH];
-
-                                theTypeCString[0]   = 0;
-
-                                [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
-                                snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
-                            }
-                            else
-                                snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
-                        }
+                    if (MOD(modRM) == MOD8)
+                    {
+                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(UInt8)ops->disp])
+                            break;
                     }
-                    else if (MOD(modRM) == MOD32)   // absolute address
+                    else if (MOD(modRM) == MOD32)
                     {
-                        if (HAS_SIB(modRM))
+                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(uint32_t)ops->disp])
                             break;
+                    }
 
-                        if (XREG2(modRM, rexByte) == iCurrentThunk &&
-                            iRegInfos[iCurrentThunk].isValid)
+                    if (theIvar)
+                        theSymPtr = [self getPointer:theIvar->name type:NULL];
+
+                    if (theSymPtr)
+                    {
+                        if (iOpts.variableTypes)
                         {
-                            uint32_t imm = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
+                            char theTypeCString[MAX_TYPE_STRING_LENGTH];
+
+                            theTypeCString[0]   = 0;
 
-                            imm = OSSwapLittleToHostInt32(imm);
-                            localAddy = iRegInfos[iCurrentThunk].value + imm;
+                            [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
+                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
                         }
                         else
-                        {
-                            localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
-                            localAddy = OSSwapLittleToHostInt32(localAddy);
-                        }
+                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
                     }
                 }
+                else if (MOD(modRM) == MOD32)   // absolute address
+                {
+                    if (HAS_SIB(modRM))
+                        break;
 
-                break;
+                    if (XREG2(modRM, rexByte) == iCurrentThunk &&
+                        iRegInfos[iCurrentThunk].isValid)
+                    {
+                        localAddy = iRegInfos[iCurrentThunk].value + (uint32_t)ops->disp;
+                    }
+                    else
+                        localAddy = (uint32_t)ops->disp;
+                }
+            }
 
-            case 0x8d:  // leal
-            {
-                int32_t offset = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
+            break;
+
+        case 0x8d:  // leal
+        {
+            int32_t offset = (int32_t)ops->disp;
 
-                modRM = inLine->info.code[opcodeIndex + 1];
-                offset = OSSwapLittleToHostInt32(offset);
+            modRM = ops->modRM;
+
+            if (HAS_ABS_DISP32(modRM)) // RIP-relative addressing
+            {
+                UInt64 baseAddress = inLine->next->info.address;
+                localAddy = baseAddress + offset;
+                objc2_64_ivar_t* ivar;
 
-                if (HAS_ABS_DISP32(modRM)) // RIP-relative addressing
+                if ([self findIvar:&ivar inClass:iCurrentClass withOffset:localAddy])
                 {
-                    UInt64 baseAddress = inLine->next->info.address;
-                    localAddy = baseAddress + offset;
-                    objc2_64_ivar_t* ivar;
+                    theSymPtr = [self getPointer:ivar->name type:NULL];
 
-                    if ([self findIvar:&ivar inClass:iCurrentClass withOffset:localAddy])
+                    if (theSymPtr)
                     {
-                        theSymPtr = [self getPointer:ivar->name type:NULL];
-
-                        if (theSymPtr)
+                        if (iOpts.variableTypes)
                         {
-                            if (iOpts.variableTypes)
-                            {
-                                char theTypeCString[MAX_TYPE_STRING_LENGTH] = "";
+                            char theTypeCString[MAX_TYPE_STRING_LENGTH] = "";
 
-                                [self getDescription:theTypeCString forType:[self getPointer:ivar->type type:NULL]];
-                                snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
-                            }
-                            else
-                                snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
+                            [self getDescription:theTypeCString forType:[self getPointer:ivar->type type:NULL]];
+                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
                         }
+                        else
+                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
                     }
                 }
-                else
-                    localAddy = offset;
-
-                break;
             }
+            else
+                localAddy = offset;
 
-            case 0xa1:  // movl moffs32,r32
-            case 0xa3:  // movl r32,moffs32
-                localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 1];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
-                break;
-
-            case 0xb0:  // movb imm8,%al
-            case 0xb1:  // movb imm8,%cl
-            case 0xb2:  // movb imm8,%dl
-            case 0xb3:  // movb imm8,%bl
-            case 0xb4:  // movb imm8,%ah
-            case 0xb5:  // movb imm8,%ch
-            case 0xb6:  // movb imm8,%dh
-            case 0xb7:  // movb imm8,%bh
-            {
-                UInt8 imm = inLine->info.code[opcodeIndex + 1];
+            break;
+        }
 
-                // Check for a single printable 7-bit char.
-                if (imm >= 0x20 && imm < 0x7f)
-                    snprintf(iLineCommentCString, 4, "'%c'", imm);
+        case 0xa1:  // movl moffs32,r32
+        case 0xa3:  // movl r32,moffs32
+            localAddy = (UInt64)ops->disp;
+            break;
 
-                break;
-            }
+        case 0xb0:  // movb imm8,%al
+        case 0xb1:  // movb imm8,%cl
+        case 0xb2:  // movb imm8,%dl
+        case 0xb3:  // movb imm8,%bl
+        case 0xb4:  // movb imm8,%ah
+        case 0xb5:  // movb imm8,%ch
+        case 0xb6:  // movb imm8,%dh
+        case 0xb7:  // movb imm8,%bh
+        {
+            UInt8 imm = (UInt8)ops->imm;
 
-            case 0xb8:  // movl imm32,%eax
-            case 0xb9:  // movl imm32,%ecx
-            case 0xba:  // movl imm32,%edx
-            case 0xbb:  // movl imm32,%ebx
-            case 0xbc:  // movl imm32,%esp
-            case 0xbd:  // movl imm32,%ebp
-            case 0xbe:  // movl imm32,%esi
-            case 0xbf:  // movl imm32,%edi
-                localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 1];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
+            // Check for a single printable 7-bit char.
+            if (imm >= 0x20 && imm < 0x7f)
+                snprintf(iLineCommentCString, 4, "'%c'", imm);
 
-                // Check for a four char code.
-                if (localAddy >= 0x20202020 && localAddy < 0x7f7f7f7f)
-                {
-                    char*   fcc = (char*)&localAddy;
+            break;
+        }
 
-                    if (fcc[0] >= 0x20 && fcc[0] < 0x7f &&
-                        fcc[1] >= 0x20 && fcc[1] < 0x7f &&
-                        fcc[2] >= 0x20 && fcc[2] < 0x7f &&
-                        fcc[3] >= 0x20 && fcc[3] < 0x7f)
-                    {
-                        #if __LITTLE_ENDIAN__   // reversed on purpose
-                            localAddy   = OSSwapInt64(localAddy);
-                        #endif
+        case 0xb8:  // movl imm32,%eax
+        case 0xb9:  // movl imm32,%ecx
+        case 0xba:  // movl imm32,%edx
+        case 0xbb:  // movl imm32,%ebx
+        case 0xbc:  // movl imm32,%esp
+        case 0xbd:  // movl imm32,%ebp
+        case 0xbe:  // movl imm32,%esi
+        case 0xbf:  // movl imm32,%edi
+            localAddy = (uint32_t)ops->imm;
+
+            // Check for a four char code.
+            if (localAddy >= 0x20202020 && localAddy < 0x7f7f7f7f)
+            {
+                char*   fcc = (char*)&localAddy;
 
-                        snprintf(iLineCommentCString,
-                            7, "'%.4s'", fcc);
-                    }
-                }
-                else    // Check for a single printable 7-bit char.
-                if (localAddy >= 0x20 && localAddy < 0x7f)
+                if (fcc[0] >= 0x20 && fcc[0] < 0x7f &&
+                    fcc[1] >= 0x20 && fcc[1] < 0x7f &&
+                    fcc[2] >= 0x20 && fcc[2] < 0x7f &&
+                    fcc[3] >= 0x20 && fcc[3] < 0x7f)
                 {
-                    snprintf(iLineCommentCString, 4, "'%c'", (char)localAddy);
+                    #if __LITTLE_ENDIAN__   // reversed on purpose
+                        localAddy   = OSSwapInt64(localAddy);
+                    #endif
+
+                    snprintf(iLineCommentCString,
+                        7, "'%.4s'", fcc);
                 }
+            }
+            else    // Check for a single printable 7-bit char.
+            if (localAddy >= 0x20 && localAddy < 0x7f)
+            {
+                snprintf(iLineCommentCString, 4, "'%c'", (char)localAddy);
+            }
 
-                break;
+            break;
 
-            case 0xc7:  // movl imm32,r/m32
-            {
-                modRM = inLine->info.code[opcodeIndex + 1];
+        case 0xc7:  // movl imm32,r/m32
+        {
+            modRM = ops->modRM;
 
-                if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to class
-                {
-                    if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
-                        break;
+            if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to class
+            {
+                if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
+                    break;
 
-                    // Ignore the 1st and 4th addressing modes
-                    if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
-                        break;
+                // Ignore the 1st and 4th addressing modes
+                if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
+                    break;
 
-                    UInt8   immOffset   = opcodeIndex + 2;
-                    char    fcc[7]      = {0};
+                char    fcc[7]      = {0};
 
-                    if (HAS_DISP8(modRM))
-                        immOffset   += 1;
-                    else if (HAS_REL_DISP32(modRM))
-                        immOffset   += 4;
+                objc2_64_ivar_t* theIvar = NULL;
+                objc2_64_class_t swappedClass =
+                    *iRegInfos[XREG2(modRM, rexByte)].classPtr;
 
-                    if (HAS_SIB(modRM))
-                        immOffset   += 1;
+                #if __BIG_ENDIAN__
+                    swap_objc_class((objc_class *)&swappedClass);
+                #endif
 
-                    objc2_64_ivar_t* theIvar = NULL;
-                    objc2_64_class_t swappedClass =
-                        *iRegInfos[XREG2(modRM, rexByte)].classPtr;
+                if (!iIsInstanceMethod)
+                {
+                    if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
+                        break;
 
                     #if __BIG_ENDIAN__
                         swap_objc_class((objc_class *)&swappedClass);
                     #endif
+                }
 
-                    if (!iIsInstanceMethod)
-                    {
-                        if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
-                            break;
-
-                        #if __BIG_ENDIAN__
-                            swap_objc_class((objc_class *)&swappedClass);
-                        #endif
-                    }
-
-                    if (MOD(modRM) == MOD8)
-                    {
-                        // offset precedes immediate value, subtract
-                        UInt8 theSymOffset = inLine->info.code[immOffset - 1];
+                if (MOD(modRM) == MOD8)
+                {
+                    if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(UInt8)ops->disp])
+                        break;
+                }
+                else if (MOD(modRM) == MOD32)
+                {
+                    uint32_t imm = (uint32_t)ops->imm;
+                    uint32_t theSymOffset = (uint32_t)ops->disp;
 
-                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                            break;
-                    }
-                    else if (MOD(modRM) == MOD32)
+                    // Check for a four char code.
+                    if (imm >= 0x20202020 && imm < 0x7f7f7f7f)
                     {
-                        uint32_t imm = *(uint32_t*)&inLine->info.code[immOffset];
-                        uint32_t theSymOffset = *(uint32_t*)&inLine->info.code[immOffset - 4];
-
-                        imm = OSSwapLittleToHostInt32(imm);
-                        theSymOffset = OSSwapLittleToHostInt32(theSymOffset);
+                        char*   tempFCC = (char*)&imm;
 
-                        // Check for a four char code.
-                        if (imm >= 0x20202020 && imm < 0x7f7f7f7f)
+                        if (tempFCC[0] >= 0x20 && tempFCC[0] < 0x7f &&
+                            tempFCC[1] >= 0x20 && tempFCC[1] < 0x7f &&
+                            tempFCC[2] >= 0x20 && tempFCC[2] < 0x7f &&
+                            tempFCC[3] >= 0x20 && tempFCC[3] < 0x7f)
                         {
-                            char*   tempFCC = (char*)&imm;
-
-                            if (tempFCC[0] >= 0x20 && tempFCC[0] < 0x7f &&
-                                tempFCC[1] >= 0x20 && tempFCC[1] < 0x7f &&
-                                tempFCC[2] >= 0x20 && tempFCC[2] < 0x7f &&
-                                tempFCC[3] >= 0x20 && tempFCC[3] < 0x7f)
-                            {
-                                #if __LITTLE_ENDIAN__   // reversed on purpose
-                                    imm = OSSwapInt32(imm);
-                                #endif
+                            #if __LITTLE_ENDIAN__   // reversed on purpose
+                                imm = OSSwapInt32(imm);
+                            #endif
 
-                                snprintf(fcc, 7, "'%.4s'", tempFCC);
-                            }
+                            snprintf(fcc, 7, "'%.4s'", tempFCC);
                         }
-                        else    // Check for a single printable 7-bit char.
-                        if (imm >= 0x20 && imm < 0x7f)
-                        {
-                            snprintf(fcc, 4, "'%c'", imm);
-                        }
-
-                        [self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset];
+                    }
+                    else    // Check for a single printable 7-bit char.
+                    if (imm >= 0x20 && imm < 0x7f)
+                    {
+                        snprintf(fcc, 4, "'%c'", imm);
                     }
 
-                    if (theIvar != NULL)
-                        theSymPtr = [self getPointer:theIvar->name type:NULL];
-
-                    char tempComment[MAX_COMMENT_LENGTH];
+                    [self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset];
+                }
 
-                    tempComment[0]  = 0;
+                if (theIvar != NULL)
+                    theSymPtr = [self getPointer:theIvar->name type:NULL];
 
-                    // copy four char code and/or var name to comment.
-                    if (fcc[0])
-                        strncpy(tempComment, fcc, strlen(fcc) + 1);
+                char tempComment[MAX_COMMENT_LENGTH];
 
-                    if (theSymPtr)
-                    {
-                        if (fcc[0])
-                            strncat(tempComment, " ", 2);
+                tempComment[0]  = 0;
 
-                        size_t  tempCommentLength   = strlen(tempComment);
+                // copy four char code and/or var name to comment.
+                if (fcc[0])
+                    strncpy(tempComment, fcc, strlen(fcc) + 1);
 
-                        if (iOpts.variableTypes)
-                        {
-                            char    theTypeCString[MAX_TYPE_STRING_LENGTH];
+                if (theSymPtr)
+                {
+                    if (fcc[0])
+                        strncat(tempComment, " ", 2);
 
-                            theTypeCString[0]   = 0;
+                    size_t  tempCommentLength   = strlen(tempComment);
 
-                            [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
-                            snprintf(&tempComment[tempCommentLength], MAX_COMMENT_LENGTH - tempCommentLength - 1,
-                                "(%s)%s", theTypeCString, theSymPtr);
-                        }
-                        else
-                            strncat(tempComment, theSymPtr,
-                                MAX_COMMENT_LENGTH - tempCommentLength - 1);
-                    }
+                    if (iOpts.variableTypes)
+                    {
+                        char    theTypeCString[MAX_TYPE_STRING_LENGTH];
 
-                    if (tempComment[0])
-                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", tempComment);
+                        theTypeCString[0]   = 0;
 
+                        [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
+                        snprintf(&tempComment[tempCommentLength], MAX_COMMENT_LENGTH - tempCommentLength - 1,
+                            "(%s)%s", theTypeCString, theSymPtr);
+                    }
+                    else
+                        strncat(tempComment, theSymPtr,
+                            MAX_COMMENT_LENGTH - tempCommentLength - 1);
                 }
-                else    // absolute address
-                {
-                    UInt8 immOffset = opcodeIndex + 2;
 
-                    if (HAS_DISP8(modRM))
-                        immOffset += 1;
+                if (tempComment[0])
+                    snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", tempComment);
 
-                    if (HAS_SIB(modRM))
-                        immOffset += 1;
+            }
+            else    // absolute address
+            {
+                localAddy = (uint32_t)ops->imm;
 
-                    localAddy = *(uint32_t*)&inLine->info.code[immOffset];
-                    localAddy = OSSwapLittleToHostInt32(localAddy);
+                // Check for a four char code.
+                if (localAddy >= 0x20202020 && localAddy < 0x7f7f7f7f)
+                {
+                    char*   fcc = (char*)&localAddy;
 
-                    // Check for a four char code.
-                    if (localAddy >= 0x20202020 && localAddy < 0x7f7f7f7f)
+                    if (fcc[0] >= 0x20 && fcc[0] < 0x7f &&
+                        fcc[1] >= 0x20 && fcc[1] < 0x7f &&
+                        fcc[2] >= 0x20 && fcc[2] < 0x7f &&
+                        fcc[3] >= 0x20 && fcc[3] < 0x7f)
                     {
-                        char*   fcc = (char*)&localAddy;
-
-                        if (fcc[0] >= 0x20 && fcc[0] < 0x7f &&
-                            fcc[1] >= 0x20 && fcc[1] < 0x7f &&
-                            fcc[2] >= 0x20 && fcc[2] < 0x7f &&
-                            fcc[3] >= 0x20 && fcc[3] < 0x7f)
-                        {
-                            #if __LITTLE_ENDIAN__   // reversed on purpose
-                                localAddy   = OSSwapInt64(localAddy);
-                            #endif
+                        #if __LITTLE_ENDIAN__   // reversed on purpose
+                            localAddy   = OSSwapInt64(localAddy);
+                        #endif
 
-                            snprintf(iLineCommentCString,
-                                7, "'%.4s'", fcc);
-                        }
+                        snprintf(iLineCommentCString,
+                            7, "'%.4s'", fcc);
                     }
-                    else    // Check for a single printable 7-bit char.
-                    if (localAddy >= 0x20 && localAddy < 0x7f)
-                        snprintf(iLineCommentCString, 4, "'%c'", (char)localAddy);
                 }
-
-                break;
+                else    // Check for a single printable 7-bit char.
+                if (localAddy >= 0x20 && localAddy < 0x7f)
+                    snprintf(iLineCommentCString, 4, "'%c'", (char)localAddy);
             }
 
-            case 0xcd:  // int
-                modRM = inLine->info.code[opcodeIndex + 1];
+            break;
+        }
 
-                if (modRM == 0x80)
-                    [self commentForSystemCall];
+        case 0xcd:  // int
+            if ((UInt8)ops->imm == 0x80)
+                [self commentForSystemCall];
 
-                break;
+            break;
 
-            case 0xd9:  // fldsl    r/m32
-            case 0xdd:  // fldll    
-                modRM = inLine->info.code[opcodeIndex + 1];
+        case 0xd9:  // fldsl    r/m32
+        case 0xdd:  // fldll    
+            modRM = ops->modRM;
 
-                if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to class
-                {
-                    if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
-                        break;
+            if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to class
+            {
+                if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
+                    break;
 
-                    // Ignore the 1st and 4th addressing modes
-                    if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
-                        break;
+                // Ignore the 1st and 4th addressing modes
+                if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
+                    break;
 
-                    objc2_64_ivar_t* theIvar = NULL;
-                    objc2_64_class_t swappedClass =
-                        *iRegInfos[XREG2(modRM, rexByte)].classPtr;
+                objc2_64_ivar_t* theIvar = NULL;
+                objc2_64_class_t swappedClass =
+                    *iRegInfos[XREG2(modRM, rexByte)].classPtr;
+
+                #if __BIG_ENDIAN__
+                    swap_objc_class((objc_class *)&swappedClass);
+                #endif
+
+                if (!iIsInstanceMethod)
+                {
+                    if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
+                        break;
 
                     #if __BIG_ENDIAN__
                         swap_objc_class((objc_class *)&swappedClass);
                     #endif
+                }
 
-                    if (!iIsInstanceMethod)
-                    {
-                        if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
-                            break;
-
-                        #if __BIG_ENDIAN__
-                            swap_objc_class((objc_class *)&swappedClass);
-                        #endif
-                    }
+                if (MOD(modRM) == MOD8)
+                {
+                    if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(UInt8)ops->disp])
+                        break;
+                }
+                else if (MOD(modRM) == MOD32)
+                {
+                    if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(uint32_t)ops->disp])
+                        break;
+                }
 
-                    if (MOD(modRM) == MOD8)
-                    {
-                        UInt8 theSymOffset = inLine->info.code[opcodeIndex + 2];
+                if (theIvar)
+                    theSymPtr = [self getPointer:theIvar->name type:NULL];
 
-                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                            break;
-                    }
-                    else if (MOD(modRM) == MOD32)
+                if (theSymPtr)
+                {
+                    if (iOpts.variableTypes)
                     {
-                        uint32_t theSymOffset = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
+                        char theTypeCString[MAX_TYPE_STRING_LENGTH];
 
-                        theSymOffset = OSSwapLittleToHostInt32(theSymOffset);
+                        theTypeCString[0]   = 0;
 
-                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                            break;
+                        [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
                     }
+                    else
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
+                }
+            }
+            else    // absolute address
+            {
+                localAddy = (uint32_t)ops->disp;
+                theDummyPtr = [self getPointer:localAddy type:NULL];
 
-                    if (theIvar)
-                        theSymPtr = [self getPointer:theIvar->name type:NULL];
+                if (!theDummyPtr)
+                    break;
 
-                    if (theSymPtr)
-                    {
-                        if (iOpts.variableTypes)
-                        {
-                            char theTypeCString[MAX_TYPE_STRING_LENGTH];
+                if (LO(opcode) == 0x9)  // fldsl
+                {
+                    uint32_t  theInt32    = *(uint32_t*)theDummyPtr;
 
-                            theTypeCString[0]   = 0;
+                    theInt32    = OSSwapLittleToHostInt32(theInt32);
 
-                            [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
-                        }
-                        else
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
-                    }
+                    // dance around printf's type coersion
+                    snprintf(iLineCommentCString,
+                        30, "%G", *(float*)&theInt32);
                 }
-                else    // absolute address
+                else if (LO(opcode) == 0xd) // fldll
                 {
-                    UInt8 immOffset = opcodeIndex + 2;
-
-                    if (HAS_DISP8(modRM))
-                        immOffset += 1;
-
-                    if (HAS_SIB(modRM))
-                        immOffset += 1;
-
-                    localAddy = *(uint32_t*)&inLine->info.code[immOffset];
-                    localAddy = OSSwapLittleToHostInt32(localAddy);
-                    theDummyPtr = [self getPointer:localAddy type:NULL];
-
-                    if (!theDummyPtr)
-                        break;
-
-                    if (LO(opcode) == 0x9)  // fldsl
-                    {
-                        uint32_t  theInt32    = *(uint32_t*)theDummyPtr;
-
-                        theInt32    = OSSwapLittleToHostInt32(theInt32);
-
-                        // dance around printf's type coersion
-                        snprintf(iLineCommentCString,
-                            30, "%G", *(float*)&theInt32);
-                    }
-                    else if (LO(opcode) == 0xd) // fldll
-                    {
-                        UInt64  theInt64    = *(UInt64*)theDummyPtr;
+                    UInt64  theInt64    = *(UInt64*)theDummyPtr;
 
-                        theInt64    = OSSwapLittleToHostInt64(theInt64);
+                    theInt64    = OSSwapLittleToHostInt64(theInt64);
 
-                        // dance around printf's type coersion
-                        snprintf(iLineCommentCString,
-                            30, "%lG", *(double*)&theInt64);
-                    }
+                    // dance around printf's type coersion
+                    snprintf(iLineCommentCString,
+                        30, "%lG", *(double*)&theInt64);
                 }
+            }
 
-                break;
-
-            case 0xe8:  // call
-            case 0xe9:  // jmp
-            {
-                // Insert anonymous label if there's not a label yet.
-                if (iLineCommentCString[0])
-                    break;
+            break;
 
-                uint32_t immAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 1];
+        case 0xe8:  // call
+        case 0xe9:  // jmp
+        {
+            // Insert anonymous label if there's not a label yet.
+            if (iLineCommentCString[0])
+                break;
 
-                immAddy = OSSwapLittleToHostInt32(immAddy);
+            UInt64 absoluteAddy =
+                inLine->info.address + ops->length + (SInt32)ops->imm;
 
-                UInt64 absoluteAddy = (inLine->info.address + 5) + (SInt32)immAddy;
+// FIXME: can we use mCurrentFuncInfoIndex here?
+            Function64Info searchKey = {absoluteAddy, NULL, 0, 0};
+            Function64Info* funcInfo = bsearch(&searchKey,
+                iFuncInfos, iNumFuncInfos, sizeof(Function64Info),
+                (COMPARISON_FUNC_TYPE)Function_Info_Compare);
 
-    // FIXME: can we use mCurrentFuncInfoIndex here?
-                Function64Info searchKey = {absoluteAddy, NULL, 0, 0};
-                Function64Info* funcInfo = bsearch(&searchKey,
-                    iFuncInfos, iNumFuncInfos, sizeof(Function64Info),
-                    (COMPARISON_FUNC_TYPE)Function_Info_Compare);
+            if (funcInfo && funcInfo->genericFuncNum != 0)
+                snprintf(iLineCommentCString,
+                    ANON_FUNC_BASE_LENGTH + 11, "%s%d",
+                    ANON_FUNC_BASE, funcInfo->genericFuncNum);
 
-                if (funcInfo && funcInfo->genericFuncNum != 0)
-                    snprintf(iLineCommentCString,
-                        ANON_FUNC_BASE_LENGTH + 11, "%s%d",
-                        ANON_FUNC_BASE, funcInfo->genericFuncNum);
+            break;
+        }
 
+        case 0xf2:  // repne/repnz or movsd, mulsd etc
+        case 0xf3:  // rep/repe or movss, mulss etc
+        {
+            if (ops->nextOpcode != 0x0f)  // movsd/s, divsd/s, addsd/s etc
                 break;
-            }
 
-            case 0xf2:  // repne/repnz or movsd, mulsd etc
-            case 0xf3:  // rep/repe or movss, mulss etc
+            modRM = ops->modRM;
+
+            if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to self
             {
-                UInt8 byte2 = inLine->info.code[opcodeIndex + 1];
+                if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
+                    break;
 
-                if (byte2 != 0x0f)  // movsd/s, divsd/s, addsd/s etc
+                // Ignore the 1st and 4th addressing modes
+                if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
                     break;
 
-                modRM = inLine->info.code[opcodeIndex + 3];
+                objc2_64_ivar_t* theIvar = NULL;
+                objc2_64_class_t swappedClass =
+                    *iRegInfos[XREG2(modRM, rexByte)].classPtr;
 
-                if (iRegInfos[XREG2(modRM, rexByte)].classPtr)    // address relative to self
-                {
-                    if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
-                        break;
+                #if __BIG_ENDIAN__
+                    swap_objc_class((objc_class *)&swappedClass);
+                #endif
 
-                    // Ignore the 1st and 4th addressing modes
-                    if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
+                if (!iIsInstanceMethod)
+                {
+                    if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
                         break;
 
-                    objc2_64_ivar_t* theIvar = NULL;
-                    objc2_64_class_t swappedClass =
-                        *iRegInfos[XREG2(modRM, rexByte)].classPtr;
-
                     #if __BIG_ENDIAN__
                         swap_objc_class((objc_class *)&swappedClass);
                     #endif
+                }
 
-                    if (!iIsInstanceMethod)
-                    {
-                        if (![self getObjcMetaClass:&swappedClass fromClass:&swappedClass])
-                            break;
-
-                        #if __BIG_ENDIAN__
-                            swap_objc_class((objc_class *)&swappedClass);
-                        #endif
-                    }
+                if (MOD(modRM) == MOD8)
+                {
+                    if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(UInt8)ops->disp])
+                        break;
+                }
+                else if (MOD(modRM) == MOD32)
+                {
+                    if (![self findIvar:&theIvar inClass:&swappedClass withOffset:(uint32_t)ops->disp])
+                        break;
+                }
 
-                    if (MOD(modRM) == MOD8)
-                    {
-                        UInt8 theSymOffset = inLine->info.code[opcodeIndex + 4];
+                if (theIvar)
+                    theSymPtr = [self getPointer:theIvar->name type:NULL];
 
-                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                            break;
-                    }
-                    else if (MOD(modRM) == MOD32)
+                if (theSymPtr)
+                {
+                    if (iOpts.variableTypes)
                     {
-                        uint32_t theSymOffset = *(uint32_t*)&inLine->info.code[opcodeIndex + 4];
+                        char theTypeCString[MAX_TYPE_STRING_LENGTH];
 
-                        theSymOffset = OSSwapLittleToHostInt32(theSymOffset);
+                        theTypeCString[0]   = 0;
 
-                        if (![self findIvar:&theIvar inClass:&swappedClass withOffset:theSymOffset])
-                            break;
+                        [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
                     }
+                    else
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
+                }
+            }
+            else    // absolute address
+            {
+                localAddy = (uint32_t)ops->disp;
+                theDummyPtr = [self getPointer:localAddy type:NULL];
 
-                    if (theIvar)
-                        theSymPtr = [self getPointer:theIvar->name type:NULL];
-
-                    if (theSymPtr)
+                if (theDummyPtr)
+                {
+                    if (LO(opcode) == 0x3)
                     {
-                        if (iOpts.variableTypes)
-                        {
-                            char theTypeCString[MAX_TYPE_STRING_LENGTH];
-
-                            theTypeCString[0]   = 0;
+                        uint32_t  theInt32    = *(uint32_t*)theDummyPtr;
 
-                            [self getDescription:theTypeCString forType:[self getPointer:theIvar->type type:NULL]];
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "(%s)%s", theTypeCString, theSymPtr);
-                        }
-                        else
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "%s", theSymPtr);
+                        theInt32    = OSSwapLittleToHostInt32(theInt32);
+                        snprintf(iLineCommentCString,
+                            30, "%G", *(float*)&theInt32);
                     }
-                }
-                else    // absolute address
-                {
-                    localAddy = *(uint32_t*)&inLine->info.code[opcodeIndex + 4];
-                    localAddy = OSSwapLittleToHostInt32(localAddy);
-                    theDummyPtr = [self getPointer:localAddy type:NULL];
-
-                    if (theDummyPtr)
+                    else if (LO(opcode) == 0x2)
                     {
-                        if (LO(opcode) == 0x3)
-                        {
-                            uint32_t  theInt32    = *(uint32_t*)theDummyPtr;
-
-                            theInt32    = OSSwapLittleToHostInt32(theInt32);
-                            snprintf(iLineCommentCString,
-                                30, "%G", *(float*)&theInt32);
-                        }
-                        else if (LO(opcode) == 0x2)
-                        {
-                            UInt64  theInt64    = *(UInt64*)theDummyPtr;
+                        UInt64  theInt64    = *(UInt64*)theDummyPtr;
 
-                            theInt64    = OSSwapLittleToHostInt64(theInt64);
-                            snprintf(iLineCommentCString,
-                                30, "%lG", *(double*)&theInt64);
-                        }
+                        theInt64    = OSSwapLittleToHostInt64(theInt64);
+                        snprintf(iLineCommentCString,
+                            30, "%lG", *(double*)&theInt64);
                     }
                 }
-
-                break;
             }
 
-            case 0xff:  // call, jmp
-            {
-                modRM = inLine->info.code[opcodeIndex + 1];
+            break;
+        }
 
-                if (MOD(modRM) == MODx &&
-                    (REG1(modRM) == 2 || REG1(modRM) == 4)) // call/jump through pointer (absolute/register indirect)
+        case 0xff:  // call, jmp
+        {
+            modRM = ops->modRM;
+
+            if (MOD(modRM) == MODx &&
+                (REG1(modRM) == 2 || REG1(modRM) == 4)) // call/jump through pointer (absolute/register indirect)
+            {
+                if (iRegInfos[XREG2(modRM, rexByte)].messageRefSel != NULL)
                 {
-                    if (iRegInfos[XREG2(modRM, rexByte)].messageRefSel != NULL)
-                    {
-                        char* sel = iRegInfos[XREG2(modRM, rexByte)].messageRefSel;
+                    char* sel = iRegInfos[XREG2(modRM, rexByte)].messageRefSel;
 
-                        if (iRegInfos[EDI].className != NULL)
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "+[%s %s]", iRegInfos[EDI].className, sel);
-                        else
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "-[%%rdi %s]", sel);
-                    }
+                    if (iRegInfos[EDI].className != NULL)
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "+[%s %s]", iRegInfos[EDI].className, sel);
+                    else
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "-[%%rdi %s]", sel);
                 }
-                else if (MOD(modRM) == MODimm && REG2(modRM) == EBP)    // call/jmp through RIP-relative pointer
+            }
+            else if (MOD(modRM) == MODimm && REG2(modRM) == EBP)    // call/jmp through RIP-relative pointer
+            {
+                if (iRegInfos[ESI].messageRefSel != NULL)
                 {
-                    if (iRegInfos[ESI].messageRefSel != NULL)
-                    {
-                        char* sel = iRegInfos[ESI].messageRefSel;
+                    char* sel = iRegInfos[ESI].messageRefSel;
 
-                        if (iRegInfos[EDI].className != NULL)
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "+[%s %s]", iRegInfos[EDI].className, sel);
-                        else
-                            snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "-[%%rdi %s]", sel);
-                    }
+                    if (iRegInfos[EDI].className != NULL)
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "+[%s %s]", iRegInfos[EDI].className, sel);
+                    else
+                        snprintf(iLineCommentCString, MAX_COMMENT_LENGTH, "-[%%rdi %s]", sel);
                 }
-
-                break;
             }
 
-            default:
-                break;
-        }   // switch (opcode)
+            break;
+        }
 
-        break;
-    }   // while (1)
+        default:
+            break;
+    }   // switch (opcode)
 
     if (!iLineCommentCString[0])
     {
@@ -1341,6 +1255,10 @@
         }
         
         iMatchedSelectorCount++;
+        [self addXref: selString kind: XrefSelector
+            site: inLine->info.address function: iCurrentFunctionStart];
+
+        iLineSelector   = selString;
 
         UInt8   sendType    = [self sendTypeFromMsgSend:ioComment];
 
@@ -1414,6 +1332,8 @@
             }
         }
 
+        iLineClassName  = className;
+
         if (className)
         {
             snprintf(ioComment, MAX_COMMENT_LENGTH,
@@ -1505,17 +1425,19 @@
 
     if (theCode == 0xe8 || theCode == 0xe9 || theCode == 0xff || theCode == 0x9a)
     {
-        Line64* theNewLine  = malloc(sizeof(Line64));
-
-        memcpy(theNewLine, (*ioLine)->alt, sizeof(Line64));
-        theNewLine->chars   = malloc(theNewLine->length + 1);
-        strncpy(theNewLine->chars, (*ioLine)->alt->chars,
-            theNewLine->length + 1);
-
-        // Swap in the verbose line and free the previous verbose lines.
-        [self deleteLinesBefore:(*ioLine)->alt fromList:&iVerboseLineListHead];
-        [self replaceLine:*ioLine withLine:theNewLine inList:&iPlainLineListHead];
-        *ioLine = theNewLine;
+        // Take the verbose line's text. The Line itself stays put, so other
+        // threads can safely walk the list while we do this.
+        free((*ioLine)->chars);
+        (*ioLine)->chars        = (*ioLine)->alt->chars;
+        (*ioLine)->length       = (*ioLine)->alt->length;
+        (*ioLine)->alt->chars   = NULL;
+        (*ioLine)->alt->length  = 0;
+
+        // Free the verbose lines before this one. Worker threads leave that
+        // to processLinesInParallel, see newWorker.
+        if (iVerboseLineListHead && (*ioLine)->alt != iVerboseLineListHead)
+            [self deleteLinesBefore: (*ioLine)->alt
+                fromList: &iVerboseLineListHead];
     }
 }
 
@@ -1556,22 +1478,15 @@
     }
     else if (iThunks)   // otool didn't spot it, maybe we did earlier...
     {
-        uint32_t i;
-        size_t target;
+        ThunkInfo*  theThunk    = [self findThunkAtAddress:
+            strtoul(iLineOperandsCString, NULL, 16)];
 
-        for (i = 0; i < iNumThunks; i++)
+        if (theThunk)
         {
-            target = strtoul(iLineOperandsCString, NULL, 16);
-
-            if (target == iThunks[i].address)
-            {
-                iCurrentThunk = iThunks[i].reg;
-
-                iRegInfos[iCurrentThunk].value =  (*ioLine)->next->info.address;
-                iRegInfos[iCurrentThunk].isValid = YES;
+            iCurrentThunk = theThunk->reg;
 
-                return;
-            }
+            iRegInfos[iCurrentThunk].value =  (*ioLine)->next->info.address;
+            iRegInfos[iCurrentThunk].isValid = YES;
         }
     }
 }
@@ -1638,393 +1553,364 @@
     iHighestJumpTarget = 0;
 }
 
-//  updateRegisters:
-// ----------------------------------------------------------------------------
+//  updateRegisters:
+// ----------------------------------------------------------------------------
+
+- (void)updateRegisters: (Line64*)inLine;
+{
+    X86Operands* ops = [self operandsForLine:inLine];
+    UInt8 opcode = ops->opcode;
+    UInt8 modRM;
+    UInt8 rexByte = ops->rex;
+
+    // Most instructions leave the tracked registers alone.
+    if (!(ops->flags & OPF_REGS))
+        return;
+
+    switch (opcode)
+    {
+        // pop stack into thunk registers.
+        case 0x58:  // eax
+        case 0x59:  // ecx
+        case 0x5a:  // edx
+        case 0x5b:  // ebx
+            if (inLine->prev &&
+                (inLine->prev->info.code[0] == 0xe8) &&
+                (*(uint32_t*)&inLine->prev->info.code[1] == 0))
+            {
+                iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
+                iRegInfos[XREG2(opcode, rexByte)].value   = inLine->info.address;
+                iRegInfos[XREG2(opcode, rexByte)].isValid = YES;
+                iCurrentThunk = XREG2(opcode, rexByte);
+            }
+
+            break;
 
-- (void)updateRegisters: (Line64*)inLine;
-{
-    UInt8 opcode = inLine->info.code[0];;
-    UInt8 modRM;
-    UInt8 opcodeIndex = 0;
-    UInt8 rexByte = 0;
+        // pop stack into non-thunk registers. Wipe em.
+        case 0x5c:  // esp
+        case 0x5d:  // ebp
+        case 0x5e:  // esi
+        case 0x5f:  // edi
+            iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
+            break;
 
-    while (1)
-    {
-        switch (opcode)
+        // immediate group 1
+        // add, or, adc, sbb, and, sub, xor, cmp
+        case 0x83:  // EXTS(imm8),r32
         {
-            case 0x40: case 0x41: case 0x42: case 0x43:
-            case 0x44: case 0x45: case 0x46: case 0x47:
-            case 0x48: case 0x49: case 0x4a: case 0x4b:
-            case 0x4c: case 0x4d: case 0x4e: case 0x4f:
-                // Save the REX bits and continue.
-                rexByte = opcode;
-                opcodeIndex++;
-                opcode = inLine->info.code[opcodeIndex];
-                continue;
-
-            // pop stack into thunk registers.
-            case 0x58:  // eax
-            case 0x59:  // ecx
-            case 0x5a:  // edx
-            case 0x5b:  // ebx
-                if (inLine->prev &&
-                    (inLine->prev->info.code[0] == 0xe8) &&
-                    (*(uint32_t*)&inLine->prev->info.code[1] == 0))
-                {
-                    iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
-                    iRegInfos[XREG2(opcode, rexByte)].value   = inLine->info.address;
-                    iRegInfos[XREG2(opcode, rexByte)].isValid = YES;
-                    iCurrentThunk = XREG2(opcode, rexByte);
-                }
+            modRM = ops->modRM;
 
+            if (!iRegInfos[XREG1(modRM, rexByte)].isValid)
                 break;
 
-            // pop stack into non-thunk registers. Wipe em.
-            case 0x5c:  // esp
-            case 0x5d:  // ebp
-            case 0x5e:  // esi
-            case 0x5f:  // edi
-                iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
-                break;
+            SInt32 imm = (SInt32)ops->imm;
 
-            // immediate group 1
-            // add, or, adc, sbb, and, sub, xor, cmp
-            case 0x83:  // EXTS(imm8),r32
+            switch (OPEXT(modRM))
             {
-                modRM = inLine->info.code[opcodeIndex + 1];
+                case 0: // add
+                    iRegInfos[XREG1(modRM, rexByte)].value += imm;
+                    iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
 
-                if (!iRegInfos[XREG1(modRM, rexByte)].isValid)
                     break;
 
-                UInt8 imm = inLine->info.code[opcodeIndex + 2];
+                case 1: // or
+                    iRegInfos[XREG1(modRM, rexByte)].value |= imm;
+                    iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
 
-                switch (OPEXT(modRM))
-                {
-                    case 0: // add
-                        iRegInfos[XREG1(modRM, rexByte)].value += (SInt32)imm;
-                        iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
+                    break;
 
-                        break;
+                case 4: // and
+                    iRegInfos[XREG1(modRM, rexByte)].value &= imm;
+                    iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
 
-                    case 1: // or
-                        iRegInfos[XREG1(modRM, rexByte)].value |= (SInt32)imm;
-                        iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
+                    break;
 
-                        break;
+                case 5: // sub
+                    iRegInfos[XREG1(modRM, rexByte)].value -= imm;
+                    iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
 
-                    case 4: // and
-                        iRegInfos[XREG1(modRM, rexByte)].value &= (SInt32)imm;
-                        iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
+                    break;
 
-                        break;
+                case 6: // xor
+                    iRegInfos[XREG1(modRM, rexByte)].value ^= imm;
+                    iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
 
-                    case 5: // sub
-                        iRegInfos[XREG1(modRM, rexByte)].value -= (SInt32)imm;
-                        iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
+                    break;
 
-                        break;
+                default:
+                    break;
+            }   // switch (OPEXT(modRM))
 
-                    case 6: // xor
-                        iRegInfos[XREG1(modRM, rexByte)].value ^= (SInt32)imm;
-                        iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
+            break;
+        }
 
-                        break;
+        case 0x89:  // mov reg to r/m
+        {
+            modRM = ops->modRM;
 
-                    default:
-                        break;
-                }   // switch (OPEXT(modRM))
+            if (MOD(modRM) == MODx) // reg to reg
+            {
+                if (!iRegInfos[XREG1(modRM, rexByte)].isValid)
+                    iRegInfos[XREG2(modRM, rexByte)]  = (GP64RegisterInfo){0};
+                else
+                    memcpy(&iRegInfos[XREG2(modRM, rexByte)], &iRegInfos[XREG1(modRM, rexByte)],
+                        sizeof(GP64RegisterInfo));
 
                 break;
             }
 
-            case 0x89:  // mov reg to r/m
-            {
-                modRM = inLine->info.code[opcodeIndex + 1];
-
-                if (MOD(modRM) == MODx) // reg to reg
-                {
-                    if (!iRegInfos[XREG1(modRM, rexByte)].isValid)
-                        iRegInfos[XREG2(modRM, rexByte)]  = (GP64RegisterInfo){0};
-                    else
-                        memcpy(&iRegInfos[XREG2(modRM, rexByte)], &iRegInfos[XREG1(modRM, rexByte)],
-                            sizeof(GP64RegisterInfo));
-
-                    break;
-                }
+            if ((XREG2(modRM, rexByte) != EBP && !HAS_SIB(modRM)))
+                break;
 
-                if ((XREG2(modRM, rexByte) != EBP && !HAS_SIB(modRM)))
-                    break;
+            SInt8 offset = 0;
 
-                SInt8 offset = 0;
+            if (HAS_SIB(modRM)) // pushing an arg onto stack
+            {
+                if (HAS_DISP8(modRM))
+                    offset = (SInt8)ops->disp;
 
-                if (HAS_SIB(modRM)) // pushing an arg onto stack
+                if (offset >= 0)
                 {
-                    if (HAS_DISP8(modRM))
-                        offset = (SInt8)inLine->info.code[opcodeIndex + 3];
-
-                    if (offset >= 0)
+                    if (offset / 4 > MAX_STACK_SIZE - 1)
                     {
-                        if (offset / 4 > MAX_STACK_SIZE - 1)
-                        {
-                            fprintf(stderr, "otx: out of stack bounds: "
-                                "stack size needs to be %d\n", (offset / 4) + 1);
-                            break;
-                        }
+                        fprintf(stderr, "otx: out of stack bounds: "
+                            "stack size needs to be %d\n", (offset / 4) + 1);
+                        break;
+                    }
 
-                        // Convert offset to array index.
-                        offset /= 4;
+                    // Convert offset to array index.
+                    offset /= 4;
 
-                        if (iRegInfos[XREG1(modRM, rexByte)].isValid)
-                            iStack[offset] = iRegInfos[XREG1(modRM, rexByte)];
-                        else
-                            iStack[offset] = (GP64RegisterInfo){0};
-                    }
+                    if (iRegInfos[XREG1(modRM, rexByte)].isValid)
+                        iStack[offset] = iRegInfos[XREG1(modRM, rexByte)];
+                    else
+                        iStack[offset] = (GP64RegisterInfo){0};
                 }
-                else    // Copying from a register to a local var.
+            }
+            else    // Copying from a register to a local var.
+            {
+                if (iRegInfos[XREG1(modRM, rexByte)].classPtr && MOD(modRM) == MOD8)
                 {
-                    if (iRegInfos[XREG1(modRM, rexByte)].classPtr && MOD(modRM) == MOD8)
-                    {
-                        offset = inLine->info.code[opcodeIndex + 2];
-                        iNumLocalSelves++;
-                        iLocalSelves = realloc(iLocalSelves,
-                            iNumLocalSelves * sizeof(Var64Info));
-                        iLocalSelves[iNumLocalSelves - 1]   = (Var64Info)
-                            {iRegInfos[XREG1(modRM, rexByte)], offset};
-                    }
-                    else if (iRegInfos[XREG1(modRM, rexByte)].isValid && MOD(modRM) == MOD32)
-                    {
-                        SInt32 varOffset = *(SInt32*)&inLine->info.code[opcodeIndex + 2];
-
-                        varOffset = OSSwapLittleToHostInt32(varOffset);
-                        iNumLocalVars++;
-                        iLocalVars  = realloc(iLocalVars,
-                            iNumLocalVars * sizeof(Var64Info));
-                        iLocalVars[iNumLocalVars - 1]   = (Var64Info)
-                            {iRegInfos[XREG1(modRM, rexByte)], varOffset};
-                    }
+                    offset = (SInt8)ops->disp;
+                    iNumLocalSelves++;
+                    iLocalSelves = realloc(iLocalSelves,
+                        iNumLocalSelves * sizeof(Var64Info));
+                    iLocalSelves[iNumLocalSelves - 1]   = (Var64Info)
+                        {iRegInfos[XREG1(modRM, rexByte)], offset};
                 }
+                else if (iRegInfos[XREG1(modRM, rexByte)].isValid && MOD(modRM) == MOD32)
+                {
+                    SInt32 varOffset = (SInt32)ops->disp;
 
-                break;
+                    iNumLocalVars++;
+                    iLocalVars  = realloc(iLocalVars,
+                        iNumLocalVars * sizeof(Var64Info));
+                    iLocalVars[iNumLocalVars - 1]   = (Var64Info)
+                        {iRegInfos[XREG1(modRM, rexByte)], varOffset};
+                }
             }
 
-            case 0x8b:  // mov mem to reg
-            case 0x8d:  // lea mem to reg
-                modRM = inLine->info.code[opcodeIndex + 1];
-                iRegInfos[XREG1(modRM, rexByte)].value = 0;
-                iRegInfos[XREG1(modRM, rexByte)].isValid = NO;
-                iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
-                iRegInfos[XREG1(modRM, rexByte)].className = NULL;
-                iRegInfos[XREG1(modRM, rexByte)].messageRefSel = iRegInfos[XREG2(modRM, rexByte)].messageRefSel;
+            break;
+        }
+
+        case 0x8b:  // mov mem to reg
+        case 0x8d:  // lea mem to reg
+            modRM = ops->modRM;
+            iRegInfos[XREG1(modRM, rexByte)].value = 0;
+            iRegInfos[XREG1(modRM, rexByte)].isValid = NO;
+            iRegInfos[XREG1(modRM, rexByte)].classPtr = NULL;
+            iRegInfos[XREG1(modRM, rexByte)].className = NULL;
+            iRegInfos[XREG1(modRM, rexByte)].messageRefSel = iRegInfos[XREG2(modRM, rexByte)].messageRefSel;
 
-                if (MOD(modRM) == MODimm)
+            if (MOD(modRM) == MODimm)
+            {
+                if (XREG2(modRM, rexByte) == EBP) // RIP-relative addressing
                 {
-                    if (XREG2(modRM, rexByte) == EBP) // RIP-relative addressing
-                    {
-                        uint32_t offset = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
+                    UInt64 ripTarget = inLine->next->info.address + ops->disp;
+                    UInt8 type = PointerType;
 
-                        offset = OSSwapLittleToHostInt32(offset);
+                    iRegInfos[XREG1(modRM, rexByte)].value = ripTarget;
 
-                        UInt64 baseAddress = inLine->next->info.address;
-                        UInt8 type = PointerType;
+                    char* name = [self getPointer:ripTarget type:&type];
 
-                        iRegInfos[XREG1(modRM, rexByte)].value = baseAddress + (SInt32)offset;
-
-                        char* name = [self getPointer:baseAddress + (SInt32)offset type:&type];
+                    if (name)
+                    {
+                        if (type == OCClassRefType)
+                            iRegInfos[XREG1(modRM, rexByte)].className = name;
+                        else if (type == OCMsgRefType || type == OCSelRefType)
+                            iRegInfos[XREG1(modRM, rexByte)].messageRefSel = name;
+                    }
 
-                        if (name)
-                        {
-                            if (type == OCClassRefType)
-                                iRegInfos[XREG1(modRM, rexByte)].className = name;
-                            else if (type == OCMsgRefType || type == OCSelRefType)
-                                iRegInfos[XREG1(modRM, rexByte)].messageRefSel = name;
-                        }
+                    iRegInfos[XREG1(modRM, rexByte)].isValid = YES;
+                }
+            }
+            else if (MOD(modRM) == MOD8)
+            {
+                SInt8 offset = (SInt8)ops->disp;
 
-                        iRegInfos[XREG1(modRM, rexByte)].isValid = YES;
-                    }
+                if (XREG2(modRM, rexByte) == EBP && offset == 0x8)
+                {   // Copying self from 1st arg to a register.
+                    iRegInfos[XREG1(modRM, rexByte)].classPtr = iCurrentClass;
+                    iRegInfos[XREG1(modRM, rexByte)].isValid  = YES;
                 }
-                else if (MOD(modRM) == MOD8)
-                {
-                    SInt8 offset = (SInt8)inLine->info.code[opcodeIndex + 2];
+                else
+                {   // Check for copied self pointer.
+                    // Zero the destination regardless.
+                    iRegInfos[XREG1(modRM, rexByte)]  = (GP64RegisterInfo){0};
 
-                    if (XREG2(modRM, rexByte) == EBP && offset == 0x8)
-                    {   // Copying self from 1st arg to a register.
-                        iRegInfos[XREG1(modRM, rexByte)].classPtr = iCurrentClass;
-                        iRegInfos[XREG1(modRM, rexByte)].isValid  = YES;
-                    }
-                    else
-                    {   // Check for copied self pointer.
-                        // Zero the destination regardless.
-                        iRegInfos[XREG1(modRM, rexByte)]  = (GP64RegisterInfo){0};
+                    if (iLocalSelves &&
+                        XREG2(modRM, rexByte) == EBP  &&
+                        offset < 0)
+                    {
+                        uint32_t  i;
 
-                        if (iLocalSelves &&
-                            XREG2(modRM, rexByte) == EBP  &&
-                            offset < 0)
+                        // If we're accessing a local var copy of self,
+                        // copy that info back to the reg in question.
+                        for (i = 0; i < iNumLocalSelves; i++)
                         {
-                            uint32_t  i;
-
-                            // If we're accessing a local var copy of self,
-                            // copy that info back to the reg in question.
-                            for (i = 0; i < iNumLocalSelves; i++)
-                            {
-                                if (iLocalSelves[i].offset != offset)
-                                    continue;
+                            if (iLocalSelves[i].offset != offset)
+                                continue;
 
-                                iRegInfos[XREG1(modRM, rexByte)]  = iLocalSelves[i].regInfo;
+                            iRegInfos[XREG1(modRM, rexByte)]  = iLocalSelves[i].regInfo;
 
-                                break;
-                            }
+                            break;
                         }
                     }
                 }
-                else if (XREG2(modRM, rexByte) == EBP && MOD(modRM) == MOD32)
+            }
+            else if (XREG2(modRM, rexByte) == EBP && MOD(modRM) == MOD32)
+            {
+                // Zero the destination regardless.
+                iRegInfos[XREG1(modRM, rexByte)]  = (GP64RegisterInfo){0};
+
+                if (iLocalVars)
                 {
-                    // Zero the destination regardless.
-                    iRegInfos[XREG1(modRM, rexByte)]  = (GP64RegisterInfo){0};
+                    SInt32 offset = (SInt32)ops->disp;
 
-                    if (iLocalVars)
+                    if (offset < 0)
                     {
-                        SInt32 offset = *(SInt32*)&inLine->info.code[opcodeIndex + 2];
+                        uint32_t  i;
 
-                        offset = OSSwapLittleToHostInt32(offset);
-
-                        if (offset < 0)
+                        for (i = 0; i < iNumLocalVars; i++)
                         {
-                            uint32_t  i;
-
-                            for (i = 0; i < iNumLocalVars; i++)
-                            {
-                                if (iLocalVars[i].offset != offset)
-                                    continue;
+                            if (iLocalVars[i].offset != offset)
+                                continue;
 
-                                iRegInfos[XREG1(modRM, rexByte)]  = iLocalVars[i].regInfo;
+                            iRegInfos[XREG1(modRM, rexByte)]  = iLocalVars[i].regInfo;
 
-                                break;
-                            }
+                            break;
                         }
                     }
                 }
-                else if (HAS_ABS_DISP32(modRM))
-                {
-                    // FIXME check this logic
-                    uint32_t newValue = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
-
-                    iRegInfos[XREG1(modRM, rexByte)].value = OSSwapLittleToHostInt32(newValue);
-                    iRegInfos[XREG1(modRM, rexByte)].isValid = YES;
-                }
-                else if (HAS_REL_DISP32(modRM))
-                {
-                    if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
-                        break;
+            }
+            else if (HAS_ABS_DISP32(modRM))
+            {
+                // FIXME check this logic
+                iRegInfos[XREG1(modRM, rexByte)].value = (uint32_t)ops->disp;
+                iRegInfos[XREG1(modRM, rexByte)].isValid = YES;
+            }
+            else if (HAS_REL_DISP32(modRM))
+            {
+                if (!iRegInfos[XREG2(modRM, rexByte)].isValid)
+                    break;
 
-                    uint32_t newValue = *(uint32_t*)&inLine->info.code[opcodeIndex + 2];
+                iRegInfos[XREG1(modRM, rexByte)].value = (uint32_t)ops->disp;
+                iRegInfos[XREG1(modRM, rexByte)].value += iRegInfos[XREG2(modRM, rexByte)].value;
+                iRegInfos[XREG1(modRM, rexByte)].isValid = YES;
+            }
 
-                    iRegInfos[XREG1(modRM, rexByte)].value = OSSwapLittleToHostInt32(newValue);
-                    iRegInfos[XREG1(modRM, rexByte)].value += iRegInfos[XREG2(modRM, rexByte)].value;
-                    iRegInfos[XREG1(modRM, rexByte)].isValid = YES;
-                }
+            break;
 
-                break;
+        case 0xb0:  // movb imm8,%al
+        case 0xb1:  // movb imm8,%cl
+        case 0xb2:  // movb imm8,%dl
+        case 0xb3:  // movb imm8,%bl
+        case 0xb4:  // movb imm8,%ah
+        case 0xb5:  // movb imm8,%ch
+        case 0xb6:  // movb imm8,%dh
+        case 0xb7:  // movb imm8,%bh
+        {
+            iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
 
-            case 0xb0:  // movb imm8,%al
-            case 0xb1:  // movb imm8,%cl
-            case 0xb2:  // movb imm8,%dl
-            case 0xb3:  // movb imm8,%bl
-            case 0xb4:  // movb imm8,%ah
-            case 0xb5:  // movb imm8,%ch
-            case 0xb6:  // movb imm8,%dh
-            case 0xb7:  // movb imm8,%bh
-            {
-                iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
+            iRegInfos[XREG2(opcode, rexByte)].value = (UInt8)ops->imm;
+            iRegInfos[XREG2(opcode, rexByte)].isValid = YES;
 
-                UInt8 imm = inLine->info.code[opcodeIndex + 1];
+            break;
+        }
 
-                iRegInfos[XREG2(opcode, rexByte)].value = imm;
-                iRegInfos[XREG2(opcode, rexByte)].isValid = YES;
+        case 0xa1:  // movl moffs32,%eax
+        {
+            iRegInfos[EAX] = (GP64RegisterInfo){0};
 
-                break;
-            }
+            iRegInfos[EAX].value = (UInt64)ops->disp;
+            iRegInfos[EAX].isValid = YES;
 
-            case 0xa1:  // movl moffs32,%eax
-            {
-                iRegInfos[EAX] = (GP64RegisterInfo){0};
+            break;
+        }
 
-                uint32_t newValue = *(uint32_t*)&inLine->info.code[opcodeIndex + 1];
+        case 0xb8:  // movl imm32,%eax
+        case 0xb9:  // movl imm32,%ecx
+        case 0xba:  // movl imm32,%edx
+        case 0xbb:  // movl imm32,%ebx
+        case 0xbc:  // movl imm32,%esp
+        case 0xbd:  // movl imm32,%ebp
+        case 0xbe:  // movl imm32,%esi
+        case 0xbf:  // movl imm32,%edi
+        {
+            iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
 
-                iRegInfos[EAX].value = OSSwapLittleToHostInt32(newValue);
-                iRegInfos[EAX].isValid = YES;
+            iRegInfos[XREG2(opcode, rexByte)].value = (uint32_t)ops->imm;
+            iRegInfos[XREG2(opcode, rexByte)].isValid = YES;
 
-                break;
-            }
+            break;
+        }
 
-            case 0xb8:  // movl imm32,%eax
-            case 0xb9:  // movl imm32,%ecx
-            case 0xba:  // movl imm32,%edx
-            case 0xbb:  // movl imm32,%ebx
-            case 0xbc:  // movl imm32,%esp
-            case 0xbd:  // movl imm32,%ebp
-            case 0xbe:  // movl imm32,%esi
-            case 0xbf:  // movl imm32,%edi
-            {
-                iRegInfos[XREG2(opcode, rexByte)] = (GP64RegisterInfo){0};
+        case 0xc7:  // movl imm32,r/m32
+        {
+            modRM = ops->modRM;
 
-                uint32_t newValue = *(uint32_t*)&inLine->info.code[opcodeIndex + 1];
+            if (!HAS_SIB(modRM))
+                break;
 
-                iRegInfos[XREG2(opcode, rexByte)].value = OSSwapLittleToHostInt32(newValue);
-                iRegInfos[XREG2(opcode, rexByte)].isValid = YES;
+            SInt8 offset = 0;
+            SInt32 value = 0;
 
-                break;
+            if (HAS_DISP8(modRM))
+            {
+                offset = (SInt8)ops->disp;
+                value = (SInt32)ops->imm;
             }
 
-            case 0xc7:  // movl imm32,r/m32
+            if (offset >= 0)
             {
-                modRM = inLine->info.code[opcodeIndex + 1];
-
-                if (!HAS_SIB(modRM))
-                    break;
-
-                SInt8 offset = 0;
-                SInt32 value = 0;
-
-                if (HAS_DISP8(modRM))
+                if (offset / 4 > MAX_STACK_SIZE - 1)
                 {
-                    offset = inLine->info.code[opcodeIndex + 3];
-                    value = *(uint32_t*)&inLine->info.code[opcodeIndex + 4];
-                    value = OSSwapLittleToHostInt32(value);
+                    fprintf(stderr, "otx: out of stack bounds: "
+                        "stack size needs to be %d\n", (offset / 4) + 1);
+                    break;
                 }
 
-                if (offset >= 0)
-                {
-                    if (offset / 4 > MAX_STACK_SIZE - 1)
-                    {
-                        fprintf(stderr, "otx: out of stack bounds: "
-                            "stack size needs to be %d\n", (offset / 4) + 1);
-                        break;
-                    }
-
-                    // Convert offset to array index.
-                    offset /= 4;
-
-                    iStack[offset]          = (GP64RegisterInfo){0};
-                    iStack[offset].value    = value;
-                    iStack[offset].isValid  = YES;
-                }
+                // Convert offset to array index.
+                offset /= 4;
 
-                break;
+                iStack[offset]          = (GP64RegisterInfo){0};
+                iStack[offset].value    = value;
+                iStack[offset].isValid  = YES;
             }
 
-            case 0xe8:  // callq
-            case 0xff:  // callq
-                    memset(iStack, 0, sizeof(GP64RegisterInfo) * MAX_STACK_SIZE);
-                    iRegInfos[EAX]  = (GP64RegisterInfo){0};
+            break;
+        }
 
-                break;
+        case 0xe8:  // callq
+        case 0xff:  // callq
+                memset(iStack, 0, sizeof(GP64RegisterInfo) * MAX_STACK_SIZE);
+                iRegInfos[EAX]  = (GP64RegisterInfo){0};
 
-            default:
-                break;
-        }   // switch (opcode)
+            break;
 
-        break;
-    }   // while (1)
+        default:
+            break;
+    }   // switch (opcode)
 }
 
 //  restoreRegisters:
@@ -2044,6 +1930,10 @@
     if (iCurrentFuncInfoIndex < 0)
         return NO;
 
+    // Only lines flagged by addBlockAtAddress:toFunction: can begin a block.
+    if (!inLine->info.startsBlock)
+        return NO;
+
     // Search current Function64Info for blocks that start at this address.
     Function64Info* funcInfo    =
         &iFuncInfos[iCurrentFuncInfoIndex];
@@ -2051,49 +1941,40 @@
     if (!funcInfo->blocks)
         return NO;
 
-    uint32_t  i;
-
-    for (i = 0; i < funcInfo->numBlocks; i++)
-    {
-        if (funcInfo->blocks[i].beginAddress != inLine->info.address)
-            continue;
+    Block64Info*    theBlock    = [self findBlockAtAddress: inLine->info.address
+        inFunction: funcInfo];
 
-        // Update machine state.
-        Machine64State  machState   = funcInfo->blocks[i].state;
+    if (!theBlock)
+        return NO;
 
-        memcpy(iRegInfos, machState.regInfos, sizeof(GP64RegisterInfo) * 16);
+    // Update machine state.
+    Machine64State  machState   = theBlock->state;
 
-        if (machState.localSelves)
-        {
-            if (iLocalSelves)
-                free(iLocalSelves);
-
-            iNumLocalSelves = machState.numLocalSelves;
-            iLocalSelves    = malloc(
-                sizeof(Var64Info) * machState.numLocalSelves);
-            memcpy(iLocalSelves, machState.localSelves,
-                sizeof(Var64Info) * machState.numLocalSelves);
-        }
+    memcpy(iRegInfos, machState.regInfos, sizeof(GP64RegisterInfo) * 16);
 
-        if (machState.localVars)
-        {
-            if (iLocalVars)
-                free(iLocalVars);
-
-            iNumLocalVars   = machState.numLocalVars;
-            iLocalVars      = malloc(
-                sizeof(Var64Info) * iNumLocalVars);
-            memcpy(iLocalVars, machState.localVars,
-                sizeof(Var64Info) * iNumLocalVars);
-        }
+    if (machState.localSelves)
+    {
+        // Reuse our buffers, they're usually big enough already.
+        iNumLocalSelves = machState.numLocalSelves;
+        iLocalSelves    = realloc(iLocalSelves,
+            sizeof(Var64Info) * iNumLocalSelves);
+        memcpy(iLocalSelves, machState.localSelves,
+            sizeof(Var64Info) * machState.numLocalSelves);
+    }
 
-        // Optionally add a blank line before this block.
-        if (iOpts.separateLogicalBlocks && inLine->chars[0] != '\n' &&
-            !inLine->info.isFunction)
-            needNewLine = YES;
+    if (machState.localVars)
+    {
+        iNumLocalVars   = machState.numLocalVars;
+        iLocalVars      = realloc(iLocalVars,
+            sizeof(Var64Info) * iNumLocalVars);
+        memcpy(iLocalVars, machState.localVars,
+            sizeof(Var64Info) * iNumLocalVars);
+    }
 
-        break;
-    }   // for (i = 0...)
+    // Optionally add a blank line before this block.
+    if (iOpts.separateLogicalBlocks && inLine->chars[0] != '\n' &&
+        !inLine->info.isFunction)
+        needNewLine = YES;
 
     return needNewLine;
 }
@@ -2109,30 +1990,18 @@
     if (inLine->info.isFunction)
         return YES;
 
-    UInt64 theAddy = inLine->info.address;
-
-    if (theAddy == iAddrDyldStubBindingHelper   ||
-        theAddy == iAddrDyldFuncLookupPointer)
-        return YES;
-
-    Method64Info* theDummyInfo    = NULL;
-
-    // In Obj-C apps, the majority of funcs will have Obj-C symbols, so check
-    // those first.
-    if ([self findClassMethod:&theDummyInfo byAddress:theAddy])
-        return YES;
-
-//    if ([self findCatMethod:&theDummyInfo byAddress:theAddy])
-//        return YES;
-
-    // If it's not an Obj-C method, maybe there's an nlist.
-    if ([self findSymbolByAddress:theAddy])
+    // dyld helpers, Obj-C methods and nlists.
+    if ([self isFunctionStart:inLine->info.address])
         return YES;
 
     // If otool gave us a function name, but it came from a dynamic symbol...
     if (inLine->prev && !inLine->prev->info.isCode)
         return YES;
 
+    // LC_FUNCTION_STARTS lists them all, no need to guess.
+    if (iFuncStartsSize)
+        return NO;
+
     // Obvious avenues expended, brute force check now.
     BOOL isFunction = NO;
     UInt8 opcode = inLine->info.code[0];
@@ -2310,17 +2179,110 @@
     return IS_JUMP(opcode, opcode2);
 }
 
-//  gatherFuncInfos
+//  codeIsCall:
+// ----------------------------------------------------------------------------
+
+- (BOOL)codeIsCall: (UInt8*)inCode
+{
+    UInt8 opcode = inCode[0];
+    UInt8 opcode2 = inCode[1];
+
+    // Skip a REX prefix, as in "callq *%r11".
+    if ((opcode & 0xf0) == 0x40 && opcode2 == 0xff)
+    {
+        opcode  = opcode2;
+        opcode2 = inCode[2];
+    }
+
+    return IS_CALL(opcode) ||
+        (opcode == 0xff && (OPEXT(opcode2) == 2 || OPEXT(opcode2) == 3));
+}
+
+//  getBranchInfo:forLine:
+// ----------------------------------------------------------------------------
+//  Return YES if inLine ends a basic block, and describe where control goes
+//  from there.
+
+- (BOOL)getBranchInfo: (Branch64Info*)outInfo
+              forLine: (Line64*)inLine
+{
+    UInt8   opcode  = inLine->info.code[0];
+    UInt8   opcode2 = inLine->info.code[1];
+    SInt32  rel32;
+
+    *outInfo    = (Branch64Info){0, NO, NO};
+
+    if ((opcode >= 0x70 && opcode <= 0x7f) || opcode == 0xe3)
+    {   // jcc rel8, jecxz
+        outInfo->target         = inLine->info.address + 2 + (SInt8)opcode2;
+        outInfo->hasTarget      = YES;
+        outInfo->fallsThrough   = YES;
+    }
+    else if (opcode == 0xeb)
+    {   // jmp rel8
+        outInfo->target     = inLine->info.address + 2 + (SInt8)opcode2;
+        outInfo->hasTarget  = YES;
+    }
+    else if (opcode == 0xe9)
+    {   // jmp rel32
+        rel32   = OSSwapLittleToHostInt32(*(SInt32*)&inLine->info.code[1]);
+        outInfo->target     = inLine->info.address + 5 + rel32;
+        outInfo->hasTarget  = YES;
+    }
+    else if (opcode == 0x0f && opcode2 >= 0x80 && opcode2 <= 0x8f)
+    {   // jcc rel32
+        rel32   = OSSwapLittleToHostInt32(*(SInt32*)&inLine->info.code[2]);
+        outInfo->target         = inLine->info.address + 6 + rel32;
+        outInfo->hasTarget      = YES;
+        outInfo->fallsThrough   = YES;
+    }
+    else if (opcode == 0xff && (OPEXT(opcode2) == 4 || OPEXT(opcode2) == 5))
+        ;   // indirect jmp
+    else if ((opcode & 0xf0) == 0x40 && opcode2 == 0xff &&
+        (OPEXT(inLine->info.code[2]) == 4 || OPEXT(inLine->info.code[2]) == 5))
+        ;   // indirect jmp with a REX prefix
+    else if (!IS_RET(opcode) && opcode != 0xc2 &&
+        !(opcode == 0xf3 && IS_RET(opcode2)))   // ret, ret imm16, rep ret
+        return NO;
+
+    return YES;
+}
+
+//  getCallTarget:forLine:
 // ----------------------------------------------------------------------------
+//  Return YES if inLine is a direct call, with the address it calls. Calls
+//  to the next instruction only push the PC.
 
-- (void)gatherFuncInfos
+- (BOOL)getCallTarget: (UInt64*)outTarget
+              forLine: (Line64*)inLine
 {
-    Line64*         theLine     = iPlainLineListHead;
+    if (inLine->info.code[0] != 0xe8)   // call rel32
+        return NO;
+
+    SInt32  rel32   = OSSwapLittleToHostInt32(*(SInt32*)&inLine->info.code[1]);
+
+    if (!rel32)
+        return NO;
+
+    *outTarget  = inLine->info.address + 5 + rel32;
+
+    return YES;
+}
+
+//  gatherFuncInfosFrom:to:
+// ----------------------------------------------------------------------------
+//  Gather block info for the lines from inStartLine up to, but not
+//  including, inEndLine. A NULL inEndLine means the end of the list.
+
+- (void)gatherFuncInfosFrom: (Line64*)inStartLine
+                         to: (Line64*)inEndLine
+{
+    Line64*         theLine     = inStartLine;
     UInt8           opcode, opcode2;
     uint32_t          progCounter = 0;
 
     // Loop thru lines.
-    while (theLine)
+    while (theLine && theLine != inEndLine)
     {
         if (!(progCounter % (PROGRESS_FREQ * 5)))
         {
@@ -2341,9 +2303,16 @@
         {
             iCurrentFuncPtr = theLine->info.address;
             [self resetRegisters:theLine];
+            iBlockVisits++;
         }
         else
         {
+            // Count every entry into a block for the -debug summary.
+            if (theLine->info.startsBlock && iCurrentFuncInfoIndex >= 0 &&
+                [self findBlockAtAddress: theLine->info.address
+                inFunction: &iFuncInfos[iCurrentFuncInfoIndex]])
+                iBlockVisits++;
+
             [self restoreRegisters:theLine];
             [self updateRegisters:theLine];
 
@@ -2405,20 +2374,11 @@
             Block64Info*    currentBlock    = NULL;
             Line64*     endLine         = NULL;
             BOOL        isEpilog        = NO;
-            uint32_t      i;
 
             if (funcInfo->blocks)
-            {   // Blocks exist, find 1st one matching this address.
-                // This is an exhaustive search, but the speed hit should
-                // only be an issue with extremely long functions.
-                for (i = 0; i < funcInfo->numBlocks; i++)
-                {
-                    if (funcInfo->blocks[i].beginAddress == jumpTarget)
-                    {
-                        currentBlock = &funcInfo->blocks[i];
-                        break;
-                    }
-                }
+            {   // Blocks exist, find the one matching this address.
+                currentBlock    = [self findBlockAtAddress: jumpTarget
+                    inFunction: funcInfo];
 
                 if (currentBlock)
                 {
@@ -2462,64 +2422,37 @@
                     }
                 }
                 else
-                {   // No matching blocks found, so allocate a new one.
-                    funcInfo->numBlocks++;
-                    funcInfo->blocks = realloc(funcInfo->blocks,
-                        sizeof(Block64Info) * funcInfo->numBlocks);
-                    currentBlock =
-                        &funcInfo->blocks[funcInfo->numBlocks - 1];
-                    *currentBlock = (Block64Info){0};
+                {   // No matching blocks found, so add a new one.
+                    currentBlock    = [self addBlockAtAddress: jumpTarget
+                        toFunction: funcInfo];
                 }
             }
             else
-            {   // No existing blocks, allocate one.
-                funcInfo->numBlocks++;
-                funcInfo->blocks    = calloc(1, sizeof(Block64Info));
-                currentBlock        = funcInfo->blocks;
+            {   // No existing blocks, add one.
+                currentBlock    = [self addBlockAtAddress: jumpTarget
+                    toFunction: funcInfo];
             }
 
             // sanity check
             if (!currentBlock)
             {
-                fprintf(stderr, "otx: [X8664Processor gatherFuncInfos] "
+                fprintf(stderr, "otx: [X8664Processor gatherFuncInfosFrom:to:] "
                     "currentBlock is NULL. Flame the dev.\n");
                 return;
             }
 
-            // Create a new Machine64State.
-            GP64RegisterInfo*   savedRegs   = malloc(sizeof(GP64RegisterInfo) * 16);
-
-            memcpy(savedRegs, iRegInfos, sizeof(GP64RegisterInfo) * 16);
-
-            Var64Info*  savedSelves = NULL;
-
-            if (iLocalSelves)
-            {
-                savedSelves = malloc(
-                    sizeof(Var64Info) * iNumLocalSelves);
-                memcpy(savedSelves, iLocalSelves,
-                    sizeof(Var64Info) * iNumLocalSelves);
-            }
-
-            Var64Info*  savedVars   = NULL;
-
-            if (iLocalVars)
-            {
-                savedVars   = malloc(
-                    sizeof(Var64Info) * iNumLocalVars);
-                memcpy(savedVars, iLocalVars,
-                    sizeof(Var64Info) * iNumLocalVars);
-            }
-
+            // Describe the current MachineState. updateBlock: copies it
+            // into the function's arena only if it's not already there.
             Machine64State  machState   =
-                {savedRegs, savedSelves, iNumLocalSelves,
-                    savedVars, iNumLocalVars};
+                {iRegInfos, iLocalSelves, iNumLocalSelves,
+                    iLocalVars, iNumLocalVars};
 
             // Store the new Block64Info.
             Block64Info blockInfo   =
                 {jumpTarget, endLine, isEpilog, machState};
 
-            memcpy(currentBlock, &blockInfo, sizeof(Block64Info));
+            [self updateBlock: currentBlock withInfo: &blockInfo
+                fromLine: theLine numRegs: 16];
 #else
     // At this point, the x86 logic departs from the PPC logic. We seem
     // to get better results by not reusing blocks.
@@ -56,6 +56,61 @@ enum {
 #define IS_CALL(o)  ((o) == 0xe8)
 #define IS_RET(o)   ((o) == 0xc3)
 
+// Operand forms and effects, indexed by opcode in gX86OpcodeTable.
+enum {
+    OPF_MODRM   = 1 << 0,   // mod r/m byte follows the opcode
+    OPF_IMM8    = 1 << 1,   // imm8 or rel8
+    OPF_IMM16   = 1 << 2,   // imm16
+    OPF_IMM32   = 1 << 3,   // imm32 or rel32
+    OPF_MOFFS   = 1 << 4,   // absolute address, 4 or 8 bytes
+    OPF_PREFIX  = 1 << 5,   // legacy prefix, handled as an opcode
+    OPF_ESCAPE  = 1 << 6,   // 0x0f, 2-byte opcode follows
+    OPF_REGS    = 1 << 7,   // updateRegisters: tracks its effect
+    OPF_NOTE    = 1 << 8    // commentForLine: may comment it
+};
+
+#define OPF_FORM_MASK   (OPF_MODRM | OPF_IMM8 | OPF_IMM16 | OPF_IMM32 | OPF_MOFFS)
+#define X86_CODE_BYTES  16  // sizeof(LineInfo.code)
+
+/*  X86Operands
+
+    An instruction decoded once from its machine code, shared by
+    updateRegisters: and commentForLine:. 'modRM' is always the byte that
+    follows the opcode, so the handlers can read it even for forms that
+    have none. A legacy prefix stays the 'opcode', with its own flags, so
+    the handlers still treat it as an opcode of its own. The instruction
+    it prefixes, as 'nextOpcode', fills in everything else.
+*/
+typedef struct
+{
+    UInt8   opcode;         // first byte after any REX prefixes
+    UInt8   nextOpcode;     // opcode after a legacy prefix, or 0
+    UInt8   opcode2;        // second byte of 0x0f opcodes
+    UInt8   opcodeIndex;    // offset of 'opcode' in the code
+    UInt8   rex;            // last REX prefix, x86_64 only
+    UInt8   modRM;
+    UInt8   sib;
+    BOOL    hasModRM;
+    BOOL    hasSIB;
+    UInt8   dispSize;       // 0, 1, 4 or 8 for moffs
+    UInt8   immSize;        // total size of immediate operands
+    UInt8   length;         // decoded length in bytes
+    UInt16  flags;          // OPF_*
+    SInt64  disp;           // sign-extended, or the moffs address
+    SInt64  imm;            // first immediate, sign-extended
+}
+X86Operands;
+
+//  X86DecodeOperands
+// ----------------------------------------------------------------------------
+//  Fill outOps from inCode, see X86Processor.m.
+
+void
+X86DecodeOperands(
+    const UInt8*    inCode,
+    BOOL            inLongMode,
+    X86Operands*    outOps);
+
 // ============================================================================
 
 @interface X86Processor : Exe32Processor<Deobfuscator>
@@ -67,6 +122,10 @@ enum {
     uint32_t    iNumLocalSelves;
     VarInfo*    iLocalVars;
     uint32_t    iNumLocalVars;
+
+    X86Operands iOperands;              // decoded from iOperandsLine
+    Line*       iOperandsLine;
+    uint32_t    iOperandsAddress;
 }
 
 - (void) printCurrentState: (uint32_t)currentAddress;
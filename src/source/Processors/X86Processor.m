@@ -26,6 +26,284 @@
 // For debugging -commentForLine:
 // #define COMMENT_FOR_LINE_DEBUG       0x1999d5
 
+#define _M      OPF_MODRM
+#define _I8     OPF_IMM8
+#define _I16    OPF_IMM16
+#define _I32    OPF_IMM32
+#define _MO     OPF_MOFFS
+#define _P      OPF_PREFIX
+#define _E      OPF_ESCAPE
+#define _R      OPF_REGS
+#define _N      OPF_NOTE
+
+// One-byte opcode map. See appendix A in the IA-32 manual, volume 2.
+static const UInt16 gX86OpcodeTable[256] =
+{
+    _M,             _M,             _M,             _M,             // 0x00
+    _I8,            _I32,           0,              0,              // 0x04
+    _M,             _M,             _M,             _M,             // 0x08
+    _I8,            _I32,           0,              _E|_N,          // 0x0c
+    _M,             _M,             _M,             _M,             // 0x10
+    _I8,            _I32,           0,              0,              // 0x14
+    _M,             _M,             _M,             _M,             // 0x18
+    _I8,            _I32,           0,              0,              // 0x1c
+    _M,             _M,             _M,             _M,             // 0x20
+    _I8,            _I32,           _P,             0,              // 0x24
+    _M,             _M,             _M,             _M|_N,          // 0x28
+    _I8,            _I32,           _P,             0,              // 0x2c
+    _M,             _M,             _M,             _M,             // 0x30
+    _I8,            _I32,           _P,             0,              // 0x34
+    _M,             _M,             _M,             _M|_N,          // 0x38
+    _I8|_N,         _I32,           _P,             0,              // 0x3c
+    0,              0,              0,              0,              // 0x40
+    0,              0,              0,              0,              // 0x44
+    0,              0,              0,              0,              // 0x48
+    0,              0,              0,              0,              // 0x4c
+    0,              0,              0,              0,              // 0x50
+    0,              0,              0,              0,              // 0x54
+    _R,             _R,             _R,             _R,             // 0x58
+    _R,             _R,             _R,             _R,             // 0x5c
+    0,              0,              _M,             _M,             // 0x60
+    _P,             _P,             _P|_N,          _P,             // 0x64
+    _I32,           _M|_I32,        _I8,            _M|_I8,         // 0x68
+    0,              0,              0,              0,              // 0x6c
+    _I8|_N,         _I8|_N,         _I8|_N,         _I8|_N,         // 0x70
+    _I8|_N,         _I8|_N,         _I8|_N,         _I8|_N,         // 0x74
+    _I8|_N,         _I8|_N,         _I8|_N,         _I8|_N,         // 0x78
+    _I8|_N,         _I8|_N,         _I8|_N,         _I8,            // 0x7c
+    _M|_I8|_N,      _M|_I32|_N,     _M|_I8,         _M|_I8|_R|_N,   // 0x80
+    _M,             _M,             _M,             _M,             // 0x84
+    _M|_N,          _M|_R|_N,       _M|_N,          _M|_R|_N,       // 0x88
+    _M,             _M|_R|_N,       _M,             _M,             // 0x8c
+    0,              0,              0,              0,              // 0x90
+    0,              0,              0,              0,              // 0x94
+    0,              0,              _I32|_I16,      0,              // 0x98
+    0,              0,              0,              0,              // 0x9c
+    _MO,            _MO|_R|_N,      _MO,            _MO|_N,         // 0xa0
+    0,              0,              0,              0,              // 0xa4
+    _I8,            _I32,           0,              0,              // 0xa8
+    0,              0,              0,              0,              // 0xac
+    _I8|_R|_N,      _I8|_R|_N,      _I8|_R|_N,      _I8|_R|_N,      // 0xb0
+    _I8|_R|_N,      _I8|_R|_N,      _I8|_R|_N,      _I8|_R|_N,      // 0xb4
+    _I32|_R|_N,     _I32|_R|_N,     _I32|_R|_N,     _I32|_R|_N,     // 0xb8
+    _I32|_R|_N,     _I32|_R|_N,     _I32|_R|_N,     _I32|_R|_N,     // 0xbc
+    _M|_I8,         _M|_I8,         _I16,           0,              // 0xc0
+    _M,             _M,             _M|_I8|_N,      _M|_I32|_R|_N,  // 0xc4
+    _I16|_I8,       0,              _I16,           0,              // 0xc8
+    0,              _I8|_N,         0,              0,              // 0xcc
+    _M,             _M,             _M,             _M,             // 0xd0
+    _I8,            _I8,            0,              0,              // 0xd4
+    _M,             _M|_N,          _M,             _M,             // 0xd8
+    _M,             _M|_N,          _M,             _M,             // 0xdc
+    _I8,            _I8,            _I8,            _I8|_N,         // 0xe0
+    _I8,            _I8,            _I8,            _I8,            // 0xe4
+    _I32|_R|_N,     _I32|_N,        _I32|_I16,      _I8|_N,         // 0xe8
+    0,              0,              0,              0,              // 0xec
+    _P,             0,              _P|_N,          _P|_N,          // 0xf0
+    0,              0,              _M|_N,          _M,             // 0xf4
+    0,              0,              0,              0,              // 0xf8
+    0,              0,              _M,             _M|_R|_N,       // 0xfc
+};
+
+#undef _M
+#undef _I8
+#undef _I16
+#undef _I32
+#undef _MO
+#undef _P
+#undef _E
+#undef _R
+#undef _N
+
+// ----------------------------------------------------------------------------
+// Decoding
+
+//  X86TwoByteForm
+// ----------------------------------------------------------------------------
+//  Operand form of the 0x0f opcode that ends in inOpcode.
+
+static UInt16
+X86TwoByteForm(
+    UInt8   inOpcode)
+{
+    if (inOpcode >= 0x80 && inOpcode <= 0x8f)   // jcc rel32
+        return OPF_IMM32;
+
+    if (inOpcode >= 0xc8 && inOpcode <= 0xcf)   // bswap
+        return 0;
+
+    switch (inOpcode)
+    {
+        case 0x05: case 0x06: case 0x07: case 0x08:
+        case 0x09: case 0x0b: case 0x30: case 0x31:
+        case 0x32: case 0x33: case 0x34: case 0x35:
+        case 0x37: case 0x77: case 0xa0: case 0xa1:
+        case 0xa2: case 0xa8: case 0xa9: case 0xaa:
+            return 0;
+
+        case 0x3a: case 0x70: case 0x71: case 0x72:
+        case 0x73: case 0xa4: case 0xac: case 0xba:
+        case 0xc2: case 0xc4: case 0xc5: case 0xc6:
+            return OPF_MODRM | OPF_IMM8;
+
+        default:
+            return OPF_MODRM;
+    }
+}
+
+//  X86ReadSigned
+// ----------------------------------------------------------------------------
+
+static SInt64
+X86ReadSigned(
+    const UInt8*    inCode,
+    UInt8           inSize)
+{
+    switch (inSize)
+    {
+        case 1:
+            return (SInt8)inCode[0];
+        case 2:
+            return (SInt16)OSSwapLittleToHostInt16(*(UInt16*)inCode);
+        case 4:
+            return (SInt32)OSSwapLittleToHostInt32(*(uint32_t*)inCode);
+        case 8:
+            return (SInt64)OSSwapLittleToHostInt64(*(UInt64*)inCode);
+        default:
+            return 0;
+    }
+}
+
+//  X86DecodeOperands
+// ----------------------------------------------------------------------------
+//  Fill outOps from inCode. inLongMode enables REX prefixes and 8-byte
+//  moffs and mov imm64 operands.
+
+void
+X86DecodeOperands(
+    const UInt8*    inCode,
+    BOOL            inLongMode,
+    X86Operands*    outOps)
+{
+    UInt8   i       = 0;
+    UInt8   immSize = 0;
+    UInt8   opcode;
+    UInt16  flags;
+
+    *outOps = (X86Operands){0};
+
+    if (inLongMode)
+    {
+        while (i < X86_CODE_BYTES - 2 && HI(inCode[i]) == 0x4)
+            outOps->rex = inCode[i++];
+    }
+
+    outOps->opcodeIndex = i;
+    outOps->opcode      = opcode    = inCode[i++];
+    outOps->modRM       = inCode[i];
+    outOps->flags       = flags     = gX86OpcodeTable[opcode];
+
+    if (flags & OPF_PREFIX)
+    {
+        if (inLongMode)
+        {
+            while (i < X86_CODE_BYTES - 2 && HI(inCode[i]) == 0x4)
+                outOps->rex = inCode[i++];
+        }
+
+        outOps->nextOpcode  = opcode    = inCode[i++];
+        outOps->modRM       = inCode[i];
+        flags               = gX86OpcodeTable[opcode];
+
+        // Only one prefix is decoded.
+        if (flags & OPF_PREFIX)
+        {
+            outOps->length  = i;
+            return;
+        }
+    }
+
+    if (flags & OPF_ESCAPE)
+    {
+        if (i + 2 >= X86_CODE_BYTES)
+        {
+            outOps->length  = i;
+            return;
+        }
+
+        outOps->opcode2 = inCode[i++];
+        flags           = (flags & ~OPF_FORM_MASK) |
+            X86TwoByteForm(outOps->opcode2);
+
+        if (outOps->opcode2 == 0x38 || outOps->opcode2 == 0x3a)
+            i++;    // 3-byte opcode
+
+        outOps->modRM   = inCode[i];
+    }
+
+    // A prefix keeps its own flags, plus the form of what it prefixes.
+    if (outOps->nextOpcode)
+        outOps->flags  |= flags & OPF_FORM_MASK;
+    else
+        outOps->flags   = flags;
+
+    if (flags & OPF_MODRM)
+    {
+        outOps->hasModRM    = YES;
+        i++;
+
+        if (HAS_SIB(outOps->modRM) && i < X86_CODE_BYTES)
+        {
+            outOps->hasSIB  = YES;
+            outOps->sib     = inCode[i++];
+
+            if (MOD(outOps->modRM) == MODimm && REG2(outOps->sib) == EBP)
+                outOps->dispSize    = 4;
+        }
+
+        if (HAS_DISP8(outOps->modRM))
+            outOps->dispSize    = 1;
+        else if (HAS_REL_DISP32(outOps->modRM) ||
+            HAS_ABS_DISP32(outOps->modRM))
+            outOps->dispSize    = 4;
+
+        // test r/m, imm is the only member of its group with an immediate.
+        if ((opcode == 0xf6 || opcode == 0xf7) && OPEXT(outOps->modRM) < 2)
+            immSize = (opcode == 0xf6) ? 1 : 4;
+    }
+    else if (flags & OPF_MOFFS)
+        outOps->dispSize    = (inLongMode) ? 8 : 4;
+
+    if (flags & OPF_IMM32)
+        immSize = (inLongMode && (outOps->rex & 0x8) &&   // REX.W
+            opcode >= 0xb8 && opcode <= 0xbf) ? 8 : 4;
+    else if (flags & OPF_IMM16)
+        immSize = 2;
+    else if (flags & OPF_IMM8)
+        immSize = 1;
+
+    if (i + outOps->dispSize + immSize > X86_CODE_BYTES)
+    {
+        outOps->length  = i;
+        return;
+    }
+
+    outOps->disp    = X86ReadSigned(&inCode[i], outOps->dispSize);
+    i              += outOps->dispSize;
+    outOps->imm     = X86ReadSigned(&inCode[i], immSize);
+    outOps->immSize = immSize;
+
+    // enter and far pointers carry a second immediate.
+    if ((flags & OPF_IMM8) && immSize == 2)
+        outOps->immSize += 1;
+    else if ((flags & OPF_IMM16) && immSize == 4)
+        outOps->immSize += 2;
+
+    outOps->length  = i + outOps->immSize;
+}
+
+// ============================================================================
+
 @implementation X86Processor
 
 //  initWithURL:controller:options:
@@ -71,6 +349,36 @@
     [super dealloc];
 }
 
+//  newWorker
+// ----------------------------------------------------------------------------
+
+- (id)newWorker
+{
+    X86Processor*   worker  = [super newWorker];
+
+    // Don't share our local variable arrays.
+    worker->iLocalSelves    = NULL;
+    worker->iNumLocalSelves = 0;
+    worker->iLocalVars      = NULL;
+    worker->iNumLocalVars   = 0;
+
+    return worker;
+}
+
+//  disposeWorker
+// ----------------------------------------------------------------------------
+
+- (void)disposeWorker
+{
+    if (iLocalSelves)
+        free(iLocalSelves);
+
+    if (iLocalVars)
+        free(iLocalVars);
+
+    [super disposeWorker];
+}
+
 //  loadDyldDataSection:
 // ----------------------------------------------------------------------------
 
@@ -168,9 +476,7 @@
     }
 
     // Store a thunk.
-    iNumThunks++;
-    iThunks = realloc(iThunks, iNumThunks * sizeof(ThunkInfo));
-    iThunks[iNumThunks - 1] = theThunk;
+    [self addThunk:theThunk];
 
     // Recognize it as a function.
     inLine->prev->info.isFunction = YES;
@@ -212,27 +518,40 @@
     if (opcode != 0xe8) // calll
         return NO;
 
-    BOOL isThunk = NO;
     uint32_t imm = *(uint32_t*)&inLine->info.code[1];
-    uint32_t target, i;
+    uint32_t target;
 
-    imm = OSSwapInt32(imm);
+    imm = OSSwapLittleToHostInt32(imm);
     target  = imm + inLine->next->info.address;
 
-    for (i = 0; i < iNumThunks; i++)
-    {
-        if (iThunks[i].address != target)
-            continue;
+    ThunkInfo*  theThunk    = [self findThunkAtAddress:target];
 
-        *outInfo    = iThunks[i];
-        isThunk     = YES;
-        break;
-    }
+    if (!theThunk)
+        return NO;
+
+    *outInfo    = *theThunk;
 
-    return isThunk;
+    return YES;
 }
 
 #pragma mark -
+//  operandsForLine:
+// ----------------------------------------------------------------------------
+//  Decode inLine once for all the handlers that look at it.
+
+- (X86Operands*)operandsForLine: (Line*)inLine
+{
+    if (inLine != iOperandsLine ||
+        inLine->info.address != iOperandsAddress)
+    {
+        X86DecodeOperands(inLine->info.code, NO, &iOperands);
+        iOperandsLine       = inLine;
+        iOperandsAddress    = inLine->info.address;
+    }
+
+    return &iOperands;
+}
+
 //  commentForLine:
 // ----------------------------------------------------------------------------
 
@@ -243,7 +562,8 @@
     uint32_t  localAddy = 0;
     uint32_t  targetAddy = 0;
     UInt8   modRM = 0;
-    UInt8   opcode = inLine->info.code[0];
+    X86Operands*    ops = [self operandsForLine:inLine];
+    UInt8   opcode = ops->opcode;
 
     iLineCommentCString[0]  = 0;
 
@@ -254,15 +574,16 @@
     }
 #endif
 
+    if (!(ops->flags & OPF_NOTE))
+        return;
+
     switch (opcode)
     {
         case 0x0f:  // 2-byte and SSE opcodes   **add sysenter support here
         {
-            if (inLine->info.code[1] == 0x2e)    // ucomiss
+            if (ops->opcode2 == 0x2e)    // ucomiss
             {
-                localAddy = *(uint32_t*)&inLine->info.code[3];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
-
+                localAddy = (uint32_t)ops->disp;
                 theDummyPtr = [self getPointer:localAddy type:NULL];
                 
                 if (theDummyPtr)
@@ -273,44 +594,27 @@
                     snprintf(iLineCommentCString, 30, "%G", *(float*)&theInt32);
                 }
             }
-            else if (inLine->info.code[1] == 0x84)   // jcc
+            else if (ops->opcode2 == 0x84)   // jcc
             {
                 if (!inLine->next)
                     break;
 
-                SInt32 targetOffset = *(SInt32*)&inLine->info.code[2];
-
-                targetOffset = OSSwapLittleToHostInt32(targetOffset);
-                targetAddy = inLine->next->info.address + targetOffset;
+                targetAddy = inLine->next->info.address + (SInt32)ops->imm;
 
                 // Search current FunctionInfo for blocks that start at this address.
                 FunctionInfo*   funcInfo    = &iFuncInfos[iCurrentFuncInfoIndex];
 
-                if (!funcInfo->blocks)
-                    break;
-
-                uint32_t i;
+                BlockInfo*      targetBlock = [self findBlockAtAddress: targetAddy
+                    inFunction: funcInfo];
 
-                for (i = 0; i < funcInfo->numBlocks; i++)
-                {
-                    if (funcInfo->blocks[i].beginAddress != targetAddy)
-                        continue;
-
-                    if (funcInfo->blocks[i].isEpilog)
-                        snprintf(iLineCommentCString, 8, "return;");
-
-                    break;
-                }
+                if (targetBlock && targetBlock->isEpilog)
+                    snprintf(iLineCommentCString, 8, "return;");
             }
-            else if ((inLine->info.code[1] & 0x90) == 0x90) // SETcc + MOVSX + MOVZX + ... ?
+            else if ((ops->opcode2 & 0x90) == 0x90) // SETcc + MOVSX + MOVZX + ... ?
             {
-                modRM = inLine->info.code[2];
+                modRM = ops->modRM;
                 if (MOD(modRM) == MOD32 && iRegInfos[REG2(modRM)].isValid)
-                {
-                    uint32_t imm = *(uint32_t*)&inLine->info.code[3];
-                    imm = OSSwapLittleToHostInt32(imm);
-                    localAddy = iRegInfos[REG2(modRM)].value + imm;
-                }
+                    localAddy = iRegInfos[REG2(modRM)].value + (uint32_t)ops->disp;
             }
 
             break;
@@ -318,7 +622,7 @@
 
         case 0x3c:  // cmpb imm8,al
         {
-            UInt8 imm = inLine->info.code[1];
+            UInt8 imm = (UInt8)ops->imm;
 
             // Check for a single printable 7-bit char.
             if (imm >= 0x20 && imm < 0x7f)
@@ -328,12 +632,10 @@
         }
 
         case 0x66:
-            if (inLine->info.code[1] != 0x0f ||
-                inLine->info.code[2] != 0x2e)    // ucomisd
+            if (ops->nextOpcode != 0x0f || ops->opcode2 != 0x2e)    // ucomisd
                 break;
 
-            localAddy = *(uint32_t*)&inLine->info.code[4];
-            localAddy = OSSwapLittleToHostInt32(localAddy);
+            localAddy = (uint32_t)ops->disp;
             theDummyPtr = [self getPointer:localAddy type:NULL];
 
             if (theDummyPtr)
@@ -354,28 +656,16 @@
             if (!inLine->next)
                 break;
 
-            SInt8 simm = inLine->info.code[1];
-
-            targetAddy = inLine->next->info.address + simm;
+            targetAddy = inLine->next->info.address + (SInt8)ops->imm;
 
             // Search current FunctionInfo for blocks that start at this address.
             FunctionInfo* funcInfo = &iFuncInfos[iCurrentFuncInfoIndex];
 
-            if (!funcInfo->blocks)
-                break;
-
-            uint32_t  i;
+            BlockInfo*      targetBlock = [self findBlockAtAddress: targetAddy
+                inFunction: funcInfo];
 
-            for (i = 0; i < funcInfo->numBlocks; i++)
-            {
-                if (funcInfo->blocks[i].beginAddress != targetAddy)
-                    continue;
-
-                if (funcInfo->blocks[i].isEpilog)
-                    snprintf(iLineCommentCString, 8, "return;");
-
-                break;
-            }
+            if (targetBlock && targetBlock->isEpilog)
+                snprintf(iLineCommentCString, 8, "return;");
 
             break;
         }
@@ -384,19 +674,13 @@
         case 0x80:  // imm8,r8
         case 0x83:  // imm8,r32
         {
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             // In immediate group 1 we only want cmpb
             if (OPEXT(modRM) != 7)
                 break;
 
-            UInt8 imm;
-            UInt8 immOffset = 2;
-
-            if (HAS_DISP8(modRM))
-                immOffset +=  1;
-
-            imm = inLine->info.code[immOffset];
+            UInt8 imm = (UInt8)ops->imm;
 
             if (iRegInfos[REG2(modRM)].classPtr)    // address relative to class
             {
@@ -408,10 +692,9 @@
                     break;
 
                 objc_32_class_ptr classPtr = iRegInfos[REG2(modRM)].classPtr;
-                immOffset = inLine->info.code[2];
 
                 char *typePtr = NULL;
-                if (![self getIvarName:&theSymPtr type:&typePtr withOffset:immOffset inClass:classPtr])
+                if (![self getIvarName:&theSymPtr type:&typePtr withOffset:(uint32_t)ops->disp inClass:classPtr])
                     break;
 
                 if (theSymPtr)
@@ -446,7 +729,7 @@
         case 0x8b:  // movl r/m32,r32
         case 0xc6:  // movb imm8,r/m32
         case 0xf6:  // testb imm8,r/m8
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             // In immediate group 1 we only want cmpl
             if (opcode == 0x81 && OPEXT(modRM) != 7)
@@ -455,10 +738,7 @@
             if (MOD(modRM) == MODimm)   // 1st addressing mode
             {
                 if (RM(modRM) == DISP32)
-                {
-                    localAddy = *(uint32_t*)&inLine->info.code[2];
-                    localAddy = OSSwapLittleToHostInt32(localAddy);
-                }
+                    localAddy = (uint32_t)ops->disp;
             }
             else
             {
@@ -472,17 +752,7 @@
                         break;
 
                     objc_32_class_ptr classPtr = iRegInfos[REG2(modRM)].classPtr;
-                    uint32 offset = 0;
-
-                    if (MOD(modRM) == MOD8)
-                    {
-                        offset = (SInt8)inLine->info.code[2];
-                    }
-                    else if (MOD(modRM) == MOD32)
-                    {
-                        offset = *(uint32_t*)&inLine->info.code[2];
-                        offset = OSSwapLittleToHostInt32(offset);
-                    }
+                    uint32 offset = (uint32)ops->disp;
 
                     char *typePtr = NULL;
                     if (![self getIvarName:&theSymPtr type:&typePtr withOffset:offset inClass:classPtr])
@@ -509,11 +779,7 @@
                         break;
 
                     if (iRegInfos[REG2(modRM)].isValid)
-                    {
-                        uint32_t imm = *(uint32_t*)&inLine->info.code[2];
-                        imm = OSSwapLittleToHostInt32(imm);
-                        localAddy = iRegInfos[REG2(modRM)].value + imm;
-                    }
+                        localAddy = iRegInfos[REG2(modRM)].value + (uint32_t)ops->disp;
                 }
                 else if (MOD(modRM) == MOD8)   // absolute address
                 {
@@ -521,17 +787,14 @@
                         break;
 
                     if (iRegInfos[REG2(modRM)].isValid)
-                    {
-                        SInt8 imm = (SInt8)inLine->info.code[2];
-                        localAddy = iRegInfos[REG2(modRM)].value + imm;
-                    }
+                        localAddy = iRegInfos[REG2(modRM)].value + (SInt8)ops->disp;
                 }
             }
 
             break;
 
         case 0x8d:  // leal
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (iRegInfos[REG2(modRM)].classPtr)    // address relative to class
             {
@@ -543,17 +806,7 @@
                     break;
 
                 objc_32_class_ptr classPtr = iRegInfos[REG2(modRM)].classPtr;
-                uint32 offset = 0;
-
-                if (MOD(modRM) == MOD8)
-                {
-                    offset = (sint8)inLine->info.code[2];
-                }
-                else if (MOD(modRM) == MOD32)
-                {
-                    offset = *(uint32_t*)&inLine->info.code[2];
-                    offset = OSSwapLittleToHostInt32(offset);
-                }
+                uint32 offset = (uint32)ops->disp;
 
                 char *typePtr = NULL;
                 if (![self getIvarName:&theSymPtr type:&typePtr withOffset:offset inClass:classPtr])
@@ -575,24 +828,15 @@
                 }
             }
             else if (iRegInfos[REG2(modRM)].isValid)
-            {
-                uint32_t imm = *(uint32_t*)&inLine->info.code[2];
-
-                imm = OSSwapLittleToHostInt32(imm);
-                localAddy = iRegInfos[REG2(modRM)].value + imm;
-            }
+                localAddy = iRegInfos[REG2(modRM)].value + (uint32_t)ops->disp;
             else
-            {
-                localAddy = *(uint32_t*)&inLine->info.code[2];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
-            }
+                localAddy = (uint32_t)ops->disp;
 
             break;
 
         case 0xa1:  // movl moffs32,r32
         case 0xa3:  // movl r32,moffs32
-            localAddy = *(uint32_t*)&inLine->info.code[1];
-            localAddy = OSSwapLittleToHostInt32(localAddy);
+            localAddy = (uint32_t)ops->disp;
             break;
 
         case 0xb0:  // movb imm8,%al
@@ -604,7 +848,7 @@
         case 0xb6:  // movb imm8,%dh
         case 0xb7:  // movb imm8,%bh
         {
-            UInt8 imm = inLine->info.code[1];
+            UInt8 imm = (UInt8)ops->imm;
 
             // Check for a single printable 7-bit char.
             if (imm >= 0x20 && imm < 0x7f)
@@ -621,8 +865,7 @@
         case 0xbd:  // movl imm32,%ebp
         case 0xbe:  // movl imm32,%esi
         case 0xbf:  // movl imm32,%edi
-            localAddy = *(uint32_t*)&inLine->info.code[1];
-            localAddy = OSSwapLittleToHostInt32(localAddy);
+            localAddy = (uint32_t)ops->imm;
 
             // Check for a four char code.
             if (localAddy >= 0x20202020 && localAddy < 0x7f7f7f7f)
@@ -652,7 +895,7 @@
 
         case 0xc7:  // movl imm32,r/m32
         {
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (iRegInfos[REG2(modRM)].classPtr)    // address relative to class
             {
@@ -663,32 +906,14 @@
                 if (MOD(modRM) == MODimm || MOD(modRM) == MODx)
                     break;
 
-                UInt8 immOffset = 2;
                 char fcc[7] = {0};
 
-                if (HAS_DISP8(modRM))
-                    immOffset += 1;
-                else if (HAS_REL_DISP32(modRM))
-                    immOffset += 4;
-
-                if (HAS_SIB(modRM))
-                    immOffset += 1;
-
                 objc_32_class_ptr classPtr = iRegInfos[REG2(modRM)].classPtr;
-                uint32_t offset = 0;
+                uint32_t offset = (uint32_t)ops->disp;
 
-                if (MOD(modRM) == MOD8)
+                if (MOD(modRM) == MOD32)
                 {
-                    offset = (SInt8)inLine->info.code[immOffset - 1];
-                }
-                else if (MOD(modRM) == MOD32)
-                {
-                    uint32_t imm = *(uint32_t*)&inLine->info.code[immOffset];
-                    imm = OSSwapLittleToHostInt32(imm);
-
-                    // offset precedes immediate value
-                    offset = *(uint32_t*)&inLine->info.code[immOffset - 4];
-                    offset = OSSwapLittleToHostInt32(offset);
+                    uint32_t imm = (uint32_t)ops->imm;
 
                     // Check for a four char code.
                     if (imm >= 0x20202020 && imm < 0x7f7f7f7f)
@@ -754,16 +979,7 @@
             }
             else    // absolute address
             {
-                UInt8 immOffset = 2;
-
-                if (HAS_DISP8(modRM))
-                    immOffset += 1;
-
-                if (HAS_SIB(modRM))
-                    immOffset += 1;
-
-                localAddy = *(uint32_t*)&inLine->info.code[immOffset];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
+                localAddy = (uint32_t)ops->imm;
 
                 // Check for a four char code.
                 if (localAddy >= 0x20202020 && localAddy < 0x7f7f7f7f)
@@ -792,16 +1008,14 @@
         }
 
         case 0xcd:  // int
-            modRM = inLine->info.code[1];
-
-            if (modRM == 0x80)
+            if ((UInt8)ops->imm == 0x80)
                 [self commentForSystemCall];
 
             break;
 
         case 0xd9:  // fldsl    r/m32
         case 0xdd:  // fldll
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (iRegInfos[REG2(modRM)].classPtr)    // address relative to class
             {
@@ -813,17 +1027,7 @@
                     break;
 
                 objc_32_class_ptr classPtr = iRegInfos[REG2(modRM)].classPtr;
-                uint32 offset = 0;
-
-                if (MOD(modRM) == MOD8)
-                {
-                    offset = (SInt8)inLine->info.code[2];
-                }
-                else if (MOD(modRM) == MOD32)
-                {
-                    offset = *(uint32_t*)&inLine->info.code[2];
-                    offset = OSSwapLittleToHostInt32(offset);
-                }
+                uint32 offset = (uint32)ops->disp;
 
                 char *typePtr = NULL;
                 if (![self getIvarName:&theSymPtr type:&typePtr withOffset:offset inClass:classPtr])
@@ -846,16 +1050,7 @@
             }
             else    // absolute address
             {
-                UInt8 immOffset = 2;
-
-                if (HAS_DISP8(modRM))
-                    immOffset += 1;
-
-                if (HAS_SIB(modRM))
-                    immOffset += 1;
-
-                localAddy = *(uint32_t*)&inLine->info.code[immOffset];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
+                localAddy = (uint32_t)ops->disp;
                 theDummyPtr = [self getPointer:localAddy type:NULL];
 
                 if (!theDummyPtr)
@@ -892,10 +1087,8 @@
             if (iLineCommentCString[0])
                 break;
 
-            localAddy = *(uint32_t*)&inLine->info.code[1];
-            localAddy = OSSwapLittleToHostInt32(localAddy);
-
-            uint32_t absoluteAddy = inLine->info.address + 5 + (SInt32)localAddy;
+            uint32_t absoluteAddy =
+                inLine->info.address + ops->length + (SInt32)ops->imm;
 
 // FIXME: can we use mCurrentFuncInfoIndex here?
             FunctionInfo    searchKey   = {absoluteAddy, NULL, 0, 0};
@@ -914,12 +1107,10 @@
         case 0xf2:  // repne/repnz or movsd, mulsd etc
         case 0xf3:  // rep/repe or movss, mulss etc
         {
-            UInt8 byte2 = inLine->info.code[1];
-
-            if (byte2 != 0x0f)  // movsd/s, divsd/s, addsd/s etc
+            if (ops->nextOpcode != 0x0f)  // movsd/s, divsd/s, addsd/s etc
                 break;
 
-            modRM = inLine->info.code[3];
+            modRM = ops->modRM;
 
             if (iRegInfos[REG2(modRM)].classPtr)    // address relative to self
             {
@@ -931,17 +1122,7 @@
                     break;
 
                 objc_32_class_ptr classPtr = iRegInfos[REG2(modRM)].classPtr;
-                uint32 offset = 0;
-
-                if (MOD(modRM) == MOD8)
-                {
-                    offset = (SInt8)inLine->info.code[2];
-                }
-                else if (MOD(modRM) == MOD32)
-                {
-                    offset = *(uint32_t*)&inLine->info.code[2];
-                    offset = OSSwapLittleToHostInt32(offset);
-                }
+                uint32 offset = (uint32)ops->disp;
 
                 char *typePtr = NULL;
                 if (![self getIvarName:&theSymPtr type:&typePtr withOffset:offset inClass:classPtr])
@@ -965,8 +1146,7 @@
             }
             else    // absolute address
             {
-                localAddy = *(uint32_t*)&inLine->info.code[4];
-                localAddy = OSSwapLittleToHostInt32(localAddy);
+                localAddy = (uint32_t)ops->disp;
                 theDummyPtr = [self getPointer:localAddy type:NULL];
 
                 if (theDummyPtr)
@@ -1311,6 +1491,10 @@
         }
         
         iMatchedSelectorCount++;
+        [self addXref: selString kind: XrefSelector
+            site: inLine->info.address function: iCurrentFunctionStart];
+
+        iLineSelector   = selString;
 
         UInt8   sendType    = [self sendTypeFromMsgSend:ioComment];
 
@@ -1383,6 +1567,8 @@
             }
         }
 
+        iLineClassName  = className;
+
         if (className)
         {
             snprintf(ioComment, MAX_COMMENT_LENGTH,
@@ -1457,17 +1643,19 @@
 
     if (theCode == 0xe8 || theCode == 0xe9 || theCode == 0xff || theCode == 0x9a)
     {
-        Line*   theNewLine  = malloc(sizeof(Line));
-
-        memcpy(theNewLine, (*ioLine)->alt, sizeof(Line));
-        theNewLine->chars   = malloc(theNewLine->length + 1);
-        strncpy(theNewLine->chars, (*ioLine)->alt->chars,
-            theNewLine->length + 1);
-
-        // Swap in the verbose line and free the previous verbose lines.
-        [self deleteLinesBefore:(*ioLine)->alt fromList:&iVerboseLineListHead];
-        [self replaceLine:*ioLine withLine:theNewLine inList:&iPlainLineListHead];
-        *ioLine = theNewLine;
+        // Take the verbose line's text. The Line itself stays put, so other
+        // threads can safely walk the list while we do this.
+        free((*ioLine)->chars);
+        (*ioLine)->chars        = (*ioLine)->alt->chars;
+        (*ioLine)->length       = (*ioLine)->alt->length;
+        (*ioLine)->alt->chars   = NULL;
+        (*ioLine)->alt->length  = 0;
+
+        // Free the verbose lines before this one. Worker threads leave that
+        // to processLinesInParallel, see newWorker.
+        if (iVerboseLineListHead && (*ioLine)->alt != iVerboseLineListHead)
+            [self deleteLinesBefore: (*ioLine)->alt
+                fromList: &iVerboseLineListHead];
     }
 }
 
@@ -1504,25 +1692,14 @@
     }
     else if (iThunks)   // otool didn't spot it, maybe we did earlier...
     {
-        uint32_t i;
-        size_t target;
+        ThunkInfo*  theThunk    = [self findThunkAtAddress:
+            strtoul(iLineOperandsCString, NULL, 16)];
 
-        for (i = 0; i < iNumThunks; i++)
+        if (theThunk && theThunk->reg != NO_REG)
         {
-            target  = strtoul(iLineOperandsCString, NULL, 16);
-
-            if (target == iThunks[i].address)
-            {
-                SInt8 thunkReg = iThunks[i].reg;
-
-                if (thunkReg != NO_REG) {
-                    iRegInfos[thunkReg].value      =
-                        (*ioLine)->next->info.address;
-                    iRegInfos[thunkReg].isValid    = YES;
-                }
-
-                return;
-            }
+            iRegInfos[theThunk->reg].value      =
+                (*ioLine)->next->info.address;
+            iRegInfos[theThunk->reg].isValid    = YES;
         }
     }
 }
@@ -1591,7 +1768,8 @@
 
 - (void)updateRegisters: (Line*)inLine;
 {
-    UInt8 opcode = inLine->info.code[0];
+    X86Operands* ops = [self operandsForLine:inLine];
+    UInt8 opcode = ops->opcode;
     UInt8 modRM;
 
 #if OTX_DEBUG
@@ -1616,6 +1794,10 @@
 #endif
 #endif 
 
+    // Most instructions leave the tracked registers alone.
+    if (!(ops->flags & OPF_REGS))
+        return;
+
     switch (opcode)
     {
         // pop stack into thunk registers.
@@ -1650,12 +1832,12 @@
         // add, or, adc, sbb, and, sub, xor, cmp
         case 0x83:  // EXTS(imm8),r32
         {
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (!iRegInfos[REG1(modRM)].isValid)
                 break;
 
-            UInt8 imm = inLine->info.code[2];
+            SInt32 imm = (SInt32)ops->imm;
 
             switch (OPEXT(modRM))
             {
@@ -1703,7 +1885,7 @@
 
         case 0x89:  // mov reg to r/m
         {
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (MOD(modRM) == MODx) // reg to reg
             {
@@ -1727,7 +1909,7 @@
             if (HAS_SIB(modRM)) // pushing an arg onto stack
             {
                 if (HAS_DISP8(modRM))
-                    offset = (SInt8)inLine->info.code[3];
+                    offset = (SInt8)ops->disp;
 
                 if (offset >= 0)
                 {
@@ -1751,7 +1933,7 @@
             {
                 if (iRegInfos[REG1(modRM)].classPtr && MOD(modRM) == MOD8)
                 {
-                    offset = (SInt8)inLine->info.code[2];
+                    offset = (SInt8)ops->disp;
 
                     iNumLocalSelves++;
                     iLocalSelves = realloc(iLocalSelves,
@@ -1763,15 +1945,8 @@
                 {
                     SInt32 varOffset = 0;
 
-                    if (MOD(modRM) == MOD32)
-                    {
-                        varOffset = *(SInt32*)&inLine->info.code[2];
-                        varOffset = OSSwapLittleToHostInt32(varOffset);
-                    }
-                    else if (MOD(modRM) == MOD8)
-                    {
-                        varOffset = (SInt8)inLine->info.code[2];
-                    }
+                    if (MOD(modRM) == MOD32 || MOD(modRM) == MOD8)
+                        varOffset = (SInt32)ops->disp;
                 
                     VarInfo *localVarToUse = NULL;
                     for (SInt32 i = 0; i < iNumLocalVars; i++)
@@ -1798,15 +1973,13 @@
 
         case 0x8b:  // mov mem to reg
         case 0x8d:  // lea mem to reg
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (MOD(modRM) == MODimm)
             {
                 if (REG2(modRM) == EBP) // disp32
                 {
-                    uint32_t offset = *(uint32_t*)&inLine->info.code[2];
-
-                    offset = OSSwapLittleToHostInt32(offset);
+                    uint32_t offset = (uint32_t)ops->disp;
 
                     iRegInfos[REG1(modRM)] = (GPRegisterInfo){0};
                     iRegInfos[REG1(modRM)].value = offset;
@@ -1819,7 +1992,7 @@
             }
             else if (MOD(modRM) == MOD8)
             {
-                SInt8 offset = (SInt8)inLine->info.code[2];
+                SInt8 offset = (SInt8)ops->disp;
 
                 if (REG2(modRM) == EBP && offset == 0x8)
                 {   // Copying self from 1st arg to a register.
@@ -1874,9 +2047,7 @@
 
                 if (iLocalVars)
                 {
-                    SInt32 offset = *(SInt32*)&inLine->info.code[2];
-
-                    offset = OSSwapLittleToHostInt32(offset);
+                    SInt32 offset = (SInt32)ops->disp;
 
                     if (offset < 0)
                     {
@@ -1896,10 +2067,8 @@
             }
             else if (HAS_ABS_DISP32(modRM))
             {
-                uint32_t newValue = *(uint32_t*)&inLine->info.code[2];
-
                 iRegInfos[REG1(modRM)].isValid = YES;
-                iRegInfos[REG1(modRM)].value = OSSwapLittleToHostInt32(newValue);
+                iRegInfos[REG1(modRM)].value = (uint32_t)ops->disp;
                 iRegInfos[REG1(modRM)].classPtr = NULL;
                 iRegInfos[REG1(modRM)].catPtr = NULL;
             }
@@ -1908,10 +2077,8 @@
                 if (!iRegInfos[REG2(modRM)].isValid)
                     break;
 
-                uint32_t newValue = *(uint32_t*)&inLine->info.code[2];
-
-                newValue = OSSwapLittleToHostInt32(newValue);
-                newValue += iRegInfos[REG2(modRM)].value;
+                uint32_t newValue =
+                    (uint32_t)ops->disp + iRegInfos[REG2(modRM)].value;
 
                 iRegInfos[REG1(modRM)].isValid = YES;
                 iRegInfos[REG1(modRM)].value = newValue;
@@ -1932,9 +2099,7 @@
         {
             iRegInfos[REG2(opcode)] = (GPRegisterInfo){0};
 
-            UInt8 imm = inLine->info.code[1];
-
-            iRegInfos[REG2(opcode)].value = imm;
+            iRegInfos[REG2(opcode)].value = (UInt8)ops->imm;
             iRegInfos[REG2(opcode)].isValid = YES;
 
             break;
@@ -1944,9 +2109,7 @@
         {
             iRegInfos[EAX]  = (GPRegisterInfo){0};
 
-            uint32_t newValue = *(uint32_t*)&inLine->info.code[1];
-
-            iRegInfos[EAX].value = OSSwapLittleToHostInt32(newValue);
+            iRegInfos[EAX].value = (uint32_t)ops->disp;
             iRegInfos[EAX].isValid = YES;
 
             break;
@@ -1963,9 +2126,7 @@
         {
             iRegInfos[REG2(opcode)] = (GPRegisterInfo){0};
 
-            uint32_t newValue = *(uint32_t*)&inLine->info.code[1];
-
-            iRegInfos[REG2(opcode)].value = OSSwapInt32(newValue);
+            iRegInfos[REG2(opcode)].value = (uint32_t)ops->imm;
             iRegInfos[REG2(opcode)].isValid = YES;
 
             break;
@@ -1973,7 +2134,7 @@
 
         case 0xc7:  // movl imm32,r/m32
         {
-            modRM = inLine->info.code[1];
+            modRM = ops->modRM;
 
             if (!HAS_SIB(modRM))
                 break;
@@ -1983,9 +2144,8 @@
 
             if (HAS_DISP8(modRM))
             {
-                offset = (SInt8)inLine->info.code[3];
-                value = *(SInt32*)&inLine->info.code[4];
-                value = OSSwapLittleToHostInt32(value);
+                offset = (SInt8)ops->disp;
+                value = (SInt32)ops->imm;
             }
 
             if (offset >= 0)
@@ -2036,6 +2196,10 @@
     if (iCurrentFuncInfoIndex < 0)
         return NO;
 
+    // Only lines flagged by addBlockAtAddress:toFunction: can begin a block.
+    if (!inLine->info.startsBlock)
+        return NO;
+
     // Search current FunctionInfo for blocks that start at this address.
     FunctionInfo*   funcInfo    =
         &iFuncInfos[iCurrentFuncInfoIndex];
@@ -2043,50 +2207,41 @@
     if (!funcInfo->blocks)
         return NO;
 
-    uint32_t  i;
-
-    for (i = 0; i < funcInfo->numBlocks; i++)
-    {
-        if (funcInfo->blocks[i].beginAddress != inLine->info.address)
-            continue;
+    BlockInfo*      theBlock    = [self findBlockAtAddress: inLine->info.address
+        inFunction: funcInfo];
 
-        // Update machine state.
-        MachineState    machState   = funcInfo->blocks[i].state;
+    if (!theBlock)
+        return NO;
 
-        memcpy(iRegInfos, machState.regInfos,
-            sizeof(GPRegisterInfo) * 8);
+    // Update machine state.
+    MachineState    machState   = theBlock->state;
 
-        if (machState.localSelves)
-        {
-            if (iLocalSelves)
-                free(iLocalSelves);
-
-            iNumLocalSelves = machState.numLocalSelves;
-            iLocalSelves    = malloc(
-                sizeof(VarInfo) * machState.numLocalSelves);
-            memcpy(iLocalSelves, machState.localSelves,
-                sizeof(VarInfo) * machState.numLocalSelves);
-        }
+    memcpy(iRegInfos, machState.regInfos,
+        sizeof(GPRegisterInfo) * 8);
 
-        if (machState.localVars)
-        {
-            if (iLocalVars)
-                free(iLocalVars);
-
-            iNumLocalVars   = machState.numLocalVars;
-            iLocalVars      = malloc(
-                sizeof(VarInfo) * iNumLocalVars);
-            memcpy(iLocalVars, machState.localVars,
-                sizeof(VarInfo) * iNumLocalVars);
-        }
+    if (machState.localSelves)
+    {
+        // Reuse our buffers, they're usually big enough already.
+        iNumLocalSelves = machState.numLocalSelves;
+        iLocalSelves    = realloc(iLocalSelves,
+            sizeof(VarInfo) * iNumLocalSelves);
+        memcpy(iLocalSelves, machState.localSelves,
+            sizeof(VarInfo) * machState.numLocalSelves);
+    }
 
-        // Optionally add a blank line before this block.
-        if (iOpts.separateLogicalBlocks && inLine->chars[0] != '\n' &&
-            !inLine->info.isFunction)
-            needNewLine = YES;
+    if (machState.localVars)
+    {
+        iNumLocalVars   = machState.numLocalVars;
+        iLocalVars      = realloc(iLocalVars,
+            sizeof(VarInfo) * iNumLocalVars);
+        memcpy(iLocalVars, machState.localVars,
+            sizeof(VarInfo) * iNumLocalVars);
+    }
 
-        break;
-    }   // for (i = 0...)
+    // Optionally add a blank line before this block.
+    if (iOpts.separateLogicalBlocks && inLine->chars[0] != '\n' &&
+        !inLine->info.isFunction)
+        needNewLine = YES;
 
     return needNewLine;
 }
@@ -2099,41 +2254,17 @@
     if (!inLine)
         return NO;
 
-    uint32_t  theAddy = inLine->info.address;
-
-    if (theAddy == iAddrDyldStubBindingHelper   ||
-        theAddy == iAddrDyldFuncLookupPointer)
-        return YES;
-
-    MethodInfo* theDummyInfo    = NULL;
-
-    // In Obj-C apps, the majority of funcs will have Obj-C symbols, so check
-    // those first.
-    if ([self findClassMethod:&theDummyInfo byAddress:theAddy])
-        return YES;
-
-    if ([self findCatMethod:&theDummyInfo byAddress:theAddy])
-        return YES;
-
-    // If it's not an Obj-C method, maybe there's an nlist.
-    if ([self findSymbolByAddress:theAddy])
+    // dyld helpers, Obj-C methods, nlists and saved thunks.
+    if ([self isFunctionStart:inLine->info.address])
         return YES;
 
     // If otool gave us a function name, but it came from a dynamic symbol...
     if (inLine->prev && !inLine->prev->info.isCode)
         return YES;
 
-    // Check for saved thunks.
-    if (iThunks)
-    {
-        uint32_t  i;
-
-        for (i = 0; i < iNumThunks; i++)
-        {
-            if (iThunks[i].address == theAddy)
-                return YES;
-        }
-    }
+    // LC_FUNCTION_STARTS lists them all, no need to guess.
+    if (iFuncStartsSize)
+        return NO;
 
     // Obvious avenues expended, brute force check now.
     BOOL isFunction  = NO;
@@ -2213,17 +2344,100 @@
     return IS_JUMP(opcode, opcode2);
 }
 
-//  gatherFuncInfos
+//  codeIsCall:
+// ----------------------------------------------------------------------------
+
+- (BOOL)codeIsCall: (UInt8*)inCode
+{
+    UInt8 opcode = inCode[0];
+    UInt8 opcode2 = inCode[1];
+
+    return IS_CALL(opcode) ||
+        (opcode == 0xff && (OPEXT(opcode2) == 2 || OPEXT(opcode2) == 3));
+}
+
+//  getBranchInfo:forLine:
+// ----------------------------------------------------------------------------
+//  Return YES if inLine ends a basic block, and describe where control goes
+//  from there.
+
+- (BOOL)getBranchInfo: (BranchInfo*)outInfo
+              forLine: (Line*)inLine
+{
+    UInt8   opcode  = inLine->info.code[0];
+    UInt8   opcode2 = inLine->info.code[1];
+    SInt32  rel32;
+
+    *outInfo    = (BranchInfo){0, NO, NO};
+
+    if ((opcode >= 0x70 && opcode <= 0x7f) || opcode == 0xe3)
+    {   // jcc rel8, jecxz
+        outInfo->target         = inLine->info.address + 2 + (SInt8)opcode2;
+        outInfo->hasTarget      = YES;
+        outInfo->fallsThrough   = YES;
+    }
+    else if (opcode == 0xeb)
+    {   // jmp rel8
+        outInfo->target     = inLine->info.address + 2 + (SInt8)opcode2;
+        outInfo->hasTarget  = YES;
+    }
+    else if (opcode == 0xe9)
+    {   // jmp rel32
+        rel32   = OSSwapLittleToHostInt32(*(SInt32*)&inLine->info.code[1]);
+        outInfo->target     = inLine->info.address + 5 + rel32;
+        outInfo->hasTarget  = YES;
+    }
+    else if (opcode == 0x0f && opcode2 >= 0x80 && opcode2 <= 0x8f)
+    {   // jcc rel32
+        rel32   = OSSwapLittleToHostInt32(*(SInt32*)&inLine->info.code[2]);
+        outInfo->target         = inLine->info.address + 6 + rel32;
+        outInfo->hasTarget      = YES;
+        outInfo->fallsThrough   = YES;
+    }
+    else if (opcode == 0xff && (OPEXT(opcode2) == 4 || OPEXT(opcode2) == 5))
+        ;   // indirect jmp
+    else if (!IS_RET(opcode) && opcode != 0xc2 &&
+        !(opcode == 0xf3 && IS_RET(opcode2)))   // ret, ret imm16, rep ret
+        return NO;
+
+    return YES;
+}
+
+//  getCallTarget:forLine:
+// ----------------------------------------------------------------------------
+//  Return YES if inLine is a direct call, with the address it calls. Calls
+//  to the next instruction only push the PC.
+
+- (BOOL)getCallTarget: (uint32_t*)outTarget
+              forLine: (Line*)inLine
+{
+    if (inLine->info.code[0] != 0xe8)   // call rel32
+        return NO;
+
+    SInt32  rel32   = OSSwapLittleToHostInt32(*(SInt32*)&inLine->info.code[1]);
+
+    if (!rel32)
+        return NO;
+
+    *outTarget  = inLine->info.address + 5 + rel32;
+
+    return YES;
+}
+
+//  gatherFuncInfosFrom:to:
 // ----------------------------------------------------------------------------
+//  Gather block info for the lines from inStartLine up to, but not
+//  including, inEndLine. A NULL inEndLine means the end of the list.
 
-- (void)gatherFuncInfos
+- (void)gatherFuncInfosFrom: (Line*)inStartLine
+                         to: (Line*)inEndLine
 {
-    Line*           theLine     = iPlainLineListHead;
+    Line*           theLine     = inStartLine;
     UInt8           opcode, opcode2;
     uint32_t          progCounter = 0;
 
     // Loop thru lines.
-    while (theLine)
+    while (theLine && theLine != inEndLine)
     {
         if (!(progCounter % (PROGRESS_FREQ * 5)))
         {
@@ -2244,9 +2458,16 @@
         {
             iCurrentFuncPtr = theLine->info.address;
             [self resetRegisters:theLine];
+            iBlockVisits++;
         }
         else
         {
+            // Count every entry into a block for the -debug summary.
+            if (theLine->info.startsBlock && iCurrentFuncInfoIndex >= 0 &&
+                [self findBlockAtAddress: theLine->info.address
+                inFunction: &iFuncInfos[iCurrentFuncInfoIndex]])
+                iBlockVisits++;
+
             [self restoreRegisters:theLine];
             [self updateRegisters:theLine];
 
@@ -2307,20 +2528,11 @@
             BlockInfo*  currentBlock    = NULL;
             Line*       endLine         = NULL;
             BOOL        isEpilog        = NO;
-            uint32_t      i;
 
             if (funcInfo->blocks)
-            {   // Blocks exist, find 1st one matching this address.
-                // This is an exhaustive search, but the speed hit should
-                // only be an issue with extremely long functions.
-                for (i = 0; i < funcInfo->numBlocks; i++)
-                {
-                    if (funcInfo->blocks[i].beginAddress == jumpTarget)
-                    {
-                        currentBlock = &funcInfo->blocks[i];
-                        break;
-                    }
-                }
+            {   // Blocks exist, find the one matching this address.
+                currentBlock    = [self findBlockAtAddress: jumpTarget
+                    inFunction: funcInfo];
 
                 if (currentBlock)
                 {   // Determine if the target block is an epilog.
@@ -2368,65 +2580,37 @@
                     }
                 }
                 else
-                {   // No matching blocks found, so allocate a new one.
-                    funcInfo->numBlocks++;
-                    funcInfo->blocks = realloc(funcInfo->blocks,
-                        sizeof(BlockInfo) * funcInfo->numBlocks);
-                    currentBlock =
-                        &funcInfo->blocks[funcInfo->numBlocks - 1];
-                    *currentBlock = (BlockInfo){0};
+                {   // No matching blocks found, so add a new one.
+                    currentBlock    = [self addBlockAtAddress: jumpTarget
+                        toFunction: funcInfo];
                 }
             }
             else
-            {   // No existing blocks, allocate one.
-                funcInfo->numBlocks++;
-                funcInfo->blocks    = calloc(1, sizeof(BlockInfo));
-                currentBlock        = funcInfo->blocks;
+            {   // No existing blocks, add one.
+                currentBlock    = [self addBlockAtAddress: jumpTarget
+                    toFunction: funcInfo];
             }
 
             // sanity check
             if (!currentBlock)
             {
-                fprintf(stderr, "otx: [X86Processor gatherFuncInfos] "
+                fprintf(stderr, "otx: [X86Processor gatherFuncInfosFrom:to:] "
                     "currentBlock is NULL. Flame the dev.\n");
                 return;
             }
 
-            // Create a new MachineState.
-            GPRegisterInfo* savedRegs   = malloc(
-                sizeof(GPRegisterInfo) * 8);
-
-            memcpy(savedRegs, iRegInfos, sizeof(GPRegisterInfo) * 8);
-
-            VarInfo*    savedSelves = NULL;
-
-            if (iLocalSelves)
-            {
-                savedSelves = malloc(
-                    sizeof(VarInfo) * iNumLocalSelves);
-                memcpy(savedSelves, iLocalSelves,
-                    sizeof(VarInfo) * iNumLocalSelves);
-            }
-
-            VarInfo*    savedVars   = NULL;
-
-            if (iLocalVars)
-            {
-                savedVars   = malloc(
-                    sizeof(VarInfo) * iNumLocalVars);
-                memcpy(savedVars, iLocalVars,
-                    sizeof(VarInfo) * iNumLocalVars);
-            }
-
+            // Describe the current MachineState. updateBlock: copies it
+            // into the function's arena only if it's not already there.
             MachineState    machState   =
-                {savedRegs, savedSelves, iNumLocalSelves,
-                    savedVars, iNumLocalVars };
+                {iRegInfos, iLocalSelves, iNumLocalSelves,
+                    iLocalVars, iNumLocalVars};
 
             // Store the new BlockInfo.
             BlockInfo   blockInfo   =
                 {jumpTarget, endLine, isEpilog, machState};
 
-            memcpy(currentBlock, &blockInfo, sizeof(BlockInfo));
+            [self updateBlock: currentBlock withInfo: &blockInfo
+                fromLine: theLine numRegs: 8];
 #else
     // At this point, the x86 logic departs from the PPC logic. We seem
     // to get better results by not reusing blocks.
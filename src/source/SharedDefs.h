@@ -6,12 +6,28 @@
     This file is in the public domain.
 */
 
+// Values for ProcOptions.graphFormat
+enum {
+    NoGraph     = 0,
+    DOTGraph,               // g
+    JSONGraph               // G
+};
+
+// Values for ProcOptions.recordFormat
+enum {
+    NoRecords   = 0,
+    JSONLRecords,           // -records jsonl
+    ColumnarRecords         // -records columnar
+};
+
 /*  ProcOptions
 
     Options for processing executables. GUI target sets these using
     NSUserDefaults, CLI target sets them with command line arguments. This
     is necessary for the CLI target to behave consistently across
-    invocations, and to keep it from altering the GUI target's prefs.
+    invocations, and to keep it from altering the GUI target's prefs. New
+    fields that change the output must be added to the CLI's -cache key, see
+    -[CLIController resultCacheKey:].
 */
 typedef struct
 {                                   // CLI flags
@@ -26,6 +42,20 @@ typedef struct
     BOOL    returnTypes;            // r
     BOOL    variableTypes;          // v
     BOOL    returnStatements;       // R
+    BOOL    streamOutput;           // s
+    BOOL    parallelize;            // j
+    UInt8   graphFormat;            // g, G
     BOOL    debugMode;              // -debug
+    char*   xrefIndexPath;          // -xref
+    char*   functionName;           // -f
+    UInt64  rangeStart;             // -a
+    UInt64  rangeEnd;               // -a, exclusive
+    char*   demangleCachePath;      // -demangle-cache
+    UInt8   recordFormat;           // -records
+    BOOL    compressOutput;         // z
+    char*   tocPath;                // -toc
+    char*   splitPath;              // -split
+    BOOL    sha256Checksum;         // -sha256
+    char*   incrementalPath;        // -incremental
 }
 ProcOptions;
@@ -13,6 +13,11 @@
     #import <Cocoa/Cocoa.h>
 #endif
 
+#import <CommonCrypto/CommonDigest.h>
+#import <dirent.h>
+#import <dispatch/dispatch.h>
+#import <fcntl.h>
+#import <libkern/OSAtomic.h>
 #import <libkern/OSByteOrder.h>
 #import <mach/machine.h>
 #import <mach-o/arch.h>
@@ -21,10 +26,16 @@
 #import <mach-o/nlist.h>
 #import <mach-o/swap.h>
 #import <objc/objc-runtime.h>
+#import <pthread.h>
+#import <sys/file.h>
+#import <sys/mman.h>
 #import <sys/param.h>
 #import <sys/ptrace.h>
+#import <sys/stat.h>
 #import <sys/syscall.h>
+#import <sys/time.h>
 #import <sys/types.h>
+#import <zlib.h>
 
 #define fat_header          struct fat_header
 #define fat_arch            struct fat_arch
@@ -35,11 +46,16 @@
 #define segment_command_64  struct segment_command_64
 #define symtab_command      struct symtab_command
 #define dysymtab_command    struct dysymtab_command
+#define linkedit_data_command   struct linkedit_data_command
 #define nlist               struct nlist
 #define nlist_64            struct nlist_64
 #define section             struct section
 #define section_64          struct section_64
 
+#ifndef LC_FUNCTION_STARTS
+#define LC_FUNCTION_STARTS  0x26    // 10.7 SDK
+#endif
+
 // carpal tunnel inhibitors
 #define UTF8STRING(s)   [(s) UTF8String]
 #define NSSTRING(s)     [NSString stringWithUTF8String: (s)]